@@ -114,6 +114,20 @@ AX_S32 AX_SKEL_RegisterResultCallback(AX_SKEL_HANDLE handle, AX_SKEL_RESULT_CALL
 //////////////////////////////////////////////////////////////////////////////////////
 AX_S32 AX_SKEL_SendFrame(AX_SKEL_HANDLE handle, const AX_SKEL_FRAME_T *pstFrame, AX_S32 nTimeout);
 
+//////////////////////////////////////////////////////////////////////////////////////
+/// @brief send frames in a batch, e.g. one frame of every stream. the frames go in
+///        together if they fit in nTimeout, otherwise the leading *pnSent of them
+///
+/// @param pHandle    [I]: handle
+/// @param pstFrames  [I]: frames, nFrameNum entries
+/// @param nFrameNum  [I]: frame num
+/// @param pnSent     [O]: leading frames sent
+/// @param nTimeout   [I]: timeout
+///
+/// @return 0 if all sent, otherwise failure
+//////////////////////////////////////////////////////////////////////////////////////
+AX_S32 AX_SKEL_SendFrames(AX_SKEL_HANDLE handle, const AX_SKEL_FRAME_T *pstFrames, AX_U32 nFrameNum, AX_U32 *pnSent, AX_S32 nTimeout);
+
 //////////////////////////////////////////////////////////////////////////////////////
 /// @brief process image
 ///
@@ -126,7 +140,52 @@ AX_S32 AX_SKEL_SendFrame(AX_SKEL_HANDLE handle, const AX_SKEL_FRAME_T *pstFrame,
 AX_S32 AX_SKEL_GetResult(AX_SKEL_HANDLE handle, AX_SKEL_RESULT_T **ppstResult, AX_S32 nTimeout);
 
 //////////////////////////////////////////////////////////////////////////////////////
-/// @brief free memory
+/// @brief get results in a batch, waits nTimeout for the first one and then takes
+///        what is ready up to nCapacity. each result is AX_SKEL_Release-d on its own
+///
+/// @param pHandle     [I]: handle
+/// @param ppstResults [O]: algorithm results, nCapacity entries
+/// @param nCapacity   [I]: max results
+/// @param pCount      [O]: results got
+/// @param nTimeout    [I]: timeout of the first result
+///
+/// @return 0 if success, otherwise failure
+//////////////////////////////////////////////////////////////////////////////////////
+AX_S32 AX_SKEL_GetResults(AX_SKEL_HANDLE handle, AX_SKEL_RESULT_T **ppstResults, AX_U32 nCapacity, AX_U32 *pCount, AX_S32 nTimeout);
+
+//////////////////////////////////////////////////////////////////////////////////////
+/// @brief open stream, frames of a closed stream are accepted again
+///
+/// @param pHandle    [I]: handle
+/// @param nStreamId  [I]: stream id
+///
+/// @return 0 if success, otherwise failure
+//////////////////////////////////////////////////////////////////////////////////////
+AX_S32 AX_SKEL_OpenStream(AX_SKEL_HANDLE handle, AX_U32 nStreamId);
+
+//////////////////////////////////////////////////////////////////////////////////////
+/// @brief close stream, release all tracks, cached frames and queued frames of the stream
+///
+/// @param pHandle    [I]: handle
+/// @param nStreamId  [I]: stream id
+///
+/// @return 0 if success, otherwise failure
+//////////////////////////////////////////////////////////////////////////////////////
+AX_S32 AX_SKEL_CloseStream(AX_SKEL_HANDLE handle, AX_U32 nStreamId);
+
+//////////////////////////////////////////////////////////////////////////////////////
+/// @brief get the running counters of the handle
+///
+/// @param pHandle        [I]: handle
+/// @param pstStatistics  [O]: counters
+///
+/// @return 0 if success, otherwise failure
+//////////////////////////////////////////////////////////////////////////////////////
+AX_S32 AX_SKEL_GetStatistics(AX_SKEL_HANDLE handle, AX_SKEL_STATISTICS_T *pstStatistics);
+
+//////////////////////////////////////////////////////////////////////////////////////
+/// @brief free memory, a result is released exactly once. releasing it again, or a
+///        pointer not got from AX_SKEL_GetResult(s), is undefined
 ///
 /// @param p           [I]: memory address
 ///
@@ -198,6 +198,15 @@ typedef struct axSKEL_VERSION_INFO_T {
     AX_VOID *pPrivate;
 } AX_SKEL_VERSION_INFO_T;
 
+/// @brief running counters of a handle, see AX_SKEL_GetStatistics
+typedef struct axSKEL_STATISTICS_T {
+    AX_U64 nCallbackDropped;            // results dropped while callback_drop is on
+    AX_U32 nFrameCachePinned;           // frames pinned by the push cache of the handle
+    AX_U32 nFrameCachePinnedGlobal;     // frames pinned by the push caches of all handles of the process
+    AX_U64 nPushBytesPerSec;            // push jpeg bytes of the last second
+    AX_U64 nPushEncodeDropped;          // pushes not encoded, the encode queue was full
+} AX_SKEL_STATISTICS_T;
+
 /// @brief handle definition
 typedef AX_VOID *AX_SKEL_HANDLE;
 
@@ -221,6 +230,17 @@ typedef struct axSKEL_COMMON_THRESHOLD_CONFIG_T {
 // cmd: "push_bind_enable", value_type: AX_SKEL_COMMON_THRESHOLD_CONFIG_T *
 // cmd: "track_disable", value_type: AX_SKEL_COMMON_THRESHOLD_CONFIG_T *
 // cmd: "push_disable", value_type: AX_SKEL_COMMON_THRESHOLD_CONFIG_T *
+// cmd: "track_worker_num", value_type: AX_SKEL_COMMON_THRESHOLD_CONFIG_T *   // [1, 8], only valid on create
+// cmd: "push_encode_worker_num", value_type: AX_SKEL_COMMON_THRESHOLD_CONFIG_T *   // [1, 4], threads encoding the pushes, only valid before the first push
+// cmd: "callback_worker_num", value_type: AX_SKEL_COMMON_THRESHOLD_CONFIG_T *    // [1, 8], threads running the result callback, only valid on create
+// cmd: "callback_queue_depth", value_type: AX_SKEL_COMMON_THRESHOLD_CONFIG_T *   // >= 1, results waiting for the callback per thread, only valid on create
+// cmd: "callback_drop", value_type: AX_SKEL_COMMON_THRESHOLD_CONFIG_T *  // 0: wait for the callback (default), 1: drop a result when it is behind
+// cmd: "frame_cache_budget", value_type: AX_SKEL_COMMON_THRESHOLD_CONFIG_T *     // max frames pinned by the push cache of the handle, 0: no limit (default)
+// cmd: "frame_cache_copy", value_type: AX_SKEL_COMMON_THRESHOLD_CONFIG_T *   // 1: best mode caches private copies of the objects instead of the frames
+// cmd: "push_byte_rate", value_type: AX_SKEL_COMMON_THRESHOLD_CONFIG_T *     // push jpeg bytes/s the quality adapts to, 0: crop_encoder_qpLevel always (default)
+// cmd: "detect_interval", value_type: AX_SKEL_COMMON_THRESHOLD_CONFIG_T *    // [1, 30], detect every N frames per stream, others are kalman predicted
+// cmd: "track_match_mode", value_type: AX_SKEL_COMMON_THRESHOLD_CONFIG_T *    // 0: lapjv (default), 1: greedy, for dense scenes
+// cmd: "track_match_conflict_ratio", value_type: AX_SKEL_COMMON_THRESHOLD_CONFIG_T *    // [0, 1], greedy falls back to lapjv above this ratio of ambiguous matches
 
 /// @brief object size filter config
 typedef struct axSKEL_OBJECT_SIZE_FILTER_CONFIG_T {
@@ -303,8 +323,8 @@ typedef struct axSKEL_CROP_ENCODER_THRESHOLD_CONFIG_T {
 
 /// @brief Reszie panorama config
 typedef struct axSKEL_RESIZE_CONFIG_T {
-    AX_F32 fW;
-    AX_F32 fH;
+    AX_F32 fW;  // (0, 1]: ratio of the frame width, > 1: width in pixels, 0: no limit
+    AX_F32 fH;  // as fW, the frame aspect is kept and the panorama is never upscaled
 } AX_SKEL_RESIZE_CONFIG_T;
 // cmd:"resize_panorama_encoder_config",  value_type: AX_SKEL_RESIZE_CONFIG *
 
@@ -11,10 +11,11 @@
 
 #include "mgr/model_mgr.h"
 #include "mgr/ppl_mgr.h"
-#include "mgr/mem_mgr.h"
 
 #include "utils/logger.h"
 #include "utils/checker.h"
+#include "utils/jenc.h"
+#include "utils/result_pool.h"
 
 #include "api/ax_skel_version.h"
 
@@ -28,8 +29,16 @@
 
 static AX_SKEL_VERSION_INFO_T g_axSkelVersionInfo = {0};
 
-static std::mutex gSkelApiMutex;
-#define DECLARE_SKEL_THREAD_SAFE_API std::lock_guard<std::mutex> _ApiLck(gSkelApiMutex);
+// calls on one handle take its reference, calls on different handles never contend
+#define DECLARE_SKEL_HANDLE(handle, ppl)                    \
+    skel::PipelineRef ppl(handle);                          \
+    if (!ppl) {                                             \
+        ALOGE("invalid handle %p\n", handle);               \
+        return AX_ERR_SKEL_INVALID_HANDLE;                  \
+    }
+
+// config calls of one handle are serialized
+#define DECLARE_SKEL_HANDLE_SAFE_API(ppl) std::lock_guard<std::mutex> _HandleLck(ppl.Mutex());
 
 //////////////////////////////////////////////////////////////////////////////////////
 /// @brief Initialize skel sdk
@@ -88,8 +97,6 @@ SKEL_API AX_S32 AX_SKEL_DeInit() {
 /// @return version info
 //////////////////////////////////////////////////////////////////////////////////////
 SKEL_API AX_S32 AX_SKEL_GetCapability(const AX_SKEL_CAPABILITY_T **ppstCapability) {
-    DECLARE_SKEL_THREAD_SAFE_API
-
     CHECK_INITED(MODELMGR);
     CHECK_INITED(PPLMGR);
 
@@ -104,13 +111,16 @@ SKEL_API AX_S32 AX_SKEL_GetCapability(const AX_SKEL_CAPABILITY_T **ppstCapabilit
 /// @return version info
 //////////////////////////////////////////////////////////////////////////////////////
 SKEL_API AX_S32 AX_SKEL_GetVersion(const AX_SKEL_VERSION_INFO_T **ppstVersion) {
-    DECLARE_SKEL_THREAD_SAFE_API
+    static std::mutex s_mtxVersion;
 
     CHECK_PTR(ppstVersion);
 
-    if (g_axSkelVersionInfo.pstrVersion == nullptr) {
-        g_axSkelVersionInfo.pstrVersion = (char*)malloc(AX_SKEL_VERSION_MAXLEN);
-        strncpy(g_axSkelVersionInfo.pstrVersion, AX_SKEL_VERSION, AX_SKEL_VERSION_MAXLEN);
+    {
+        std::lock_guard<std::mutex> lck(s_mtxVersion);
+        if (g_axSkelVersionInfo.pstrVersion == nullptr) {
+            g_axSkelVersionInfo.pstrVersion = (char*)malloc(AX_SKEL_VERSION_MAXLEN);
+            strncpy(g_axSkelVersionInfo.pstrVersion, AX_SKEL_VERSION, AX_SKEL_VERSION_MAXLEN);
+        }
     }
 
     *ppstVersion = &g_axSkelVersionInfo;
@@ -127,12 +137,11 @@ SKEL_API AX_S32 AX_SKEL_GetVersion(const AX_SKEL_VERSION_INFO_T **ppstVersion) {
 /// @return 0 if success, otherwise failure
 //////////////////////////////////////////////////////////////////////////////////////
 SKEL_API AX_S32 AX_SKEL_Create(const AX_SKEL_HANDLE_PARAM_T *pstParam, AX_SKEL_HANDLE *pHandle) {
-    DECLARE_SKEL_THREAD_SAFE_API
-
     CHECK_INITED(MODELMGR);
     CHECK_INITED(PPLMGR);
 
     CHECK_PTR(pstParam);
+    CHECK_PTR(pHandle);
 
     AX_S32 ret = PPLMGR->Create(pstParam, pHandle);
     if (AX_SKEL_SUCC != ret) {
@@ -151,8 +160,6 @@ SKEL_API AX_S32 AX_SKEL_Create(const AX_SKEL_HANDLE_PARAM_T *pstParam, AX_SKEL_H
 /// @return 0 if success, otherwise failure
 //////////////////////////////////////////////////////////////////////////////////////
 SKEL_API AX_S32 AX_SKEL_Destroy(AX_SKEL_HANDLE handle) {
-    DECLARE_SKEL_THREAD_SAFE_API
-
     CHECK_INITED(PPLMGR);
     CHECK_PTR(handle);
 
@@ -167,13 +174,11 @@ SKEL_API AX_S32 AX_SKEL_Destroy(AX_SKEL_HANDLE handle) {
 /// @return version info
 //////////////////////////////////////////////////////////////////////////////////////
 SKEL_API AX_S32 AX_SKEL_GetConfig(AX_SKEL_HANDLE handle, const AX_SKEL_CONFIG_T **ppstConfig) {
-    DECLARE_SKEL_THREAD_SAFE_API
-
     CHECK_INITED(PPLMGR);
-    CHECK_PTR(handle);
     CHECK_PTR(ppstConfig);
 
-    auto* ppl = (skel::ppl::PipelineBase*)handle;
+    DECLARE_SKEL_HANDLE(handle, ppl)
+    DECLARE_SKEL_HANDLE_SAFE_API(ppl)
     return ppl->GetConfig(ppstConfig);
 }
 
@@ -185,16 +190,30 @@ SKEL_API AX_S32 AX_SKEL_GetConfig(AX_SKEL_HANDLE handle, const AX_SKEL_CONFIG_T
 /// @return version info
 //////////////////////////////////////////////////////////////////////////////////////
 SKEL_API AX_S32 AX_SKEL_SetConfig(AX_SKEL_HANDLE handle, const AX_SKEL_CONFIG_T *pstConfig) {
-    DECLARE_SKEL_THREAD_SAFE_API
-
     CHECK_INITED(PPLMGR);
-    CHECK_PTR(handle);
     CHECK_PTR(pstConfig);
 
-    auto* ppl = (skel::ppl::PipelineBase*)handle;
+    DECLARE_SKEL_HANDLE(handle, ppl)
+    DECLARE_SKEL_HANDLE_SAFE_API(ppl)
     return ppl->SetConfig(pstConfig);
 }
 
+//////////////////////////////////////////////////////////////////////////////////////
+/// @brief get the running counters of the handle
+///
+/// @param pstStatistics       [O]: counters
+///
+/// @return 0 if success, otherwise failure
+//////////////////////////////////////////////////////////////////////////////////////
+SKEL_API AX_S32 AX_SKEL_GetStatistics(AX_SKEL_HANDLE handle, AX_SKEL_STATISTICS_T *pstStatistics) {
+    CHECK_INITED(PPLMGR);
+    CHECK_PTR(pstStatistics);
+
+    DECLARE_SKEL_HANDLE(handle, ppl)
+    DECLARE_SKEL_HANDLE_SAFE_API(ppl)
+    return ppl->GetStatistics(pstStatistics);
+}
+
 //////////////////////////////////////////////////////////////////////////////////////
 /// @brief register get algorithm result callback
 ///
@@ -205,13 +224,11 @@ SKEL_API AX_S32 AX_SKEL_SetConfig(AX_SKEL_HANDLE handle, const AX_SKEL_CONFIG_T
 /// @return 0 if success, otherwise failure
 //////////////////////////////////////////////////////////////////////////////////////
 SKEL_API AX_S32 AX_SKEL_RegisterResultCallback(AX_SKEL_HANDLE handle, AX_SKEL_RESULT_CALLBACK_FUNC callback, AX_VOID *pUserData) {
-    DECLARE_SKEL_THREAD_SAFE_API
-
     CHECK_INITED(PPLMGR);
-    CHECK_PTR(handle);
     CHECK_PTR(callback);
 
-    auto* ppl = (skel::ppl::PipelineBase*)handle;
+    DECLARE_SKEL_HANDLE(handle, ppl)
+    DECLARE_SKEL_HANDLE_SAFE_API(ppl)
     return ppl->RegisterResultCallback(callback, pUserData);
 }
 
@@ -226,13 +243,38 @@ SKEL_API AX_S32 AX_SKEL_RegisterResultCallback(AX_SKEL_HANDLE handle, AX_SKEL_RE
 //////////////////////////////////////////////////////////////////////////////////////
 SKEL_API AX_S32 AX_SKEL_SendFrame(AX_SKEL_HANDLE handle, const AX_SKEL_FRAME_T *pstFrame, AX_S32 nTimeout) {
     CHECK_INITED(PPLMGR);
-    CHECK_PTR(handle);
     CHECK_PTR(pstFrame);
 
-    auto* ppl = (skel::ppl::PipelineBase*)handle;
+    DECLARE_SKEL_HANDLE(handle, ppl)
     return ppl->SendFrame(pstFrame, nTimeout);
 }
 
+//////////////////////////////////////////////////////////////////////////////////////
+/// @brief send frames in a batch
+///
+/// @param pHandle    [I]: handle
+/// @param pstFrames  [I]: frames, nFrameNum entries
+/// @param nFrameNum  [I]: frame num
+/// @param pnSent     [O]: leading frames sent
+/// @param nTimeout   [I]: timeout
+///
+/// @return 0 if all sent, otherwise failure
+//////////////////////////////////////////////////////////////////////////////////////
+SKEL_API AX_S32 AX_SKEL_SendFrames(AX_SKEL_HANDLE handle, const AX_SKEL_FRAME_T *pstFrames, AX_U32 nFrameNum, AX_U32 *pnSent, AX_S32 nTimeout) {
+    CHECK_INITED(PPLMGR);
+    CHECK_PTR(pstFrames);
+    CHECK_PTR(pnSent);
+
+    *pnSent = 0;
+    if (nFrameNum == 0) {
+        ALOGE("nFrameNum is 0\n");
+        return AX_ERR_SKEL_ILLEGAL_PARAM;
+    }
+
+    DECLARE_SKEL_HANDLE(handle, ppl)
+    return ppl->SendFrames(pstFrames, nFrameNum, pnSent, nTimeout);
+}
+
 //////////////////////////////////////////////////////////////////////////////////////
 /// @brief process image
 ///
@@ -244,17 +286,76 @@ SKEL_API AX_S32 AX_SKEL_SendFrame(AX_SKEL_HANDLE handle, const AX_SKEL_FRAME_T *
 //////////////////////////////////////////////////////////////////////////////////////
 SKEL_API AX_S32 AX_SKEL_GetResult(AX_SKEL_HANDLE handle, AX_SKEL_RESULT_T **ppstResult, AX_S32 nTimeout) {
     CHECK_INITED(PPLMGR);
-    CHECK_PTR(handle);
     CHECK_PTR(ppstResult);
 
-    auto* ppl = (skel::ppl::PipelineBase*)handle;
+    DECLARE_SKEL_HANDLE(handle, ppl)
     AX_S32 ret = ppl->GetResult(ppstResult, nTimeout);
     if (AX_SKEL_SUCC == ret) {
-        MEMMGR->Add(*ppstResult, AX_SKEL_MEM_RESULT);
+        skel::utils::ResultPool::GiveToUser(*ppstResult);
     }
     return ret;
 }
 
+//////////////////////////////////////////////////////////////////////////////////////
+/// @brief get results in a batch
+///
+/// @param pHandle     [I]: handle
+/// @param ppstResults [O]: algorithm results, nCapacity entries
+/// @param nCapacity   [I]: max results
+/// @param pCount      [O]: results got
+/// @param nTimeout    [I]: timeout of the first result
+///
+/// @return 0 if success, otherwise failure
+//////////////////////////////////////////////////////////////////////////////////////
+SKEL_API AX_S32 AX_SKEL_GetResults(AX_SKEL_HANDLE handle, AX_SKEL_RESULT_T **ppstResults, AX_U32 nCapacity, AX_U32 *pCount, AX_S32 nTimeout) {
+    CHECK_INITED(PPLMGR);
+    CHECK_PTR(ppstResults);
+    CHECK_PTR(pCount);
+
+    *pCount = 0;
+    if (nCapacity == 0) {
+        ALOGE("nCapacity is 0\n");
+        return AX_ERR_SKEL_ILLEGAL_PARAM;
+    }
+
+    DECLARE_SKEL_HANDLE(handle, ppl)
+    AX_S32 ret = ppl->GetResults(ppstResults, nCapacity, pCount, nTimeout);
+    for (AX_U32 i = 0; i < *pCount; i++) {
+        skel::utils::ResultPool::GiveToUser(ppstResults[i]);
+    }
+    return ret;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////
+/// @brief open stream
+///
+/// @param pHandle    [I]: handle
+/// @param nStreamId  [I]: stream id
+///
+/// @return 0 if success, otherwise failure
+//////////////////////////////////////////////////////////////////////////////////////
+SKEL_API AX_S32 AX_SKEL_OpenStream(AX_SKEL_HANDLE handle, AX_U32 nStreamId) {
+    CHECK_INITED(PPLMGR);
+
+    DECLARE_SKEL_HANDLE(handle, ppl)
+    return ppl->OpenStream(nStreamId);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////
+/// @brief close stream
+///
+/// @param pHandle    [I]: handle
+/// @param nStreamId  [I]: stream id
+///
+/// @return 0 if success, otherwise failure
+//////////////////////////////////////////////////////////////////////////////////////
+SKEL_API AX_S32 AX_SKEL_CloseStream(AX_SKEL_HANDLE handle, AX_U32 nStreamId) {
+    CHECK_INITED(PPLMGR);
+
+    DECLARE_SKEL_HANDLE(handle, ppl)
+    return ppl->CloseStream(nStreamId);
+}
+
 //////////////////////////////////////////////////////////////////////////////////////
 /// @brief free memory
 ///
@@ -265,26 +366,17 @@ SKEL_API AX_S32 AX_SKEL_GetResult(AX_SKEL_HANDLE handle, AX_SKEL_RESULT_T **ppst
 SKEL_API AX_S32 AX_SKEL_Release(AX_VOID *p) {
     CHECK_PTR(p);
 
-    SKEL_MEM_TYPE mem_type;
-    if (MEMMGR->Find(p, mem_type)) {
-        if (mem_type == AX_SKEL_MEM_RESULT) {
-            auto* result = (AX_SKEL_RESULT_T*)p;
-            if (result->nObjectSize > 0) {
-                for (int i = 0; i < result->nObjectSize; i++) {
-                    if (result->pstObjectItems[i].pstPointSet) {
-                        free(result->pstObjectItems[i].pstPointSet);
-                    }
-                }
-                free(result->pstObjectItems);
-            }
-            if (result->nCacheListSize > 0) {
-                free(result->pstCacheList);
-            }
-            free(result);
-        }
-
-        MEMMGR->Erase(p);
+    // the owner is in the header of the result. the check catches a result of a callback or one
+    // released twice while its block is still cached, it is no guarantee, see TakeFromUser
+    auto* result = skel::utils::ResultPool::TakeFromUser(p);
+    if (!result) {
+        ALOGW("%p is not a result to release\n", p);
+        return AX_SKEL_SUCC;
     }
 
+    // pushed jenc buffers, then one block with its items, point sets and cache list back to the pool of its handle
+    JENCOBJ->RelItems(result->pstObjectItems, result->nObjectSize);
+    skel::utils::ResultPool::Release(result);
+
     return AX_SKEL_SUCC;
 }
\ No newline at end of file
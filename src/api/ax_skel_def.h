@@ -45,6 +45,9 @@ const std::unordered_map<AX_SKEL_PPL_E, std::vector<std::string>> PipelineModelB
 #define DEFAULT_QPLEVEL_MAX 99
 #define DEFAULT_FRAME_DEPTH 1
 #define DEFAULT_FRAME_CACHE_DEPTH 1
+#define DEFAULT_FRAME_CACHE_BUDGET 0
+#define DEFAULT_PUSH_BYTE_RATE 0
+#define DEFAULT_PUSH_ENCODE_WORKER_NUM 1
 #define DEFAULT_POSE_BODY_COUNT 3
 #define DEFAULT_BODY_PROB_THRESHOLD 0.55
 #define DEFAULT_VEHICLE_PROB_THRESHOLD 0.5
@@ -70,8 +73,12 @@ typedef struct axSKEL_PARAM_T {
     AX_U32 nWidth;
     AX_U32 nHeight;
     AX_U32 nFrameCacheDepth;
+    AX_U32 nFrameCacheBudget;   // max frames pinned by the push cache of the handle, 0: no limit
+    AX_BOOL bFrameCacheCopy;    // best mode caches private copies of the objects instead of the frames
     AX_U32 nIoDepth;
     AX_F32 fCropEncoderQpLevel;
+    AX_U32 nPushByteRate;       // push jpeg bytes/s of the handle the Qfactor adapts to, 0: fCropEncoderQpLevel always
+    AX_U32 nPushEncodeWorkerNum;    // threads encoding the pushes, only valid before the first push
     AX_BOOL bPushBindEnable;
     AX_BOOL bTrackEnable;
     AX_BOOL bPushEnable;
@@ -92,8 +99,12 @@ typedef struct axSKEL_PARAM_T {
         nWidth = DEFAULT_SRC_H;
         nHeight = DEFAULT_SRC_W;
         nFrameCacheDepth = DEFAULT_FRAME_CACHE_DEPTH;
+        nFrameCacheBudget = DEFAULT_FRAME_CACHE_BUDGET;
+        bFrameCacheCopy = AX_FALSE;
         nIoDepth = 0;
         fCropEncoderQpLevel = DEFAULT_QPLEVEL;
+        nPushByteRate = DEFAULT_PUSH_BYTE_RATE;
+        nPushEncodeWorkerNum = DEFAULT_PUSH_ENCODE_WORKER_NUM;
         bPushBindEnable = AX_TRUE;
         bTrackEnable = AX_TRUE;
         bPushEnable = AX_TRUE;
@@ -18,6 +18,16 @@
 #include "pipeline/hvcfp/pipeline_hvcfp.h"
 
 #include <cstring>
+#include <thread>
+
+skel::PipelineMgr::PipelineMgr(AX_VOID):
+        m_hasInit(false),
+        m_pstCap(nullptr) {
+    // the lowest slots are handed out first
+    for (AX_U32 i = SKEL_HANDLE_MAX; i > 0; i--) {
+        m_vecFreeSlots.push_back(i - 1);
+    }
+}
 
 AX_S32 skel::PipelineMgr::Init(const AX_SKEL_INIT_PARAM_T *pstParam) {
     if (!MODELMGR->HasInit()) {
@@ -125,21 +135,79 @@ AX_S32 skel::PipelineMgr::Create(const AX_SKEL_HANDLE_PARAM_T *pstParam, AX_SKEL
     AX_S32 ret = ppl->Init(pstParam);
     if (AX_SKEL_SUCC != ret) {
         ALOGE("Pipeline %d init failed! ret = 0x%x\n", pstParam->ePPL, ret);
+        ppl->DeInit();
+        delete ppl;
         return AX_ERR_SKEL_ILLEGAL_PARAM;
     }
 
+    AX_U32 nIndex = 0;
+    {
+        std::lock_guard<std::mutex> lck(m_mtxSlots);
+        if (m_vecFreeSlots.empty()) {
+            ALOGE("Too many handles, at most %d\n", SKEL_HANDLE_MAX);
+            ppl->DeInit();
+            delete ppl;
+            return AX_ERR_SKEL_NOMEM;
+        }
+
+        nIndex = m_vecFreeSlots.back();
+        m_vecFreeSlots.pop_back();
+    }
+
+    // published by the odd generation, the pipeline is set before
+    AX_SKEL_HANDLE_SLOT_T &stSlot = m_stSlots[nIndex];
+    AX_U32 nGen = (stSlot.nGen + 1) & SKEL_HANDLE_GEN_MASK;
+    AX_SKEL_HANDLE handle = (AX_SKEL_HANDLE)(((uintptr_t)nGen << SKEL_HANDLE_INDEX_BITS) | (nIndex + 1));
+    ppl->SetHandle(handle);
+    stSlot.pPpl = ppl;
+
     ret = ppl->Start();
     if (AX_SKEL_SUCC != ret) {
         ALOGE("Pipeline %d start failed! ret = 0x%x\n", pstParam->ePPL, ret);
+        stSlot.pPpl = nullptr;
+        {
+            std::lock_guard<std::mutex> lck(m_mtxSlots);
+            m_vecFreeSlots.push_back(nIndex);
+        }
         delete ppl;
         return AX_ERR_SKEL_ILLEGAL_PARAM;
     }
 
-    *pHandle = (AX_SKEL_HANDLE)ppl;
+    stSlot.nGen = nGen;
+    *pHandle = handle;
 
     return AX_SKEL_SUCC;
 }
 
+skel::AX_SKEL_HANDLE_SLOT_T* skel::PipelineMgr::Slot(AX_SKEL_HANDLE handle, AX_U32 &nGen) {
+    uintptr_t nValue = (uintptr_t)handle;
+    uintptr_t nIndex = nValue & ((1 << SKEL_HANDLE_INDEX_BITS) - 1);
+
+    nGen = (AX_U32)(nValue >> SKEL_HANDLE_INDEX_BITS);
+    if (nIndex == 0 || nIndex > SKEL_HANDLE_MAX || (nGen & 1) == 0) {
+        return nullptr;
+    }
+
+    return &m_stSlots[nIndex - 1];
+}
+
+skel::AX_SKEL_HANDLE_SLOT_T* skel::PipelineMgr::Acquire(AX_SKEL_HANDLE handle) {
+    AX_U32 nGen = 0;
+    AX_SKEL_HANDLE_SLOT_T *pSlot = Slot(handle, nGen);
+    if (!pSlot) {
+        return nullptr;
+    }
+
+    // the reference is taken before the generation is checked, Destroy waits for it from then on
+    pSlot->nRef ++;
+    if (pSlot->nGen != nGen) {
+        pSlot->nRef --;
+        return nullptr;
+    }
+
+    return pSlot;
+}
+
 bool skel::PipelineMgr::IsPPLValid(AX_SKEL_PPL_E ppl_type) {
     if (m_pstCap->nPPLConfigSize == 0)  return false;
 
@@ -152,15 +220,40 @@ bool skel::PipelineMgr::IsPPLValid(AX_SKEL_PPL_E ppl_type) {
 }
 
 AX_S32 skel::PipelineMgr::Destroy(AX_SKEL_HANDLE handle) {
-    auto *ppl = (skel::ppl::PipelineBase *)handle;
+    AX_U32 nGen = 0;
+    AX_SKEL_HANDLE_SLOT_T *pSlot = Slot(handle, nGen);
+
+    // the handle is dead from here on, of racing Destroy calls one wins
+    if (!pSlot || !pSlot->nGen.compare_exchange_strong(nGen, (nGen + 1) & SKEL_HANDLE_GEN_MASK)) {
+        ALOGE("invalid handle %p\n", handle);
+        return AX_ERR_SKEL_INVALID_HANDLE;
+    }
 
+    auto *ppl = pSlot->pPpl;
+
+    // the queues are closed, calls blocked on them return
     ppl->Stop();
     ALOGI("Destroying pipeline...\n");
     std::this_thread::sleep_for(std::chrono::seconds(1));
 
-    ppl->DeInit();
+    // no call gets in any more, the ones in progress are waited for before anything is released
+    while (pSlot->nRef > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    {
+        std::lock_guard<std::mutex> lck(pSlot->mtx);
+        ppl->DeInit();
+    }
+
+    pSlot->pPpl = nullptr;
     delete ppl;
 
+    {
+        std::lock_guard<std::mutex> lck(m_mtxSlots);
+        m_vecFreeSlots.push_back((AX_U32)(pSlot - m_stSlots));
+    }
+
     return 0;
 }
 
@@ -17,12 +17,39 @@
 #include <unordered_map>
 #include <string>
 #include <vector>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
 
 #define PPLMGR skel::PipelineMgr::GetInstance()
 
+#define SKEL_HANDLE_MAX         256
+#define SKEL_HANDLE_INDEX_BITS  16
+// generations wrap within the bits of a handle above its index, 16 of them on 32 bits targets
+#define SKEL_HANDLE_GEN_MASK    ((AX_U32)(~(uintptr_t)0 >> SKEL_HANDLE_INDEX_BITS))
+
 typedef std::unordered_map<AX_SKEL_PPL_E, std::string>    PPL_ENUM_STR_MAP;
 
 namespace skel {
+    namespace ppl {
+        class PipelineBase;
+    }
+
+    // one entry of the handle table. a handle is its index and the generation it was created in,
+    // generations of live handles are odd and a destroyed handle never matches again
+    typedef struct axSKEL_HANDLE_SLOT_T {
+        std::atomic<AX_U32> nGen;
+        std::atomic<AX_U32> nRef;           // api calls in progress on the handle
+        ppl::PipelineBase *pPpl;
+        std::mutex mtx;                     // serializes the config calls of the handle
+
+        axSKEL_HANDLE_SLOT_T() {
+            nGen = 0;
+            nRef = 0;
+            pPpl = nullptr;
+        }
+    } AX_SKEL_HANDLE_SLOT_T;
+
     class PipelineMgr : public utils::CSingleton<PipelineMgr> {
         friend class utils::CSingleton<PipelineMgr>;
 
@@ -36,22 +63,63 @@ namespace skel {
 
         AX_S32 GetCapability(const AX_SKEL_CAPABILITY_T **ppstCapability);
         AX_S32 Create(const AX_SKEL_HANDLE_PARAM_T *pstParam, AX_SKEL_HANDLE *pHandle);
+        // waits for the calls in progress on the handle, other handles are not held up
         AX_S32 Destroy(AX_SKEL_HANDLE handle);
         bool IsPPLValid(AX_SKEL_PPL_E ppl_type);
 
-    private:
-        PipelineMgr(AX_VOID):
-                m_hasInit(false),
-                m_pstCap(nullptr) {
+        // the slot of a live handle with a reference taken, nullptr for a stale or bogus handle
+        AX_SKEL_HANDLE_SLOT_T* Acquire(AX_SKEL_HANDLE handle);
+        inline AX_VOID Release(AX_SKEL_HANDLE_SLOT_T *pSlot) {
+            pSlot->nRef --;
+        }
 
-                }
+    private:
+        PipelineMgr(AX_VOID);
         ~PipelineMgr(AX_VOID) override = default;
 
         void free_cap();
+        AX_SKEL_HANDLE_SLOT_T* Slot(AX_SKEL_HANDLE handle, AX_U32 &nGen);
 
     private:
         bool m_hasInit;
         AX_SKEL_CAPABILITY_T *m_pstCap;
+        std::mutex m_mtxSlots;                  // guards the free list, taken by Create and Destroy only
+        std::vector<AX_U32> m_vecFreeSlots;
+        AX_SKEL_HANDLE_SLOT_T m_stSlots[SKEL_HANDLE_MAX];
+    };
+
+    // an api call on a handle, the pipeline is not destroyed while it is held
+    class PipelineRef {
+    public:
+        explicit PipelineRef(AX_SKEL_HANDLE handle) :
+                m_pSlot(PPLMGR->Acquire(handle)) {
+
+        }
+
+        ~PipelineRef() {
+            if (m_pSlot) {
+                PPLMGR->Release(m_pSlot);
+            }
+        }
+
+        // un-copyable or moveable
+        PipelineRef(const PipelineRef&) = delete;
+        PipelineRef& operator = (const PipelineRef&) = delete;
+
+        explicit operator bool() const {
+            return m_pSlot != nullptr;
+        }
+
+        ppl::PipelineBase* operator -> () const {
+            return m_pSlot->pPpl;
+        }
+
+        std::mutex& Mutex() const {
+            return m_pSlot->mtx;
+        }
+
+    private:
+        AX_SKEL_HANDLE_SLOT_T *m_pSlot;
     };
 }
 
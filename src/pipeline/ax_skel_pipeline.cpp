@@ -12,6 +12,23 @@
 
 #include <stdlib.h>
 #include <thread>
+#include <chrono>
+
+// the queued copy of a user frame, the video frame is referenced until the copy is freed
+static AX_SKEL_FRAME_T* CopyFrame(const AX_SKEL_FRAME_T *pstFrame) {
+    auto *pstNewFrame = (AX_SKEL_FRAME_T*)malloc(sizeof(AX_SKEL_FRAME_T));
+    if (!pstNewFrame) {
+        return nullptr;
+    }
+
+    pstNewFrame->nFrameId = pstFrame->nFrameId;
+    pstNewFrame->nStreamId = pstFrame->nStreamId;
+    pstNewFrame->pUserData = pstFrame->pUserData;
+    memcpy(&pstNewFrame->stFrame, &pstFrame->stFrame, sizeof(AX_VIDEO_FRAME_T));
+    skel::utils::IncFrameRefCnt(*pstNewFrame);
+
+    return pstNewFrame;
+}
 
 AX_S32 skel::ppl::PipelineBase::SendFrame(const AX_SKEL_FRAME_T *pstFrame, AX_S32 nTimeout) {
     AX_S32 ret = AX_SKEL_SUCC;
@@ -23,23 +40,106 @@ AX_S32 skel::ppl::PipelineBase::SendFrame(const AX_SKEL_FRAME_T *pstFrame, AX_S3
         ALOGD("origin size fallback to %d %d\n", m_originSize[0], m_originSize[1]);
     }
 
-    auto *pstNewFrame = (AX_SKEL_FRAME_T*)malloc(sizeof(AX_SKEL_FRAME_T));
-    pstNewFrame->nFrameId = pstFrame->nFrameId;
-    pstNewFrame->nStreamId = pstFrame->nStreamId;
-    pstNewFrame->pUserData = pstFrame->pUserData;
-    memcpy(&pstNewFrame->stFrame, &pstFrame->stFrame, sizeof(AX_VIDEO_FRAME_T));
-    utils::IncFrameRefCnt(*pstNewFrame);
+    auto *pstNewFrame = CopyFrame(pstFrame);
+    if (!pstNewFrame) {
+        ALOGE("malloc frame failed\n");
+        return AX_ERR_SKEL_NOMEM;
+    }
 
     ret = m_input_queue.Push(pstNewFrame, nTimeout);
     if (AX_SKEL_SUCC != ret) {
         ALOGE("Push frame failed! ret= 0x%x\n", ret);
-        free(pstNewFrame);
+        utils::FreeFrame(pstNewFrame);
         return ret;
     }
 
     return AX_SKEL_SUCC;
 }
 
+AX_S32 skel::ppl::PipelineBase::SendFrames(const AX_SKEL_FRAME_T *pstFrames, AX_U32 nFrameNum, AX_U32 *pnSent, AX_S32 nTimeout) {
+    AX_SKEL_FRAME_T *arrFrames[SKEL_SEND_FRAMES_CHUNK];
+    AX_S32 ret = AX_SKEL_SUCC;
+
+    *pnSent = 0;
+    if (m_originSize[0] == 0 || m_originSize[1] == 0) {
+        m_originSize[0] = pstFrames[0].stFrame.u32Height;
+        m_originSize[1] = pstFrames[0].stFrame.u32Width;
+
+        ALOGD("origin size fallback to %d %d\n", m_originSize[0], m_originSize[1]);
+    }
+
+    // a chunk of copies goes in with one lock, the leading ones that fit in nTimeout if not all.
+    // nTimeout is for the whole call
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(nTimeout > 0 ? nTimeout : 0);
+    while (*pnSent < nFrameNum && AX_SKEL_SUCC == ret) {
+        AX_S32 nChunkTimeout = nTimeout;
+        if (nTimeout > 0) {
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+            nChunkTimeout = (left > 0) ? (AX_S32)left : 0;
+        }
+
+        size_t nCopied = 0;
+        while (nCopied < SKEL_SEND_FRAMES_CHUNK && *pnSent + nCopied < nFrameNum) {
+            auto *pstNewFrame = CopyFrame(&pstFrames[*pnSent + nCopied]);
+            if (!pstNewFrame) {
+                ALOGE("malloc frame failed\n");
+                ret = AX_ERR_SKEL_NOMEM;
+                break;
+            }
+            arrFrames[nCopied++] = pstNewFrame;
+        }
+
+        size_t nPushed = 0;
+        if (nCopied > 0) {
+            AX_S32 nPushRet = m_input_queue.PushBatch(arrFrames, nCopied, nPushed, nChunkTimeout);
+            if (AX_SKEL_SUCC != nPushRet) {
+                ALOGE("Push frames failed! %d of %d pushed, ret= 0x%x\n", (AX_S32)(*pnSent + nPushed), nFrameNum, nPushRet);
+                ret = nPushRet;
+            }
+        }
+
+        for (size_t i = nPushed; i < nCopied; i++) {
+            utils::FreeFrame(arrFrames[i]);
+        }
+
+        *pnSent += (AX_U32)nPushed;
+    }
+
+    return ret;
+}
+
+AX_S32 skel::ppl::PipelineBase::GetResults(AX_SKEL_RESULT_T **ppstResults, AX_U32 nCapacity, AX_U32 *pCount, AX_S32 nTimeout) {
+    *pCount = 0;
+
+    AX_S32 ret = GetResult(&ppstResults[0], nTimeout);
+    if (AX_SKEL_SUCC != ret) {
+        return ret;
+    }
+
+    for (*pCount = 1; *pCount < nCapacity; (*pCount)++) {
+        if (AX_SKEL_SUCC != GetResult(&ppstResults[*pCount], 0)) {
+            break;
+        }
+    }
+
+    return AX_SKEL_SUCC;
+}
+
+AX_S32 skel::ppl::PipelineBase::OpenStream(AX_U32) {
+    ALOGE("Pipeline has no stream state, OpenStream is not supported\n");
+    return AX_ERR_SKEL_NOT_SUPPORT;
+}
+
+AX_S32 skel::ppl::PipelineBase::CloseStream(AX_U32) {
+    ALOGE("Pipeline has no stream state, CloseStream is not supported\n");
+    return AX_ERR_SKEL_NOT_SUPPORT;
+}
+
+AX_S32 skel::ppl::PipelineBase::GetStatistics(AX_SKEL_STATISTICS_T *pstStatistics) {
+    memset(pstStatistics, 0x00, sizeof(AX_SKEL_STATISTICS_T));
+    return AX_SKEL_SUCC;
+}
+
 AX_S32 skel::ppl::PipelineBase::RegisterResultCallback(AX_SKEL_RESULT_CALLBACK_FUNC callback, AX_VOID *pUserData) {
     if (m_callback) {
         ALOGE("Already registered callback\n");
@@ -67,16 +167,7 @@ AX_S32 skel::ppl::PipelineBase::Start() {
         }
     });
 
-    std::thread result_thread( [this] {
-        ALOGD("result thread start\n");
-        while (IsRunning()) {
-            if (m_callback)
-                ResultCallbackThread();
-        }
-    });
-
     run_thread.detach();
-    result_thread.detach();
 
     return AX_SKEL_SUCC;
 }
@@ -95,12 +186,6 @@ AX_S32 skel::ppl::PipelineBase::Run() {
 
 AX_VOID skel::ppl::PipelineBase::Stop() {
     m_isRunning = false;
-}
-
-AX_S32 skel::ppl::PipelineBase::ResultCallbackThread() {
-    // You should implement this function.
-
-    ALOGE("You shouldn't see this message, please implement ResultCallbackThread in your pipeline class.\n");
-    std::this_thread::sleep_for(std::chrono::seconds(60));
-    return 0;
+    // senders blocked on a full queue return
+    m_input_queue.Close();
 }
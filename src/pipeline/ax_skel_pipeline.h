@@ -18,6 +18,8 @@
 
 namespace skel {
     namespace ppl {
+        #define SKEL_SEND_FRAMES_CHUNK SKEL_DEFAULT_QUEUE_LEN     // frames copied and queued under one lock by SendFrames
+
         class PipelineBase {
         public:
             PipelineBase():
@@ -33,21 +35,35 @@ namespace skel {
             virtual AX_S32 GetConfig(const AX_SKEL_CONFIG_T **ppstConfig) = 0;
             virtual AX_S32 SetConfig(const AX_SKEL_CONFIG_T *pstConfig) = 0;
             virtual AX_S32 GetResult(AX_SKEL_RESULT_T **ppstResult, AX_S32 nTimeout) = 0;
+            // waits nTimeout for the first result, then takes what is ready up to nCapacity
+            virtual AX_S32 GetResults(AX_SKEL_RESULT_T **ppstResults, AX_U32 nCapacity, AX_U32 *pCount, AX_S32 nTimeout);
 
+            // the pipeline calls it with each result once registered, GetResult is not used any more
             virtual AX_S32 RegisterResultCallback(AX_SKEL_RESULT_CALLBACK_FUNC callback, AX_VOID *pUserData);
-            // Must implement this
-            virtual AX_S32 ResultCallbackThread();
             virtual AX_S32 SendFrame(const AX_SKEL_FRAME_T *pstFrame, AX_S32 nTimeout);
+            // the leading *pnSent frames are queued, all nFrameNum of them if success
+            virtual AX_S32 SendFrames(const AX_SKEL_FRAME_T *pstFrames, AX_U32 nFrameNum, AX_U32 *pnSent, AX_S32 nTimeout);
+            virtual AX_S32 OpenStream(AX_U32 nStreamId);
+            virtual AX_S32 CloseStream(AX_U32 nStreamId);
+            // counters the pipeline has none of are 0
+            virtual AX_S32 GetStatistics(AX_SKEL_STATISTICS_T *pstStatistics);
 
             virtual AX_S32 Start();
             // Must implement this
             virtual AX_S32 Run();
+            // closes the queues the api calls wait on, DeInit comes after the calls in progress are done
             virtual AX_VOID Stop();
             inline bool IsRunning() const {
                 return m_isRunning;
             }
 
+            // what the user knows the pipeline by, given to the callback
+            inline AX_VOID SetHandle(AX_SKEL_HANDLE handle) {
+                m_handle = handle;
+            }
+
         protected:
+            AX_SKEL_HANDLE m_handle{nullptr};
             AX_SKEL_HANDLE_PARAM_T m_stHandleParam;
             AX_SKEL_RESULT_CALLBACK_FUNC m_callback{nullptr};
             AX_VOID* m_userData{nullptr};
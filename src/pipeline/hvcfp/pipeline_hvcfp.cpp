@@ -11,9 +11,9 @@
 
 #include "utils/checker.h"
 #include "utils/config_util.h"
+#include "utils/jenc.h"
 
 #include "mgr/model_mgr.h"
-#include "mgr/mem_mgr.h"
 
 #include "ax_skel_api.h"
 
@@ -24,6 +24,7 @@ using namespace skel::tracker;
 using namespace skel::utils;
 
 static std::vector<std::string> HVCFP_CLASS_NAMES = {"body", "vehicle", "cycle", "plate"};
+static std::vector<AX_S32> HVCFP_CLASS_LABELS = LabelIndex(HVCFP_CLASS_NAMES);
 
 AX_S32 skel::ppl::PipelineHVCFP::Init(const AX_SKEL_HANDLE_PARAM_T *pstParam) {
     CHECK_PTR(pstParam);
@@ -43,22 +44,45 @@ AX_S32 skel::ppl::PipelineHVCFP::Init(const AX_SKEL_HANDLE_PARAM_T *pstParam) {
         return ret;
     }
 
+    ret = InitCallback();
+    if (AX_SKEL_SUCC != ret) {
+        ALOGE("Init callback failed!\n");
+        return ret;
+    }
+
     return AX_SKEL_SUCC;
 }
 
 AX_S32 skel::ppl::PipelineHVCFP::DeInit() {
     m_input_queue.Close();
+    m_track_workers.Stop();
+    // after the track workers, the results they dispatched are still called back
+    m_callback_workers.Stop();
     m_detect_result_queue.Close();
     m_track_result_queue.Close();
 
     m_detector.Release();
-    if (m_tracker_dealer)
-        delete m_tracker_dealer;
+    TrackerDealer *pDealer = m_tracker_dealer.exchange(nullptr);
+    if (pDealer) {
+        delete pDealer;
+    }
+    if (m_jenc_created) {
+        JENCOBJ->Destroy();
+        m_jenc_created = AX_FALSE;
+    }
     FreeConfig(m_pstApiConfig);
 
     return AX_SKEL_SUCC;
 }
 
+AX_VOID skel::ppl::PipelineHVCFP::Stop() {
+    PipelineBase::Stop();
+
+    // GetResult blocked on the queues returns
+    m_detect_result_queue.Close();
+    m_track_result_queue.Close();
+}
+
 AX_S32 skel::ppl::PipelineHVCFP::GetConfig(const AX_SKEL_CONFIG_T **ppstConfig) {
     if (m_pstApiConfig == nullptr)
     {
@@ -66,28 +90,117 @@ AX_S32 skel::ppl::PipelineHVCFP::GetConfig(const AX_SKEL_CONFIG_T **ppstConfig)
         memset(m_pstApiConfig, 0, sizeof(AX_SKEL_CONFIG_T));
     }
 
-    MakeConfig(m_pstApiConfig, "track_disable", m_config.track_disable);
-    MakeConfig(m_pstApiConfig, "push_disable", m_config.push_disable);
+    MakeConfig(m_pstApiConfig, "track_disable", m_config.track_disable.load());
+    MakeConfig(m_pstApiConfig, "push_disable", m_config.push_disable.load());
+    MakeConfig(m_pstApiConfig, "frame_cache_budget", (float)m_result_constrain.nFrameCacheBudget);
+    MakeConfig(m_pstApiConfig, "frame_cache_copy", m_config.frame_cache_copy);
+    MakeConfig(m_pstApiConfig, "push_byte_rate", (float)m_result_constrain.nPushByteRate);
+    MakeConfig(m_pstApiConfig, "push_encode_worker_num", (float)m_result_constrain.nPushEncodeWorkerNum);
+    MakeConfig(m_pstApiConfig, "callback_drop", m_config.callback_drop.load());
 
     *ppstConfig = m_pstApiConfig;
 
     return AX_SKEL_SUCC;
 }
 
+AX_S32 skel::ppl::PipelineHVCFP::GetStatistics(AX_SKEL_STATISTICS_T *pstStatistics) {
+    memset(pstStatistics, 0x00, sizeof(AX_SKEL_STATISTICS_T));
+
+    pstStatistics->nCallbackDropped = m_callback_dropped.load();
+
+    // push counters stay 0 until the first push creates the dealer
+    TrackerDealer *pDealer = m_tracker_dealer.load();
+    if (pDealer) {
+        utils::AX_SKEL_PUSH_CACHE_OCCUPANCY_T stOccupancy;
+        pDealer->CacheOccupancy(stOccupancy);
+        pstStatistics->nFrameCachePinned = stOccupancy.nPinned;
+        pstStatistics->nFrameCachePinnedGlobal = stOccupancy.nPinnedGlobal;
+
+        utils::AX_SKEL_JENC_RATE_STAT_T stRate;
+        pDealer->EncodeRate(stRate);
+        pstStatistics->nPushBytesPerSec = stRate.nBytesPerSec;
+        pstStatistics->nPushEncodeDropped = pDealer->EncodeDrops();
+    }
+
+    return AX_SKEL_SUCC;
+}
+
 AX_S32 skel::ppl::PipelineHVCFP::SetConfig(const AX_SKEL_CONFIG_T *pstConfig) {
     if (pstConfig && pstConfig->nSize > 0) {
         for (int i = 0; i < pstConfig->nSize; i++) {
-            if (ParseConfig(pstConfig->pstItems[i], "track_disable", m_config.track_disable)) {
-                ALOGD("track_disable: %d\n", m_config.track_disable);
-                m_result_constrain.bTrackEnable = m_config.track_disable ? AX_FALSE : AX_TRUE;
+            bool bValue = false;
+            AX_U32 nValue = 0;
+            if (ParseConfig(pstConfig->pstItems[i], "track_disable", bValue)) {
+                ALOGD("track_disable: %d\n", bValue);
+                m_config.track_disable = bValue;
+                m_result_constrain.bTrackEnable = bValue ? AX_FALSE : AX_TRUE;
             }
 
-            if (ParseConfig(pstConfig->pstItems[i], "push_disable", m_config.push_disable)) {
-                ALOGD("push_disable: %d\n", m_config.push_disable);
-                m_result_constrain.bPushEnable = m_config.push_disable ? AX_FALSE : AX_TRUE;
+            if (ParseConfig(pstConfig->pstItems[i], "push_disable", bValue)) {
+                ALOGD("push_disable: %d\n", bValue);
+                m_config.push_disable = bValue;
+                m_result_constrain.bPushEnable = bValue ? AX_FALSE : AX_TRUE;
+            }
+
+            if (ParseConfig(pstConfig->pstItems[i], "track_worker_num", m_config.track_worker_num)) {
+                m_config.track_worker_num = AX_MIN(AX_MAX(m_config.track_worker_num, 1U), (AX_U32)HVCFP_TRACK_WORKER_NUM_MAX);
+                if (m_track_workers.Size() > 0) {
+                    ALOGW("track_worker_num only takes effect on create\n");
+                }
+                ALOGD("track_worker_num: %d\n", m_config.track_worker_num);
+            }
+
+            if (ParseConfig(pstConfig->pstItems[i], "callback_worker_num", m_config.callback_worker_num)) {
+                m_config.callback_worker_num = AX_MIN(AX_MAX(m_config.callback_worker_num, 1U), (AX_U32)HVCFP_CALLBACK_WORKER_NUM_MAX);
+                if (m_callback_workers.Size() > 0) {
+                    ALOGW("callback_worker_num only takes effect on create\n");
+                }
+                ALOGD("callback_worker_num: %d\n", m_config.callback_worker_num);
+            }
+
+            if (ParseConfig(pstConfig->pstItems[i], "callback_queue_depth", m_config.callback_queue_depth)) {
+                m_config.callback_queue_depth = AX_MAX(m_config.callback_queue_depth, 1U);
+                if (m_callback_workers.Size() > 0) {
+                    ALOGW("callback_queue_depth only takes effect on create\n");
+                }
+                ALOGD("callback_queue_depth: %d\n", m_config.callback_queue_depth);
+            }
+
+            if (ParseConfig(pstConfig->pstItems[i], "callback_drop", bValue)) {
+                ALOGD("callback_drop: %d\n", bValue);
+                m_config.callback_drop = bValue;
+            }
+
+            if (ParseConfig(pstConfig->pstItems[i], "detect_interval", nValue)) {
+                nValue = AX_MIN(AX_MAX(nValue, 1U), (AX_U32)HVCFP_DETECT_INTERVAL_MAX);
+                ALOGD("detect_interval: %d\n", nValue);
+                m_config.detect_interval = nValue;
+            }
+
+            AX_BOOL bMatchChanged = AX_FALSE;
+            if (ParseConfig(pstConfig->pstItems[i], "track_match_mode", m_tracker_config.match_mode)) {
+                ALOGD("track_match_mode: %d\n", m_tracker_config.match_mode);
+                bMatchChanged = AX_TRUE;
+            }
+
+            if (ParseConfig(pstConfig->pstItems[i], "track_match_conflict_ratio", m_tracker_config.match_conflict_ratio)) {
+                ALOGD("track_match_conflict_ratio: %f\n", m_tracker_config.match_conflict_ratio);
+                bMatchChanged = AX_TRUE;
+            }
+
+            if (bMatchChanged) {
+                m_tracker.SetMatchMode(m_tracker_config.match_mode, m_tracker_config.match_conflict_ratio);
             }
 
             ParseConfigCopy(pstConfig->pstItems[i], "push_strategy", m_result_constrain.stPushStrategy);
+            if (ParseConfig(pstConfig->pstItems[i], "frame_cache_budget", m_result_constrain.nFrameCacheBudget)) {
+                ALOGD("frame_cache_budget: %d\n", m_result_constrain.nFrameCacheBudget);
+            }
+
+            if (ParseConfig(pstConfig->pstItems[i], "frame_cache_copy", m_config.frame_cache_copy)) {
+                ALOGD("frame_cache_copy: %d\n", m_config.frame_cache_copy);
+                m_result_constrain.bFrameCacheCopy = m_config.frame_cache_copy ? AX_TRUE : AX_FALSE;
+            }
             ParseConfig(pstConfig->pstItems[i], "target_config", m_result_constrain.stWantClasses);
 
             ParseConfig(pstConfig->pstItems[i], "body_max_target_count", m_result_constrain.stMaxTargetCount.nBodyTargetCount);
@@ -110,17 +223,39 @@ AX_S32 skel::ppl::PipelineHVCFP::SetConfig(const AX_SKEL_CONFIG_T *pstConfig) {
 
             ParseConfigCopy(pstConfig->pstItems[i], "crop_encoder", m_result_constrain.stCropEncoderThreshold);
             ParseConfig(pstConfig->pstItems[i], "crop_encoder_qpLevel", m_result_constrain.fCropEncoderQpLevel);
+            if (ParseConfig(pstConfig->pstItems[i], "push_byte_rate", m_result_constrain.nPushByteRate)) {
+                ALOGD("push_byte_rate: %d\n", m_result_constrain.nPushByteRate);
+            }
+
+            if (ParseConfig(pstConfig->pstItems[i], "push_encode_worker_num", m_result_constrain.nPushEncodeWorkerNum)) {
+                m_result_constrain.nPushEncodeWorkerNum = AX_MIN(AX_MAX(m_result_constrain.nPushEncodeWorkerNum, 1U), (AX_U32)HVCFP_PUSH_ENCODE_WORKER_NUM_MAX);
+                if (m_tracker_dealer.load()) {
+                    ALOGW("push_encode_worker_num only takes effect before the first push\n");
+                }
+                ALOGD("push_encode_worker_num: %d\n", m_result_constrain.nPushEncodeWorkerNum);
+            }
 
             ParseConfigCopy(pstConfig->pstItems[i], "resize_panorama_encoder_config", m_result_constrain.stPanoramaResizeConfig);
             ParseConfigCopy(pstConfig->pstItems[i], "push_panorama", m_result_constrain.stPushPanoramaConfig);
 
             ParseConfigCopy(pstConfig->pstItems[i], "push_quality_body", m_result_constrain.stAttrFliterMaps["body"]);
-            ParseConfigCopy(pstConfig->pstItems[i], "push_quality_vehicle", m_result_constrain.stAttrFliterMaps["face"]);
-            ParseConfigCopy(pstConfig->pstItems[i], "push_quality_cycle", m_result_constrain.stAttrFliterMaps["vehicle"]);
-            ParseConfigCopy(pstConfig->pstItems[i], "push_quality_face", m_result_constrain.stAttrFliterMaps["cycle"]);
+            ParseConfigCopy(pstConfig->pstItems[i], "push_quality_vehicle", m_result_constrain.stAttrFliterMaps["vehicle"]);
+            ParseConfigCopy(pstConfig->pstItems[i], "push_quality_cycle", m_result_constrain.stAttrFliterMaps["cycle"]);
+            ParseConfigCopy(pstConfig->pstItems[i], "push_quality_face", m_result_constrain.stAttrFliterMaps["face"]);
             ParseConfigCopy(pstConfig->pstItems[i], "push_quality_plate", m_result_constrain.stAttrFliterMaps["plate"]);
         }
     }
+
+    // Run and the track workers only read the published snapshot, from their next frame on
+    m_result_snapshot.Store(m_result_constrain);
+
+    // with the lock Run creates the dealer under, so it is created from this snapshot or gets it here
+    std::lock_guard<std::mutex> lck(m_stream_mtx);
+    TrackerDealer *pDealer = m_tracker_dealer.load();
+    if (pDealer) {
+        pDealer->SetConfig(m_result_constrain);
+    }
+
     return AX_SKEL_SUCC;
 }
 
@@ -137,6 +272,44 @@ AX_S32 skel::ppl::PipelineHVCFP::GetResult(AX_SKEL_RESULT_T **ppstResult, AX_S32
     return ret;
 }
 
+AX_S32 skel::ppl::PipelineHVCFP::GetResults(AX_SKEL_RESULT_T **ppstResults, AX_U32 nCapacity, AX_U32 *pCount, AX_S32 nTimeout) {
+    AX_S32 ret = AX_SKEL_SUCC;
+    AX_S32 nFail = AX_ERR_SKEL_NOMEM;
+    *pCount = 0;
+
+    // one pop of the queue for the whole batch, converted after its lock is dropped
+    if (m_config.track_disable) {
+        vector<DetQueueType> vecItems;
+        ret = m_detect_result_queue.PopBatch(vecItems, nCapacity, nTimeout);
+        for (auto &queue_item : vecItems) {
+            AX_S32 nRet = MakeDetectResult(queue_item, &ppstResults[*pCount]);
+            if (AX_SKEL_SUCC == nRet) {
+                (*pCount)++;
+            }
+            else {
+                nFail = nRet;
+            }
+        }
+    }
+    else {
+        vector<TrackQueueType> vecItems;
+        ret = m_track_result_queue.PopBatch(vecItems, nCapacity, nTimeout);
+        for (auto &queue_item : vecItems) {
+            ConvertTrackResult(queue_item, &ppstResults[*pCount]);
+            utils::FreeFrame(queue_item.pstFrame);
+            if (ppstResults[*pCount]) {
+                (*pCount)++;
+            }
+        }
+    }
+
+    if (AX_SKEL_SUCC != ret) {
+        return ret;
+    }
+
+    return *pCount > 0 ? AX_SKEL_SUCC : nFail;
+}
+
 AX_S32 skel::ppl::PipelineHVCFP::Run() {
     AX_S32 ret = AX_SKEL_SUCC;
     AX_SKEL_FRAME_T *frame = nullptr;
@@ -151,78 +324,378 @@ AX_S32 skel::ppl::PipelineHVCFP::Run() {
         return ret;
     }
 
+    // one frame goes one way even if SetConfig switches tracking meanwhile
+    bool bTrackDisable = m_config.track_disable;
+
+    // closed before popped, skip the detection
+    if (IsStreamClosed(frame->nStreamId)) {
+        utils::FreeFrame(frame);
+        return AX_SKEL_SUCC;
+    }
+
     DetQueueType det_queue_item;
     det_queue_item.pstFrame = frame;
-    ret = m_detector.Detect(frame->stFrame, det_queue_item.detResult);
-    if (AX_SKEL_SUCC != ret) {
-        ALOGE("Detect failed! ret = 0x%x\n", ret);
-        return ret;
+
+    AX_BOOL bDetect = NeedDetect(frame);
+    if (bDetect) {
+        ret = m_detector.Detect(frame->stFrame, det_queue_item.detResult);
+        if (AX_SKEL_SUCC != ret) {
+            ALOGE("Detect failed! ret = 0x%x\n", ret);
+            utils::FreeFrame(frame);
+            return ret;
+        }
+
+        FilterDetResult(det_queue_item.detResult);
     }
 
-    FilterDetResult(det_queue_item.detResult);
+    // the frame is of the stream epoch it is queued in, a close in between makes it stale wherever it is.
+    // nothing blocking is done under the lock, the config and send calls take it too
+    {
+        std::lock_guard<std::mutex> lck(m_stream_mtx);
+        if (m_closed_streams.find(frame->nStreamId) != m_closed_streams.end()) {
+            utils::FreeFrame(frame);
+            return AX_SKEL_SUCC;
+        }
+        det_queue_item.nEpoch = StreamEpoch(frame->nStreamId);
 
-    if (m_config.track_disable) {
+        if (!bTrackDisable && !m_tracker_dealer.load() && !m_config.push_disable) {
+            ALOGD("Init tracker dealer\n");
+            auto *pDealer = new TrackerDealer(m_result_snapshot.Load()->Param());
+
+            // encoder channels are shared by the handles, sized by the first frame
+            ret = JENCOBJ->Create(frame->stFrame.u32Width, frame->stFrame.u32Height);
+            if (AX_SKEL_SUCC != ret) {
+                ALOGW("jpeg encoder create failed, nothing will be pushed! ret=0x%x\n", ret);
+            }
+            m_jenc_created = (AX_SKEL_SUCC == ret) ? AX_TRUE : AX_FALSE;
+
+            // published once complete, the track workers of the other streams may see it at once
+            m_tracker_dealer = pDealer;
+        }
+    }
+
+    if (bTrackDisable && m_callback) {
+        AX_SKEL_RESULT_T *pstResult = nullptr;
+        ret = MakeDetectResult(det_queue_item, &pstResult);
+        if (AX_SKEL_SUCC == ret) {
+            DispatchResult(pstResult, AX_FALSE);
+        }
+        return (AX_ERR_SKEL_QUEUE_EMPTY == ret) ? AX_SKEL_SUCC : ret;
+    }
+
+    if (bTrackDisable) {
         ret = m_detect_result_queue.Push(det_queue_item);
         if (AX_SKEL_SUCC != ret) {
             ALOGE("push failed! ret=0x%x\n", ret);
+            utils::FreeFrame(frame);
             return ret;
         }
     }
     else {
-        if (!m_tracker_dealer && !m_config.push_disable) {
-            ALOGD("Init tracker dealer\n");
-            m_tracker_dealer = new TrackerDealer(m_result_constrain);
+        // tracking runs on the stream's worker, so streams are tracked concurrently
+        // while frames of the same stream keep their order
+        auto detResult = std::move(det_queue_item.detResult);
+        AX_U32 nEpoch = det_queue_item.nEpoch;
+        ret = m_track_workers.Submit(frame->nStreamId, [this, frame, detResult, bDetect, nEpoch] {
+            TrackTask(frame, detResult, bDetect, nEpoch);
+        });
+        if (AX_SKEL_SUCC != ret) {
+            ALOGE("submit track task failed! ret=0x%x\n", ret);
+            utils::FreeFrame(frame);
+            return ret;
         }
+    }
+
+    return AX_SKEL_SUCC;
+}
 
-        TrackQueueType track_queue_item;
-        track_queue_item.pstFrame = frame;
-        track_queue_item.trackResult = m_tracker.Update(frame, det_queue_item.detResult);
+AX_BOOL skel::ppl::PipelineHVCFP::NeedDetect(const AX_SKEL_FRAME_T *pstFrame) {
+    // without tracking there is nothing to predict from
+    AX_U32 nInterval = m_config.detect_interval;
+    if (m_config.track_disable || nInterval <= 1) {
+        return AX_TRUE;
+    }
 
-        FilterTrackResult(track_queue_item.trackResult);
+    std::lock_guard<std::mutex> lck(m_stream_mtx);
+    AX_U32 &nSkipped = m_detect_skipped[pstFrame->nStreamId];
+    if (nSkipped + 1 >= nInterval
+        || m_tracker.NeedDetect(pstFrame->nStreamId)) {
+        nSkipped = 0;
+        return AX_TRUE;
+    }
 
-        if (m_callback) {
-            AX_SKEL_RESULT_T *pstResult = nullptr;
-            ConvertTrackResult(track_queue_item.pstFrame, track_queue_item.trackResult, &pstResult);
-            m_callback((AX_SKEL_HANDLE)this, pstResult, m_userData);
-            FreeResult(pstResult);
-            utils::FreeFrame(frame);
+    nSkipped++;
+
+    return AX_FALSE;
+}
+
+AX_VOID skel::ppl::PipelineHVCFP::TrackTask(AX_SKEL_FRAME_T *pstFrame, const vector<skel::detection::Object> &detResult, AX_BOOL bDetected, AX_U32 nEpoch) {
+    // submitted after the close task of its stream, the tracks are gone
+    if (IsStreamStale(pstFrame->nStreamId, nEpoch)) {
+        utils::FreeFrame(pstFrame);
+        return;
+    }
+
+    TrackQueueType track_queue_item;
+    track_queue_item.pstFrame = pstFrame;
+    track_queue_item.bDetected = bDetected;
+    track_queue_item.bStreamClosed = AX_FALSE;
+    if (bDetected) {
+        track_queue_item.trackResult = m_tracker.Update(pstFrame, detResult);
+    }
+    else {
+        track_queue_item.trackResult = m_tracker.Predict(pstFrame);
+    }
+
+    FilterTrackResult(track_queue_item.trackResult);
+
+    OutputTrackResult(track_queue_item);
+}
+
+AX_VOID skel::ppl::PipelineHVCFP::OutputTrackResult(TrackQueueType &track_queue_item) {
+    if (m_callback) {
+        AX_SKEL_RESULT_T *pstResult = nullptr;
+        ConvertTrackResult(track_queue_item, &pstResult);
+        utils::FreeFrame(track_queue_item.pstFrame);
+        if (pstResult) {
+            // the last result of a closed stream is never dropped
+            DispatchResult(pstResult, track_queue_item.bStreamClosed);
+        }
+    }
+    else {
+        // a full queue drops its oldest result, never the last result of a closed stream.
+        // evicted and pushed under one lock, a worker is never blocked here
+        TrackQueueType drop_item;
+        bool bEvicted = false;
+        AX_S32 ret = m_track_result_queue.PushEvict(track_queue_item, [](const TrackQueueType &item) {
+            return !item.bStreamClosed;
+        }, drop_item, bEvicted);
+        if (bEvicted) {
+            utils::FreeFrame(drop_item.pstFrame);
+        }
+        if (AX_SKEL_SUCC != ret) {
+            ALOGE("push failed! ret=0x%x\n", ret);
+            utils::FreeFrame(track_queue_item.pstFrame);
+        }
+    }
+}
+
+AX_VOID skel::ppl::PipelineHVCFP::DispatchResult(AX_SKEL_RESULT_T *pstResult, AX_BOOL bMustDeliver) {
+    // the callback runs on the worker of the stream, so a slow one holds up neither detection nor tracking,
+    // only the results of its own streams, which keep their order
+    AX_S32 nTimeout = (m_config.callback_drop && !bMustDeliver) ? 0 : -1;
+    AX_S32 ret = m_callback_workers.Submit(pstResult->nStreamId, [this, pstResult] {
+        m_callback(m_handle, pstResult, m_userData);
+        FreeResult(pstResult);
+    }, nTimeout);
+    if (AX_SKEL_SUCC != ret) {
+        if (AX_ERR_SKEL_QUEUE_FULL == ret) {
+            m_callback_dropped++;
+            ALOGD("callback of stream %d is behind, result of frame %llu dropped\n", pstResult->nStreamId, (unsigned long long)pstResult->nFrameId);
         }
         else {
-            if (m_track_result_queue.IsFull()) {
-                TrackQueueType pop_item;
-                m_track_result_queue.Pop(pop_item, 0);
-            }
-            ret = m_track_result_queue.Push(track_queue_item);
-            if (AX_SKEL_SUCC != ret) {
-                ALOGE("push failed! ret=0x%x\n", ret);
-                return ret;
+            ALOGE("submit callback failed! ret=0x%x\n", ret);
+        }
+        FreeResult(pstResult);
+    }
+}
+
+AX_BOOL skel::ppl::PipelineHVCFP::IsStreamClosed(AX_U32 nStreamId) {
+    std::lock_guard<std::mutex> lck(m_stream_mtx);
+    return m_closed_streams.find(nStreamId) != m_closed_streams.end() ? AX_TRUE : AX_FALSE;
+}
+
+AX_U32 skel::ppl::PipelineHVCFP::StreamEpoch(AX_U32 nStreamId) {
+    auto iter = m_stream_epoch.find(nStreamId);
+    return (iter != m_stream_epoch.end()) ? iter->second : 0;
+}
+
+AX_BOOL skel::ppl::PipelineHVCFP::IsStreamStale(AX_U32 nStreamId, AX_U32 nEpoch) {
+    std::lock_guard<std::mutex> lck(m_stream_mtx);
+    return StreamEpoch(nStreamId) != nEpoch ? AX_TRUE : AX_FALSE;
+}
+
+AX_S32 skel::ppl::PipelineHVCFP::SendFrame(const AX_SKEL_FRAME_T *pstFrame, AX_S32 nTimeout) {
+    if (IsStreamClosed(pstFrame->nStreamId)) {
+        ALOGE("stream %d is closed, open it first\n", pstFrame->nStreamId);
+        return AX_ERR_SKEL_ILLEGAL_PARAM;
+    }
+
+    return PipelineBase::SendFrame(pstFrame, nTimeout);
+}
+
+AX_S32 skel::ppl::PipelineHVCFP::SendFrames(const AX_SKEL_FRAME_T *pstFrames, AX_U32 nFrameNum, AX_U32 *pnSent, AX_S32 nTimeout) {
+    *pnSent = 0;
+
+    // checked up front so a batch is never cut short by a closed stream
+    {
+        std::lock_guard<std::mutex> lck(m_stream_mtx);
+        if (!m_closed_streams.empty()) {
+            for (AX_U32 i = 0; i < nFrameNum; i++) {
+                if (m_closed_streams.find(pstFrames[i].nStreamId) != m_closed_streams.end()) {
+                    ALOGE("stream %d is closed, open it first\n", pstFrames[i].nStreamId);
+                    return AX_ERR_SKEL_ILLEGAL_PARAM;
+                }
             }
         }
     }
 
+    return PipelineBase::SendFrames(pstFrames, nFrameNum, pnSent, nTimeout);
+}
+
+AX_S32 skel::ppl::PipelineHVCFP::OpenStream(AX_U32 nStreamId) {
+    {
+        std::lock_guard<std::mutex> lck(m_stream_mtx);
+        if (m_closed_streams.find(nStreamId) == m_closed_streams.end()) {
+            return AX_SKEL_SUCC;
+        }
+
+        m_closed_streams.erase(nStreamId);
+    }
+
+    // on the worker of the stream, so after its close task
+    AX_S32 ret = m_track_workers.Submit(nStreamId, [this, nStreamId] {
+        TrackerDealer *pDealer = m_tracker_dealer.load();
+        if (pDealer) {
+            pDealer->OpenStream(nStreamId);
+        }
+    });
+    if (AX_SKEL_SUCC != ret) {
+        ALOGE("submit open task of stream %d failed! ret=0x%x\n", nStreamId, ret);
+        return ret;
+    }
+
+    return AX_SKEL_SUCC;
+}
+
+AX_S32 skel::ppl::PipelineHVCFP::CloseStream(AX_U32 nStreamId) {
+    {
+        std::lock_guard<std::mutex> lck(m_stream_mtx);
+        if (m_closed_streams.find(nStreamId) != m_closed_streams.end()) {
+            ALOGW("stream %d is already closed\n", nStreamId);
+            return AX_SKEL_SUCC;
+        }
+
+        // frames of the stream queued before are stale from now on
+        m_closed_streams.insert(nStreamId);
+        m_stream_epoch[nStreamId]++;
+        m_detect_skipped.erase(nStreamId);
+    }
+
+    // the close task shares the worker of the stream, so it runs after every track task already submitted,
+    // the ones submitted later see the new epoch
+    AX_S32 ret = m_track_workers.Submit(nStreamId, [this, nStreamId] {
+        CloseStreamTask(nStreamId);
+    });
+    if (AX_SKEL_SUCC != ret) {
+        ALOGE("submit close task of stream %d failed! ret=0x%x\n", nStreamId, ret);
+        return ret;
+    }
+
+    // frames not popped yet are never processed
+    vector<AX_SKEL_FRAME_T*> vecFrames;
+    m_input_queue.Remove([nStreamId](AX_SKEL_FRAME_T *pstFrame) {
+        return pstFrame->nStreamId == nStreamId;
+    }, vecFrames);
+    for (auto *pstFrame : vecFrames) {
+        utils::FreeFrame(pstFrame);
+    }
+
     return AX_SKEL_SUCC;
 }
 
+AX_VOID skel::ppl::PipelineHVCFP::CloseStreamTask(AX_U32 nStreamId) {
+    // results not fetched yet refer to the released tracks
+    vector<DetQueueType> vecDetItems;
+    m_detect_result_queue.Remove([nStreamId](const DetQueueType &item) {
+        return item.pstFrame->nStreamId == nStreamId;
+    }, vecDetItems);
+    for (auto &item : vecDetItems) {
+        utils::FreeFrame(item.pstFrame);
+    }
+
+    vector<TrackQueueType> vecTrackItems;
+    m_track_result_queue.Remove([nStreamId](const TrackQueueType &item) {
+        return item.pstFrame->nStreamId == nStreamId;
+    }, vecTrackItems);
+    for (auto &item : vecTrackItems) {
+        utils::FreeFrame(item.pstFrame);
+    }
+
+    TrackQueueType track_queue_item;
+    track_queue_item.trackResult = m_tracker.CloseStream(nStreamId);
+    track_queue_item.bDetected = AX_FALSE;
+    track_queue_item.bStreamClosed = AX_TRUE;
+
+    // here rather than with the last result, which may never be converted. its cached frames and
+    // jpeg buffers are dropped, and results converted from now on leave it closed
+    TrackerDealer *pDealer = m_tracker_dealer.load();
+    if (pDealer) {
+        pDealer->CloseStream(nStreamId);
+    }
+
+    if (m_config.track_disable) {
+        return;
+    }
+
+    // no image behind the last result, the frame only carries ids
+    auto *pstFrame = (AX_SKEL_FRAME_T*)malloc(sizeof(AX_SKEL_FRAME_T));
+    if (!pstFrame) {
+        ALOGE("malloc last result of stream %d failed\n", nStreamId);
+        return;
+    }
+    memset(pstFrame, 0x00, sizeof(AX_SKEL_FRAME_T));
+    pstFrame->nStreamId = nStreamId;
+    for (const auto &item : *track_queue_item.trackResult) {
+        pstFrame->nFrameId = AX_MAX(pstFrame->nFrameId, item.real_frame_id);
+    }
+    track_queue_item.pstFrame = pstFrame;
+
+    OutputTrackResult(track_queue_item);
+}
+
 AX_S32 skel::ppl::PipelineHVCFP::GetDetectResult(AX_SKEL_RESULT_T **ppstResult, AX_S32 nTimeout) {
     AX_S32 ret = AX_SKEL_SUCC;
 
-    DetQueueType queue_item;
-    ret = m_detect_result_queue.Pop(queue_item, nTimeout);
-    if (AX_SKEL_SUCC != ret) {
-        if (AX_ERR_SKEL_UNEXIST == ret) {
-            ALOGW("pipeline will be closed.\n");
+    while (1) {
+        DetQueueType queue_item;
+        ret = m_detect_result_queue.Pop(queue_item, nTimeout);
+        if (AX_SKEL_SUCC != ret) {
+            if (AX_ERR_SKEL_UNEXIST == ret) {
+                ALOGW("pipeline will be closed.\n");
+                return ret;
+            }
+            ALOGE("pop failed! ret=0x%x\n", ret);
             return ret;
         }
-        ALOGE("pop failed! ret=0x%x\n", ret);
-        return ret;
-    }
 
-    *ppstResult = (AX_SKEL_RESULT_T*)malloc(sizeof(AX_SKEL_RESULT_T));
-    AX_SKEL_RESULT_T* dst = *ppstResult;
-    memset(dst, 0, sizeof(AX_SKEL_RESULT_T));
+        // a result of a stream closed since is skipped
+        ret = MakeDetectResult(queue_item, ppstResult);
+        if (AX_ERR_SKEL_QUEUE_EMPTY != ret) {
+            return ret;
+        }
+    }
+}
 
+AX_S32 skel::ppl::PipelineHVCFP::MakeDetectResult(DetQueueType &queue_item, AX_SKEL_RESULT_T **ppstResult) {
     auto *pstFrame = queue_item.pstFrame;
     auto& detect_result = queue_item.detResult;
+
+    // detected before its stream was closed, no result of the stream comes after the close
+    if (IsStreamStale(pstFrame->nStreamId, queue_item.nEpoch)) {
+        *ppstResult = nullptr;
+        utils::FreeFrame(pstFrame);
+        return AX_ERR_SKEL_QUEUE_EMPTY;
+    }
+
+    *ppstResult = m_result_pool->Alloc((AX_U32)detect_result.size());
+    AX_SKEL_RESULT_T* dst = *ppstResult;
+    if (!dst) {
+        ALOGE("alloc result failed!\n");
+        utils::FreeFrame(pstFrame);
+        return AX_ERR_SKEL_NOMEM;
+    }
+
     dst->nOriginalHeight = m_originSize[0];
     dst->nOriginalWidth = m_originSize[1];
     dst->nFrameId = pstFrame->nFrameId;
@@ -230,9 +703,6 @@ AX_S32 skel::ppl::PipelineHVCFP::GetDetectResult(AX_SKEL_RESULT_T **ppstResult,
     dst->pUserData = pstFrame->pUserData;
 
     if (!detect_result.empty()) {
-        dst->nObjectSize = (int)detect_result.size();
-        dst->pstObjectItems = (AX_SKEL_OBJECT_ITEM_T*)malloc(dst->nObjectSize * sizeof(AX_SKEL_OBJECT_ITEM_T));
-        memset(dst->pstObjectItems, 0, dst->nObjectSize * sizeof(AX_SKEL_OBJECT_ITEM_T));
         AX_SKEL_OBJECT_ITEM_T *pstItems = dst->pstObjectItems;
         for (int i = 0; i < dst->nObjectSize; i++) {
             pstItems[i].nFrameId = pstFrame->nFrameId;
@@ -265,31 +735,11 @@ AX_S32 skel::ppl::PipelineHVCFP::GetTrackResult(AX_SKEL_RESULT_T **ppstResult, A
         return ret;
     }
 
-    ConvertTrackResult(queue_item.pstFrame, queue_item.trackResult, ppstResult);
+    ConvertTrackResult(queue_item, ppstResult);
 
     utils::FreeFrame(queue_item.pstFrame);
 
-    return AX_SKEL_SUCC;
-}
-
-AX_S32 skel::ppl::PipelineHVCFP::ResultCallbackThread() {
-    AX_S32 ret = AX_SKEL_SUCC;
-    AX_SKEL_RESULT_T *result = nullptr;
-    ret = GetResult(&result, -1);
-    if (AX_SKEL_SUCC != ret) {
-        if (AX_ERR_SKEL_UNEXIST == ret) {
-            ALOGW("pipeline will be closed.\n");
-            return ret;
-        }
-        ALOGE("GetResult failed! ret=0x%x\n", ret);
-        return ret;
-    }
-
-    m_callback((AX_SKEL_HANDLE)this, result, m_userData);
-
-    FreeResult(result);
-
-    return AX_SKEL_SUCC;
+    return *ppstResult ? AX_SKEL_SUCC : AX_ERR_SKEL_NOMEM;
 }
 
 AX_S32 skel::ppl::PipelineHVCFP::DealWithParams(const AX_SKEL_HANDLE_PARAM_T *pstParam) {
@@ -339,86 +789,76 @@ AX_S32 skel::ppl::PipelineHVCFP::InitTracker() {
     m_tracker_config.n_classes = HVCFP_CLASS_NAMES.size();
     m_tracker.Init(m_tracker_config);
 
+    if (m_stHandleParam.nFrameDepth > 0) {
+        m_track_workers.SetCapacity(m_stHandleParam.nFrameDepth);
+    }
+
+    AX_S32 ret = m_track_workers.Start(m_config.track_worker_num);
+    if (AX_SKEL_SUCC != ret) {
+        ALOGE("Start track workers failed! ret=0x%x\n", ret);
+        return ret;
+    }
+
     return AX_SKEL_SUCC;
 }
 
-AX_VOID skel::ppl::PipelineHVCFP::FilterDetResult(vector<skel::detection::Object> &detResult) {
-    // want classes
-    if (!m_result_constrain.stWantClasses.empty()) {
-        for (auto it = detResult.begin(); it != detResult.end();) {
-            string strLabel = HVCFP_CLASS_NAMES[it->label];
-            if (std::find(m_result_constrain.stWantClasses.begin(), m_result_constrain.stWantClasses.end(), strLabel)
-                    == m_result_constrain.stWantClasses.end()) {
-                it = detResult.erase(it);
-            } else {
-                it++;
-            }
-        }
+AX_S32 skel::ppl::PipelineHVCFP::InitCallback() {
+    // idle until a callback is registered, the workers sleep on their queues
+    m_callback_workers.SetCapacity(m_config.callback_queue_depth);
+
+    AX_S32 ret = m_callback_workers.Start(m_config.callback_worker_num);
+    if (AX_SKEL_SUCC != ret) {
+        ALOGE("Start callback workers failed! ret=0x%x\n", ret);
+        return ret;
     }
 
+    return AX_SKEL_SUCC;
+}
+
+AX_VOID skel::ppl::PipelineHVCFP::FilterDetResult(vector<skel::detection::Object> &detResult) {
+    ParamSnapshotPtr pSnapshot = m_result_snapshot.Load();
+    const AX_SKEL_PARAM_T &stParam = pSnapshot->Param();
+
     // ROI
-    if (m_result_constrain.stRoi.bEnable) {
-        float roi_x1 = m_result_constrain.stRoi.stRect.fX;
-        float roi_y1 = m_result_constrain.stRoi.stRect.fY;
-        float roi_x2 = roi_x1 + m_result_constrain.stRoi.stRect.fW;
-        float roi_y2 = roi_y1 + m_result_constrain.stRoi.stRect.fH;
-        for (auto it = detResult.begin(); it != detResult.end();) {
-            float x1 = it->rect.x;
-            float y1 = it->rect.y;
-            float x2 = it->rect.x + it->rect.width;
-            float y2 = it->rect.y + it->rect.height;
-            if (x1 >= roi_x1 && x2 <= roi_x2 && y1 >= roi_y1 && y2 <= roi_y2) {
-                it++;
-            } else {
-                it = detResult.erase(it);
-            }
-        }
-    }
+    float roi_x1 = stParam.stRoi.stRect.fX;
+    float roi_y1 = stParam.stRoi.stRect.fY;
+    float roi_x2 = roi_x1 + stParam.stRoi.stRect.fW;
+    float roi_y2 = roi_y1 + stParam.stRoi.stRect.fH;
+
+    // max target count
+    AX_U32 nTargetCount[SKEL_LABEL_MAX] = {0};
 
-    // size and confidence
     for (auto it = detResult.begin(); it != detResult.end(); ) {
-        string strLabel = HVCFP_CLASS_NAMES[it->label];
-        skel::infer::Size min_size = m_result_constrain.stFilterMaps[strLabel].minSize;
-        float conf_thresh = m_result_constrain.stFilterMaps[strLabel].fConfidence;
-        if (it->rect.width < min_size.width || it->rect.height < min_size.height ||
-            it->prob < conf_thresh) {
+        AX_S32 nLabel = HVCFP_CLASS_LABELS[it->label];
+        const AX_SKEL_LABEL_CONFIG_T &stLabel = pSnapshot->Label(nLabel);
+
+        // want classes
+        if (!stLabel.bWant) {
             it = detResult.erase(it);
-        } else {
-            it++;
+            continue;
         }
-    }
 
-    // max target count
-    int nBodyCount = 0;
-    int nVehicleCount = 0;
-    int nCycleCount = 0;
-    for (auto it = detResult.begin(); it != detResult.end(); ) {
-        string strLabel = HVCFP_CLASS_NAMES[it->label];
-        if (strLabel == "body") {
-            nBodyCount++;
-            if (m_result_constrain.stMaxTargetCount.nBodyTargetCount > 0 &&
-                    nBodyCount > m_result_constrain.stMaxTargetCount.nBodyTargetCount) {
+        if (stParam.stRoi.bEnable) {
+            float x1 = it->rect.x;
+            float y1 = it->rect.y;
+            float x2 = it->rect.x + it->rect.width;
+            float y2 = it->rect.y + it->rect.height;
+            if (!(x1 >= roi_x1 && x2 <= roi_x2 && y1 >= roi_y1 && y2 <= roi_y2)) {
                 it = detResult.erase(it);
                 continue;
             }
         }
 
-        if (strLabel == "vehicle") {
-            nVehicleCount++;
-            if (m_result_constrain.stMaxTargetCount.nVehicleTargetCount > 0 &&
-                    nVehicleCount > m_result_constrain.stMaxTargetCount.nVehicleTargetCount) {
-                it = detResult.erase(it);
-                continue;
-            }
+        // size and confidence
+        if (it->rect.width < stLabel.stFilter.minSize.width || it->rect.height < stLabel.stFilter.minSize.height ||
+            it->prob < stLabel.stFilter.fConfidence) {
+            it = detResult.erase(it);
+            continue;
         }
 
-        if (strLabel == "cycle") {
-            nCycleCount++;
-            if (m_result_constrain.stMaxTargetCount.nCycleTargetCount > 0 &&
-                    nCycleCount > m_result_constrain.stMaxTargetCount.nCycleTargetCount) {
-                it = detResult.erase(it);
-                continue;
-            }
+        if (nLabel >= 0 && stLabel.nMaxTargetCount > 0 && ++ nTargetCount[nLabel] > stLabel.nMaxTargetCount) {
+            it = detResult.erase(it);
+            continue;
         }
 
         it++;
@@ -426,75 +866,54 @@ AX_VOID skel::ppl::PipelineHVCFP::FilterDetResult(vector<skel::detection::Object
 }
 
 AX_VOID skel::ppl::PipelineHVCFP::FilterTrackResult(tracker::TrackResultType& trackResult) {
-    // max target count
-    int nBodyCount = 0;
-    int nVehicleCount = 0;
-    int nCycleCount = 0;
-    for (auto outer_it = trackResult.begin(); outer_it != trackResult.end(); outer_it++) {
-        auto& output_tracks = outer_it->second;
-        for (auto it = output_tracks.begin(); it != output_tracks.end(); ) {
-            AX_U32 class_id = (*it)->class_id;
-            string strLabel = HVCFP_CLASS_NAMES[class_id];
-            if (strLabel == "body") {
-                nBodyCount++;
-                if (m_result_constrain.stMaxTargetCount.nBodyTargetCount > 0 &&
-                    nBodyCount > m_result_constrain.stMaxTargetCount.nBodyTargetCount) {
-                    it = output_tracks.erase(it);
-                    continue;
-                }
-            }
-
-            if (strLabel == "vehicle") {
-                nVehicleCount++;
-                if (m_result_constrain.stMaxTargetCount.nVehicleTargetCount > 0 &&
-                    nVehicleCount > m_result_constrain.stMaxTargetCount.nVehicleTargetCount) {
-                    it = output_tracks.erase(it);
-                    continue;
-                }
-            }
+    if (!trackResult) {
+        return;
+    }
 
-            if (strLabel == "cycle") {
-                nCycleCount++;
-                if (m_result_constrain.stMaxTargetCount.nCycleTargetCount > 0 &&
-                    nCycleCount > m_result_constrain.stMaxTargetCount.nCycleTargetCount) {
-                    it = output_tracks.erase(it);
-                    continue;
-                }
-            }
+    ParamSnapshotPtr pSnapshot = m_result_snapshot.Load();
 
-            it++;
+    // max target count
+    AX_U32 nTargetCount[SKEL_LABEL_MAX] = {0};
+    auto& output_tracks = *trackResult;
+    for (auto it = output_tracks.begin(); it != output_tracks.end(); ) {
+        AX_S32 nLabel = HVCFP_CLASS_LABELS[it->class_id];
+        const AX_SKEL_LABEL_CONFIG_T &stLabel = pSnapshot->Label(nLabel);
+
+        if (nLabel >= 0 && stLabel.nMaxTargetCount > 0 && ++ nTargetCount[nLabel] > stLabel.nMaxTargetCount) {
+            it = output_tracks.erase(it);
+            continue;
         }
+
+        it++;
     }
 }
 
-AX_VOID skel::ppl::PipelineHVCFP::ConvertTrackResult(AX_SKEL_FRAME_T* pstFrame, const tracker::TrackResultType& trackResult, AX_SKEL_RESULT_T **ppstResult) {
-    *ppstResult = (AX_SKEL_RESULT_T*)malloc(sizeof(AX_SKEL_RESULT_T));
-    AX_SKEL_RESULT_T* dst = *ppstResult;
-    memset(dst, 0, sizeof(AX_SKEL_RESULT_T));
+AX_VOID skel::ppl::PipelineHVCFP::ConvertTrackResult(const TrackQueueType &track_queue_item, AX_SKEL_RESULT_T **ppstResult) {
+    AX_SKEL_FRAME_T *pstFrame = track_queue_item.pstFrame;
+    const tracker::TrackResultType &trackResult = track_queue_item.trackResult;
+    AX_BOOL bStreamClosed = track_queue_item.bStreamClosed;
 
-    dst->nOriginalHeight = m_originSize[0];
-    dst->nOriginalWidth = m_originSize[1];
-    dst->nFrameId = pstFrame->nFrameId;
-    dst->nStreamId = pstFrame->nStreamId;
-    dst->pUserData = pstFrame->pUserData;
+    vector<AX_SKEL_OBJECT_ITEM_T> vecResult = TakeItems();
 
-    vector<AX_SKEL_OBJECT_ITEM_T> vecResult;
-    for (auto it = trackResult.begin(); it != trackResult.end(); it++) {
-        const auto& output_tracks = it->second;
+    // the dealer is created by Run with the first frame pushes are enabled for
+    TrackerDealer *pDealer = m_config.push_disable ? nullptr : m_tracker_dealer.load();
+    bool bPush = (pDealer != nullptr);
+    if (trackResult) {
+        const auto& output_tracks = *trackResult;
         for (AX_U32 i = 0; i < output_tracks.size(); ++ i) {
             const auto& obj = output_tracks[i];
-            AX_U32 nClassId = obj->class_id;
+            AX_U32 nClassId = obj.class_id;
             const AX_CHAR *pstrObjectCategory = HVCFP_CLASS_NAMES[nClassId].c_str();
             AX_SKEL_OBJECT_ITEM_T stObjectItem;
             memset(&stObjectItem, 0x00, sizeof(stObjectItem));
 
-            if (obj->state == TrackState::New) {
+            if (obj.state == TrackState::New) {
                 stObjectItem.eTrackState = AX_SKEL_TRACK_STATUS_NEW;
             }
-            else if (obj->state == TrackState::Tracked) {
+            else if (obj.state == TrackState::Tracked) {
                 stObjectItem.eTrackState = AX_SKEL_TRACK_STATUS_UPDATE;
             }
-            else if (obj->state == TrackState::Removed) {
+            else if (obj.state == TrackState::Removed) {
                 stObjectItem.eTrackState = AX_SKEL_TRACK_STATUS_DIE;
             }
             else {
@@ -502,48 +921,94 @@ AX_VOID skel::ppl::PipelineHVCFP::ConvertTrackResult(AX_SKEL_FRAME_T* pstFrame,
             }
 
             stObjectItem.pstrObjectCategory = (const AX_CHAR *)pstrObjectCategory;
-            stObjectItem.stRect.fX = (float)obj->_tlwh[0];
-            stObjectItem.stRect.fY = (float)obj->_tlwh[1];
-            stObjectItem.stRect.fW = (float)obj->_tlwh[2];
-            stObjectItem.stRect.fH = (float)obj->_tlwh[3];
-            stObjectItem.fConfidence = (float)obj->score;
-            stObjectItem.nFrameId = obj->real_frame_id;
+            stObjectItem.stRect.fX = (float)obj.tlwh[0];
+            stObjectItem.stRect.fY = (float)obj.tlwh[1];
+            stObjectItem.stRect.fW = (float)obj.tlwh[2];
+            stObjectItem.stRect.fH = (float)obj.tlwh[3];
+            stObjectItem.fConfidence = (float)obj.score;
+            stObjectItem.nFrameId = obj.real_frame_id;
 
             // track
-            stObjectItem.nTrackId = obj->track_id;
-
-            if (!m_config.push_disable) {
-                m_tracker_dealer->Update(pstFrame, stObjectItem);
-            }
+            stObjectItem.nTrackId = obj.track_id;
 
             vecResult.push_back(stObjectItem);
         }
     }
 
+    // the objects of the frame in one call, a box only predicted on a frame skipped by detection never
+    // becomes a push candidate
+    if (bPush && !bStreamClosed) {
+        pDealer->Update(pstFrame, vecResult, track_queue_item.bDetected);
+    }
+
+    // nothing is pushed for a closed stream, CloseStreamTask already closed it in the dealer
+    PushCacheListsPtr pCacheLists;
+    AX_U32 nCacheListSize = 0;
+    if (bPush && !bStreamClosed) {
+        // appends the pushes, so before vecResult is copied
+        pDealer->Finalize(pstFrame, pCacheLists, vecResult);
+        if (pCacheLists) {
+            for (const auto &pCacheList : *pCacheLists) {
+                nCacheListSize += (AX_U32)pCacheList->size();
+            }
+        }
+    }
+
+    *ppstResult = m_result_pool->Alloc((AX_U32)vecResult.size(), 0, nCacheListSize);
+    AX_SKEL_RESULT_T* dst = *ppstResult;
+    if (!dst) {
+        ALOGE("alloc result failed!\n");
+        JENCOBJ->RelItems(vecResult.data(), (AX_U32)vecResult.size());
+        GiveItems(vecResult);
+        return;
+    }
+
+    dst->nOriginalHeight = m_originSize[0];
+    dst->nOriginalWidth = m_originSize[1];
+    dst->nFrameId = pstFrame->nFrameId;
+    dst->nStreamId = pstFrame->nStreamId;
+    dst->pUserData = pstFrame->pUserData;
+
     if (!vecResult.empty()) {
-        dst->nObjectSize = (int)vecResult.size();
-        dst->pstObjectItems = (AX_SKEL_OBJECT_ITEM_T*)malloc(dst->nObjectSize * sizeof(AX_SKEL_OBJECT_ITEM_T));
-        memcpy(dst->pstObjectItems, vecResult.data(), dst->nObjectSize * sizeof(AX_SKEL_OBJECT_ITEM_T));
+        memcpy(dst->pstObjectItems, vecResult.data(), vecResult.size() * sizeof(AX_SKEL_OBJECT_ITEM_T));
     }
 
-    if (!m_config.push_disable) {
-        m_tracker_dealer->Finalize(pstFrame, dst, vecResult);
+    // the published lists of the streams go straight into the block of the result
+    if (nCacheListSize > 0) {
+        for (const auto &pCacheList : *pCacheLists) {
+            memcpy(dst->pstCacheList + dst->nCacheListSize, pCacheList->data(), pCacheList->size() * sizeof(AX_SKEL_FRAME_CACHE_LIST_T));
+            dst->nCacheListSize += (AX_U32)pCacheList->size();
+        }
     }
+
+    GiveItems(vecResult);
 }
 
-AX_VOID skel::ppl::PipelineHVCFP::FreeResult(AX_SKEL_RESULT_T *pstResult) {
-    if (!pstResult) return;
+std::vector<AX_SKEL_OBJECT_ITEM_T> skel::ppl::PipelineHVCFP::TakeItems() {
+    std::vector<AX_SKEL_OBJECT_ITEM_T> vecItems;
 
-    if (pstResult->nObjectSize > 0) {
-        for (int i = 0; i < pstResult->nObjectSize; i++) {
-            if (pstResult->pstObjectItems[i].pstPointSet) {
-                delete[] pstResult->pstObjectItems[i].pstPointSet;
-            }
-        }
-        free(pstResult->pstObjectItems);
+    std::lock_guard<std::mutex> lck(m_items_mtx);
+    if (!m_items_free.empty()) {
+        vecItems.swap(m_items_free.back());
+        m_items_free.pop_back();
     }
-    if (pstResult->nCacheListSize > 0) {
-        delete[] pstResult->pstCacheList;
+
+    return vecItems;
+}
+
+AX_VOID skel::ppl::PipelineHVCFP::GiveItems(std::vector<AX_SKEL_OBJECT_ITEM_T> &vecItems) {
+    vecItems.clear();
+
+    std::lock_guard<std::mutex> lck(m_items_mtx);
+    if (m_items_free.size() < HVCFP_ITEMS_CACHE_NUM) {
+        m_items_free.emplace_back(std::move(vecItems));
     }
-    free(pstResult);
+}
+
+AX_VOID skel::ppl::PipelineHVCFP::FreeResult(AX_SKEL_RESULT_T *pstResult) {
+    if (!pstResult) return;
+
+    // pushed jenc buffers belong to the result, point sets and the cache list are in its block
+    JENCOBJ->RelItems(pstResult->pstObjectItems, pstResult->nObjectSize);
+    utils::ResultPool::Release(pstResult);
 }
\ No newline at end of file
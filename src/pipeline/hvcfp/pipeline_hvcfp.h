@@ -16,17 +16,45 @@
 
 #include "inference/detection.hpp"
 #include "tracker/byteTracker.hpp"
+#include "utils/worker_pool.h"
+#include "utils/param_snapshot.h"
+#include "utils/result_pool.h"
 #include "tracker_dealer.h"
 
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <unordered_set>
+
 namespace skel {
     namespace ppl {
+        #define HVCFP_TRACK_WORKER_NUM_MAX     8
+        #define HVCFP_DETECT_INTERVAL_MAX       30
+        #define HVCFP_CALLBACK_WORKER_NUM_MAX   8
+        #define HVCFP_PUSH_ENCODE_WORKER_NUM_MAX    4
+        #define HVCFP_ITEMS_CACHE_NUM           (HVCFP_CALLBACK_WORKER_NUM_MAX + 2)
+
+        // written by SetConfig only. the atomics are read by Run, the track workers and the callback
+        // dispatch while being set, the others take effect on create or are read by GetConfig only
         struct HVCPConfig {
-            bool track_disable;
-            bool push_disable;
+            std::atomic<bool> track_disable;
+            std::atomic<bool> push_disable;
+            bool frame_cache_copy;
+            AX_U32 track_worker_num;
+            std::atomic<AX_U32> detect_interval;
+            AX_U32 callback_worker_num;
+            AX_U32 callback_queue_depth;    // results waiting for the callback, per worker
+            std::atomic<bool> callback_drop;    // drop a result rather than wait when the callback is behind
 
             HVCPConfig():
                     track_disable(false),
-                    push_disable(true) {
+                    push_disable(true),
+                    frame_cache_copy(false),
+                    track_worker_num(AX_MIN(AX_MAX(std::thread::hardware_concurrency(), 1U), 4U)),
+                    detect_interval(1),
+                    callback_worker_num(1),
+                    callback_queue_depth(SKEL_DEFAULT_QUEUE_LEN),
+                    callback_drop(false) {
 
             }
         };
@@ -38,11 +66,15 @@ namespace skel {
                 m_pstApiConfig(nullptr),
                 m_detect_result_queue(SKEL_DEFAULT_QUEUE_LEN),
                 m_track_result_queue(SKEL_DEFAULT_QUEUE_LEN),
-                m_tracker_dealer(nullptr) {
+                m_tracker_dealer(nullptr),
+                m_jenc_created(AX_FALSE),
+                m_result_pool(new utils::ResultPool()) {
 
             }
 
-            ~PipelineHVCFP() = default;
+            ~PipelineHVCFP() {
+                m_result_pool->Detach();
+            }
 
             AX_SKEL_PPL_E Type() override {
                 return AX_SKEL_PPL_HVCFP;
@@ -53,29 +85,53 @@ namespace skel {
             AX_S32 GetConfig(const AX_SKEL_CONFIG_T **ppstConfig) override;
             AX_S32 SetConfig(const AX_SKEL_CONFIG_T *pstConfig) override;
             AX_S32 GetResult(AX_SKEL_RESULT_T **ppstResult, AX_S32 nTimeout) override;
+            AX_S32 GetResults(AX_SKEL_RESULT_T **ppstResults, AX_U32 nCapacity, AX_U32 *pCount, AX_S32 nTimeout) override;
             AX_S32 Run() override;
-            AX_S32 ResultCallbackThread() override;
+            AX_VOID Stop() override;
+            AX_S32 SendFrame(const AX_SKEL_FRAME_T *pstFrame, AX_S32 nTimeout) override;
+            AX_S32 SendFrames(const AX_SKEL_FRAME_T *pstFrames, AX_U32 nFrameNum, AX_U32 *pnSent, AX_S32 nTimeout) override;
+            AX_S32 OpenStream(AX_U32 nStreamId) override;
+            AX_S32 CloseStream(AX_U32 nStreamId) override;
+            AX_S32 GetStatistics(AX_SKEL_STATISTICS_T *pstStatistics) override;
 
         private:
             typedef struct {
                 AX_SKEL_FRAME_T *pstFrame;
                 std::vector<detection::Object> detResult;
+                AX_U32 nEpoch;              // of the stream when queued
             } DetQueueType;
 
             typedef struct {
                 AX_SKEL_FRAME_T *pstFrame;
                 tracker::TrackResultType trackResult;
+                AX_BOOL bDetected;          // tracked from a detection, not only predicted
+                AX_BOOL bStreamClosed;      // last result of a closed stream
             } TrackQueueType;
 
             AX_S32 InitDetector();
             AX_S32 InitTracker();
+            AX_S32 InitCallback();
+            AX_BOOL NeedDetect(const AX_SKEL_FRAME_T *pstFrame);
+            AX_VOID TrackTask(AX_SKEL_FRAME_T *pstFrame, const std::vector<detection::Object> &detResult, AX_BOOL bDetected, AX_U32 nEpoch);
+            AX_VOID CloseStreamTask(AX_U32 nStreamId);
+            AX_VOID OutputTrackResult(TrackQueueType &track_queue_item);
+            AX_VOID DispatchResult(AX_SKEL_RESULT_T *pstResult, AX_BOOL bMustDeliver);
+            AX_BOOL IsStreamClosed(AX_U32 nStreamId);
+            // m_stream_mtx held
+            AX_U32 StreamEpoch(AX_U32 nStreamId);
+            // closed since nEpoch, reopened or not
+            AX_BOOL IsStreamStale(AX_U32 nStreamId, AX_U32 nEpoch);
             AX_S32 DealWithParams(const AX_SKEL_HANDLE_PARAM_T *pstParam);
             AX_S32 GetDetectResult(AX_SKEL_RESULT_T **ppstResult, AX_S32 nTimeout);
+            AX_S32 MakeDetectResult(DetQueueType &queue_item, AX_SKEL_RESULT_T **ppstResult);
             AX_S32 GetTrackResult(AX_SKEL_RESULT_T **ppstResult, AX_S32 nTimeout);
             AX_VOID FilterDetResult(std::vector<skel::detection::Object>& detResult);
             AX_VOID FilterTrackResult(tracker::TrackResultType& trackResult);
-            AX_VOID ConvertTrackResult(AX_SKEL_FRAME_T* pstFrame, const tracker::TrackResultType& trackResult, AX_SKEL_RESULT_T **ppstResult);
+            AX_VOID ConvertTrackResult(const TrackQueueType &track_queue_item, AX_SKEL_RESULT_T **ppstResult);
             AX_VOID FreeResult(AX_SKEL_RESULT_T *pstResult);
+            // the object items of a result are staged in a vector of m_items_free, its capacity is kept
+            std::vector<AX_SKEL_OBJECT_ITEM_T> TakeItems();
+            AX_VOID GiveItems(std::vector<AX_SKEL_OBJECT_ITEM_T> &vecItems);
 
         private:
             HVCPConfig m_config;
@@ -83,10 +139,22 @@ namespace skel {
             HVCFPDetector m_detector;
             tracker::CBYTETracker m_tracker;
             tracker::BYTETrackerConfig m_tracker_config;
+            utils::WorkerPool m_track_workers;
+            utils::WorkerPool m_callback_workers;           // runs the user callback, keyed by stream
+            std::atomic<AX_U64> m_callback_dropped{0};
+            std::mutex m_stream_mtx;
+            std::unordered_map<AX_U32, AX_U32> m_detect_skipped;    // stream id -> frames skipped since last detection
+            std::unordered_set<AX_U32> m_closed_streams;    // frames of these streams are dropped until reopened
+            std::unordered_map<AX_U32, AX_U32> m_stream_epoch;  // stream id -> times closed
             utils::TimeoutQueue<DetQueueType> m_detect_result_queue;
             utils::TimeoutQueue<TrackQueueType> m_track_result_queue;
-            utils::TrackerDealer *m_tracker_dealer;
-            AX_SKEL_PARAM_T m_result_constrain;
+            std::atomic<utils::TrackerDealer*> m_tracker_dealer;   // set once by Run, read by the workers and GetResult
+            AX_BOOL m_jenc_created;                         // holds a reference of the shared jpeg encoder pool
+            AX_SKEL_PARAM_T m_result_constrain;             // edited by SetConfig only
+            utils::ParamPublisher m_result_snapshot;         // what the frames are filtered with
+            utils::ResultPool *m_result_pool;               // outlives the handle while the user holds results
+            std::mutex m_items_mtx;
+            std::vector<std::vector<AX_SKEL_OBJECT_ITEM_T>> m_items_free;   // staging of ConvertTrackResult, see TakeItems
         };
     }
 }
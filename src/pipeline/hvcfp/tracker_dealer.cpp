@@ -14,16 +14,28 @@
 #include <sys/types.h>
 #include <unistd.h>
 #include <math.h>
+#include <stdlib.h>
+#include <atomic>
 
 #include "utils/io.hpp"
+#include "utils/frame_utils.hpp"
 #include "tracker_dealer.h"
 #include "utils/jenc.h"
+#include "utils/quality.h"
 #include "utils/logger.h"
 
 using namespace std;
 
 #define PUSH_DIE_FORCE_TIMEOUT 5000
 #define STRATEGY_BEST_MIN_PUSH_COUNT 2
+#define PUSH_CACHE_BUDGET_ENV_STR "SKEL_FRAME_CACHE_BUDGET_SET"
+#define PUSH_COPY_WIDTH_ALIGN 16
+#define PUSH_COPY_PANORA_WIDTH 1920
+#define PUSH_COPY_PANORA_HEIGHT 1080
+#define PUSH_COPY_CLASS_MIN (16 << 10)
+#define PUSH_COPY_CLASS_NUM 9                   // up to 4MB, a 1080p nv12 panorama
+#define PUSH_COPY_CLASS_CACHE 8
+#define PUSH_COPY_POOL_BYTES (16 << 20)
 
 #define PUSH_JENC_REL(p) \
             if (p) { \
@@ -31,12 +43,13 @@ using namespace std;
                 p = nullptr; \
             }
 
-static std::unordered_map<std::string, AX_SKEL_CROP_ENCODER_THRESHOLD_CONFIG_T> s_stEncoderScaleDefaultMaps = {
-        {"body", {0.1, 0.1, 0.1, 0.1}}, // => 1.2
-        {"vehicle", {0.1, 0.1, 0.1, 0.1}}, // => 1.2
-        {"cycle", {0.1, 0.1, 0.1, 0.1}}, // => 1.2
-        {"face", {0.25, 0.25, 0.25, 0.25}}, // => 1.5
-        {"plate", {1, 1, 1, 1}} // => 3
+// indexed by SKEL_LABEL_E
+static const AX_SKEL_CROP_ENCODER_THRESHOLD_CONFIG_T s_stEncoderScaleDefault[skel::utils::SKEL_LABEL_MAX] = {
+        {0.1, 0.1, 0.1, 0.1}, // body => 1.2
+        {0.1, 0.1, 0.1, 0.1}, // vehicle => 1.2
+        {0.1, 0.1, 0.1, 0.1}, // cycle => 1.2
+        {0.25, 0.25, 0.25, 0.25}, // face => 1.5
+        {1, 1, 1, 1} // plate => 3
 };
 
 // Normalization
@@ -49,300 +62,550 @@ static AX_BOOL TrackEliminationStrategy(const AX_SKEL_FRAME_T *pstFrame, const A
     return AX_FALSE;
 }
 
+// object region expanded by the label scale, what the crop jpeg shows
+static AX_SKEL_RECT_T PushCropRect(AX_S32 nLabel, const AX_SKEL_RECT_T &stObjectRect) {
+    AX_SKEL_CROP_ENCODER_THRESHOLD_CONFIG_T stEncoderScaleSet = {};
+    if (nLabel >= 0) {
+        stEncoderScaleSet = s_stEncoderScaleDefault[nLabel];
+    }
+
+    AX_SKEL_RECT_T stRect = stObjectRect;
+    stRect.fX = stRect.fX - stRect.fW * stEncoderScaleSet.fScaleLeft;
+    stRect.fY = stRect.fY - stRect.fH * stEncoderScaleSet.fScaleTop;
+    stRect.fW = stRect.fW * (1 + stEncoderScaleSet.fScaleLeft + stEncoderScaleSet.fScaleRight);
+    stRect.fH = stRect.fH * (1 + stEncoderScaleSet.fScaleTop + stEncoderScaleSet.fScaleBottom);
+
+    return stRect;
+}
+
+// stRect inside the frame, no smaller than venc takes and the width aligned for the copy stride,
+// so the copy is a plain crop without scaling
+static AX_BOOL PushCopyRect(const AX_VIDEO_FRAME_T &stFrame, const AX_SKEL_RECT_T &stRect, skel::infer::Rect &stCopyRect) {
+    AX_S32 nFrameW = (AX_S32)stFrame.u32Width;
+    AX_S32 nFrameH = (AX_S32)stFrame.u32Height;
+
+    AX_S32 nW = ALIGN_UP(AX_MAX((AX_S32)stRect.fW, SKEL_VENC_MIN_WIDTH), PUSH_COPY_WIDTH_ALIGN);
+    AX_S32 nH = ALIGN_UP(AX_MAX((AX_S32)stRect.fH, SKEL_VENC_MIN_HEIGHT), 2);
+    nW = AX_MIN(nW, ALIGN_DOWN(nFrameW, PUSH_COPY_WIDTH_ALIGN));
+    nH = AX_MIN(nH, ALIGN_DOWN(nFrameH, 2));
+
+    if (nW < SKEL_VENC_MIN_WIDTH || nH < SKEL_VENC_MIN_HEIGHT) {
+        return AX_FALSE;
+    }
+
+    AX_S32 nX = ALIGN_DOWN(AX_MAX((AX_S32)stRect.fX, 0), 2);
+    AX_S32 nY = ALIGN_DOWN(AX_MAX((AX_S32)stRect.fY, 0), 2);
+    nX = AX_MIN(nX, ALIGN_DOWN(nFrameW - nW, 2));
+    nY = AX_MIN(nY, ALIGN_DOWN(nFrameH - nH, 2));
+
+    stCopyRect = skel::infer::Rect(nX, nY, nW, nH);
+
+    return AX_TRUE;
+}
+
+// shrinks nWidth x nHeight to resize_panorama_encoder_config, the aspect of the frame is kept.
+// a side up to 1 is a ratio of the frame side, above 1 a size in pixels, 0 is free
+static AX_BOOL PushPanoraSize(const AX_SKEL_RESIZE_CONFIG_T &stResize, const AX_VIDEO_FRAME_T &stFrame, AX_U32 &nWidth, AX_U32 &nHeight) {
+    if (stResize.fW <= 0 && stResize.fH <= 0) {
+        return AX_FALSE;
+    }
+
+    AX_F32 fScale = 1.0f;
+    if (stResize.fW > 0) {
+        fScale = AX_MIN(fScale, (stResize.fW <= 1) ? stResize.fW : stResize.fW / stFrame.u32Width);
+    }
+    if (stResize.fH > 0) {
+        fScale = AX_MIN(fScale, (stResize.fH <= 1) ? stResize.fH : stResize.fH / stFrame.u32Height);
+    }
+
+    AX_U32 nScaleWidth = ALIGN_DOWN((AX_U32)(stFrame.u32Width * fScale), PUSH_COPY_WIDTH_ALIGN);
+    AX_U32 nScaleHeight = ALIGN_DOWN((AX_U32)(stFrame.u32Height * fScale), 2);
+
+    if (nScaleWidth < SKEL_VENC_MIN_WIDTH || nScaleHeight < SKEL_VENC_MIN_HEIGHT
+        || nScaleWidth >= nWidth || nScaleHeight >= nHeight) {
+        return AX_FALSE;
+    }
+
+    nWidth = nScaleWidth;
+    nHeight = nScaleHeight;
+
+    return AX_TRUE;
+}
+
+// best shot: the pixel free bound is checked first, the laplacian only runs for a candidate that can still win.
+// an old item with no confidence left (push failed) is always replaced
+static AX_BOOL TrackQualityStrategy(const AX_SKEL_FRAME_T *pstFrame, AX_S32 nLabel, const AX_SKEL_OBJECT_ITEM_T &stObjectItemNew, const AX_SKEL_OBJECT_ITEM_T &stObjectItemOld,
+                                    AX_F32 fQualityOld, AX_F32 &fQuality, AX_F32 &fSharpness) {
+    AX_BOOL bOldValid = (stObjectItemOld.fConfidence > 0) ? AX_TRUE : AX_FALSE;
+    AX_F32 fBound = skel::utils::QualityBound(pstFrame->stFrame, stObjectItemNew.stRect, nLabel, stObjectItemNew.fConfidence);
+
+    fQuality = fBound;
+    fSharpness = -1;
+
+    if (bOldValid && fBound <= fQualityOld) {
+        return AX_FALSE;
+    }
+
+    fSharpness = skel::utils::Sharpness(pstFrame->stFrame, stObjectItemNew.stRect);
+    fQuality = skel::utils::QualityScore(fBound, fSharpness);
+
+    if (!bOldValid || fQuality > fQualityOld) {
+        return AX_TRUE;
+    }
+
+    return AX_FALSE;
+}
+
+// frames pinned by the push caches of all handles, and the streams pinning them
+static std::atomic<AX_U32> s_nCachePinnedGlobal(0);
+static std::atomic<AX_U32> s_nCacheStreamsGlobal(0);
+
 namespace skel {
     namespace utils {
-        TrackerDealer::TrackerDealer(AX_SKEL_PARAM_T stParam) : m_stParam (stParam) {
-            m_TrackMaps.clear();
-            m_FrameMaps.clear();
-            m_CacheListVec.clear();
+        TrackerDealer::TrackerDealer(AX_SKEL_PARAM_T stParam) : m_Param (stParam) {
+            m_PushStreams.clear();
+
+            m_nCachePinned = 0;
+            m_nCacheStreams = 0;
+            m_nCacheBytes = 0;
+            m_nBudgetEvicts = 0;
+            m_nBudgetGlobal = 0;
+            m_nCopyBytes = 0;
+            m_nEncodeDrops = 0;
+            m_nCopyCached = 0;
+            m_vecCopyFree.resize(PUSH_COPY_CLASS_NUM);
+
+            const char *strBudgetEnvStr = getenv(PUSH_CACHE_BUDGET_ENV_STR);
+            if (strBudgetEnvStr) {
+                m_nBudgetGlobal = (AX_U32)atoi(strBudgetEnvStr);
+            }
+
+            m_Rate.Configure(stParam.nPushByteRate, (AX_U32)stParam.fCropEncoderQpLevel);
+
+            m_EncodeWorkers.Start(AX_MAX(stParam.nPushEncodeWorkerNum, 1U));
         }
 
         TrackerDealer::~TrackerDealer(AX_VOID) {
+            // pending encode jobs finish first, they still reach the maps
+            m_EncodeWorkers.Stop();
+
             Statistics();
 
             ClearPush();
+
+            for (auto &vecFree : m_vecCopyFree) {
+                for (auto &stBlock : vecFree) {
+                    FreeFrame(stBlock);
+                }
+            }
+            m_vecCopyFree.clear();
         }
 
-        AX_S32 TrackerDealer::ClearPush(AX_VOID) {
-            for (auto iterStream = m_TrackMaps.begin(); iterStream != m_TrackMaps.end();) {
-                for (auto iter = iterStream->second.begin(); iter != iterStream->second.end();) {
-                    // release jenc buffer
-                    PUSH_JENC_REL(iter->second.stObjectItem.stCropFrame.pFrameData);
+        AX_BOOL TrackerDealer::GetPushPolicy(AX_SKEL_PUSH_MODE_E ePushMode, AX_SKEL_PUSH_POLICY_T &stPolicy) {
+            switch (ePushMode) {
+                case AX_SKEL_PUSH_MODE_FAST:
+                    stPolicy = {AX_TRUE, AX_FALSE, AX_TRUE, AX_FALSE, AX_FALSE};
+                    return AX_TRUE;
 
-                    FrameDelete(iterStream->first, iter->second.stObjectItem.nFrameId, iter->first);
+                case AX_SKEL_PUSH_MODE_INTERVAL:
+                    stPolicy = {AX_TRUE, AX_TRUE, AX_TRUE, AX_FALSE, AX_FALSE};
+                    return AX_TRUE;
 
-                    iterStream->second.erase(iter++);
-                }
+                case AX_SKEL_PUSH_MODE_BEST:
+                    stPolicy = {AX_FALSE, AX_FALSE, AX_FALSE, AX_TRUE, AX_TRUE};
+                    return AX_TRUE;
 
-                m_TrackMaps.erase(iterStream++);
+                default:
+                    break;
             }
 
-            for (auto iterStream = m_FrameMaps.begin(); iterStream != m_FrameMaps.end();) {
-                for (auto iter = iterStream->second.begin(); iter != iterStream->second.end();) {
-                    // release jenc buffer
-                    PUSH_JENC_REL(iter->second.stPanoraFrame.pFrameData);
+            return AX_FALSE;
+        }
 
-                    if (!iter->second.stCacheFrame.bFrameDrop) {
-                        dec_io_ref_cnt(iter->second.stCacheFrame.stFrame);
-                        iter->second.stCacheFrame.bFrameDrop = AX_TRUE;
-                    }
+        AX_VOID TrackerDealer::ClearStream(AX_SKEL_PUSH_STREAM_T &stStream) {
+            for (auto iter = stStream.mapTracks.begin(); iter != stStream.mapTracks.end(); ++ iter) {
+                // release jenc buffer
+                PUSH_JENC_REL(iter->second->stObjectItem.stCropFrame.pFrameData);
+                PUSH_JENC_REL(iter->second->stObjectItem.stPanoraFrame.pFrameData);
 
-                    iter->second.liTrackList.clear();
+                stStream.poolTracks.Free(iter->second);
+            }
+
+            // collected, not submitted yet
+            for (auto &stBatch : stStream.vecEncodeBatch) {
+                for (auto &stJob : stBatch.vecJobs) {
+                    PUSH_JENC_REL(stJob.stCropFrame.pFrameData);
+                    PUSH_JENC_REL(stJob.stPanoraFrame.pFrameData);
+                }
+            }
 
-                    iterStream->second.erase(iter++);
+            for (auto &stObjectItem : stStream.vecPushDone) {
+                PUSH_JENC_REL(stObjectItem.stCropFrame.pFrameData);
+                PUSH_JENC_REL(stObjectItem.stPanoraFrame.pFrameData);
+            }
+
+            for (auto pFrame : stStream.vecCacheRing) {
+                if (pFrame) {
+                    CacheUnpin(stStream, pFrame);
                 }
+            }
 
-                m_FrameMaps.erase(iterStream++);
+            for (auto iter = stStream.mapFrames.begin(); iter != stStream.mapFrames.end(); ++ iter) {
+                FrameRelease(stStream, iter->second);
             }
 
-            m_TrackMaps.clear();
-            m_FrameMaps.clear();
-            m_CacheListVec.clear();
+            stStream.mapTracks.clear();
+            stStream.mapFrames.clear();
+            stStream.vecEncodeBatch.clear();
+            stStream.vecPushDone.clear();
 
-            return AX_SKEL_SUCC;
+            stStream.vecCacheRing.clear();
+            stStream.nCacheHead = 0;
+            stStream.nCacheCount = 0;
+
+            // leaves the cache list of the results
+            stStream.bCacheChanged = AX_TRUE;
+            StreamPublish(stStream);
         }
 
-        AX_S32 TrackerDealer::UpdateFast(const AX_SKEL_FRAME_T *pstFrame, AX_SKEL_OBJECT_ITEM_T &stObjectItem) {
-            auto &trackMap = m_TrackMaps[pstFrame->nStreamId];
-            auto &frameMap = m_FrameMaps[pstFrame->nStreamId];
-            AX_U64 nTrackId = stObjectItem.nTrackId;
-            auto nowTime = std::chrono::steady_clock::now();
+        AX_S32 TrackerDealer::ClearPush(AX_VOID) {
+            std::unordered_map<AX_U32, PushStreamPtr> mapStreams;
+            {
+                std::lock_guard<std::mutex> lck(m_mtxMaps);
+                mapStreams.swap(m_PushStreams);
+            }
 
-            switch (stObjectItem.eTrackState) {
-                case AX_SKEL_TRACK_STATUS_NEW:
-                {
-                    // new TrackId map
-                    auto &stTrackMap = trackMap[nTrackId];
+            // out of the map already, a holder sees bClosed and looks the stream up again
+            for (auto iterStream = mapStreams.begin(); iterStream != mapStreams.end(); ++ iterStream) {
+                std::lock_guard<std::mutex> lck(iterStream->second->mtx);
+                ClearStream(*iterStream->second);
+                iterStream->second->bClosed = AX_TRUE;
+            }
 
-                    stTrackMap.stObjectItem = stObjectItem;
-                    stTrackMap.stObjectItem.nPointSetSize = 0;
-                    stTrackMap.stObjectItem.pstPointSet = nullptr;
-                    stTrackMap.eTrackLastState = stObjectItem.eTrackState;
-                    stTrackMap.updateTime = nowTime;
+            return AX_SKEL_SUCC;
+        }
 
-                    // new Frame map
-                    auto &stFrameMap = frameMap[pstFrame->nFrameId];
-                    stFrameMap.liTrackList.push_back(nTrackId);
-                    stFrameMap.stCacheFrame.nFrameId = pstFrame->nFrameId;
-                    stFrameMap.stCacheFrame.stFrame = pstFrame->stFrame;
-                    stFrameMap.stCacheFrame.bFrameDrop = AX_FALSE;
+        AX_S32 TrackerDealer::CloseStream(AX_U32 nStreamId) {
+            PushStreamPtr pStream;
+            {
+                std::lock_guard<std::mutex> lck(m_mtxMaps);
+                m_ClosedStreams.insert(nStreamId);
+
+                auto iterStream = m_PushStreams.find(nStreamId);
+                if (iterStream == m_PushStreams.end()) {
+                    return AX_SKEL_SUCC;
                 }
-                    break;
 
-                case AX_SKEL_TRACK_STATUS_UPDATE:
+                pStream = iterStream->second;
+                m_PushStreams.erase(iterStream);
+            }
+
+            std::lock_guard<std::mutex> lck(pStream->mtx);
+            ClearStream(*pStream);
+            pStream->bClosed = AX_TRUE;
+
+            return AX_SKEL_SUCC;
+        }
+
+        AX_S32 TrackerDealer::OpenStream(AX_U32 nStreamId) {
+            std::lock_guard<std::mutex> lck(m_mtxMaps);
+            m_ClosedStreams.erase(nStreamId);
+
+            return AX_SKEL_SUCC;
+        }
+
+        PushStreamPtr TrackerDealer::StreamLock(AX_U32 nStreamId, AX_BOOL bCreate, std::unique_lock<std::mutex> &lck) {
+            while (1) {
+                PushStreamPtr pStream;
                 {
-                    AX_SKEL_CROP_FRAME_T stCropFrame;
+                    std::lock_guard<std::mutex> lckMaps(m_mtxMaps);
 
-                    if (!TrackFind(pstFrame->nStreamId, nTrackId, stCropFrame)) {
-                        // not found, do nothing
+                    auto iterStream = m_PushStreams.find(nStreamId);
+                    if (iterStream != m_PushStreams.end()) {
+                        pStream = iterStream->second;
+                    }
+                    else if (bCreate && m_ClosedStreams.find(nStreamId) == m_ClosedStreams.end()) {
+                        pStream = std::make_shared<AX_SKEL_PUSH_STREAM_T>();
+                        pStream->nStreamId = nStreamId;
+                        m_PushStreams[nStreamId] = pStream;
                     }
                     else {
-                        // push count
-                        if (trackMap[nTrackId].nPushCounts >= m_stParam.stPushStrategy.nPushCounts) {
-                            return TrackDelete(pstFrame->nStreamId, nTrackId, AX_TRUE);
-                        }
-
-                        // update track
-                        if (TrackEliminationStrategy(pstFrame, stObjectItem, trackMap[nTrackId].stObjectItem)) {
-                            AX_U32 nUpdateCounts = trackMap[nTrackId].nUpdateCounts;
-                            AX_U32 nPushCounts = trackMap[nTrackId].nPushCounts;
-                            std::chrono::steady_clock::time_point pushTime = trackMap[nTrackId].pushTime;
-
-                            // new TrackId map
-                            TrackDelete(pstFrame->nStreamId, nTrackId);
-
-                            auto &stTrackMap = trackMap[nTrackId];
-                            stTrackMap.stObjectItem = stObjectItem;
-                            stTrackMap.stObjectItem.nPointSetSize = 0;
-                            stTrackMap.stObjectItem.pstPointSet = nullptr;
-                            stTrackMap.eTrackLastState = stObjectItem.eTrackState;
-                            stTrackMap.nUpdateCounts = nUpdateCounts + 1;
-                            stTrackMap.nPushCounts = nPushCounts;
-                            stTrackMap.pushTime = pushTime;
-                            stTrackMap.updateTime = nowTime;
-
-                            // new Frame map
-                            auto &stFrameMap = frameMap[pstFrame->nFrameId];
-                            stFrameMap.liTrackList.push_back(nTrackId);
-                            stFrameMap.stCacheFrame.nFrameId = pstFrame->nFrameId;
-                            stFrameMap.stCacheFrame.stFrame = pstFrame->stFrame;
-                            stFrameMap.stCacheFrame.bFrameDrop = AX_FALSE;
-                        }
-                        else {
-                            trackMap[nTrackId].nUpdateCounts ++;
-                            trackMap[nTrackId].eTrackLastState = stObjectItem.eTrackState;
-                            trackMap[nTrackId].stObjectItem.eTrackState = stObjectItem.eTrackState;
-                            trackMap[nTrackId].updateTime = nowTime;
-                        }
+                        return nullptr;
                     }
                 }
-                    break;
 
-                case AX_SKEL_TRACK_STATUS_DIE:
-                {
-                    return TrackDelete(pstFrame->nStreamId, nTrackId, AX_TRUE);
+                lck = std::unique_lock<std::mutex>(pStream->mtx);
+
+                // closed while we waited
+                if (!pStream->bClosed) {
+                    return pStream;
                 }
-                    break;
 
-                default:
-                    break;
+                lck.unlock();
             }
+        }
 
-            return AX_SKEL_SUCC;
+        AX_VOID TrackerDealer::StreamParam(AX_SKEL_PUSH_STREAM_T &stStream, AX_U64 nFrameId) {
+            // one snapshot for every object of a frame, taken by its first Update or by its Finalize,
+            // so a SetConfig in between takes effect from the next frame
+            if (!stStream.bFrameParam || stStream.nParamFrameId != nFrameId) {
+                stStream.pParam = m_Param.Load();
+                stStream.bFrameParam = AX_TRUE;
+                stStream.nParamFrameId = nFrameId;
+            }
         }
 
-        AX_S32 TrackerDealer::UpdateInterval(const AX_SKEL_FRAME_T *pstFrame, AX_SKEL_OBJECT_ITEM_T &stObjectItem) {
-            auto &trackMap = m_TrackMaps[pstFrame->nStreamId];
-            auto &frameMap = m_FrameMaps[pstFrame->nStreamId];
-            AX_U64 nTrackId = stObjectItem.nTrackId;
-            auto nowTime = std::chrono::steady_clock::now();
+        AX_VOID TrackerDealer::StreamPublish(AX_SKEL_PUSH_STREAM_T &stStream) {
+            // a frame with no cache change publishes nothing
+            if (!stStream.bCacheChanged) {
+                return;
+            }
+            stStream.bCacheChanged = AX_FALSE;
 
-            switch (stObjectItem.eTrackState) {
-                case AX_SKEL_TRACK_STATUS_NEW:
-                {
-                    // new TrackId map
-                    auto &stTrackMap = trackMap[nTrackId];
-                    stTrackMap.stObjectItem = stObjectItem;
-                    stTrackMap.stObjectItem.nPointSetSize = 0;
-                    stTrackMap.stObjectItem.pstPointSet = nullptr;
-                    stTrackMap.eTrackLastState = stObjectItem.eTrackState;
-                    stTrackMap.updateTime = nowTime;
-                    stTrackMap.pushTime = nowTime;
+            auto pCacheList = std::make_shared<std::vector<AX_SKEL_FRAME_CACHE_LIST_T>>();
+            AX_U32 nRingSize = stStream.vecCacheRing.size();
 
-                    // new Frame map
-                    auto &stFrameMap = frameMap[pstFrame->nFrameId];
-                    stFrameMap.liTrackList.push_back(nTrackId);
-                    stFrameMap.stCacheFrame.nFrameId = pstFrame->nFrameId;
-                    stFrameMap.stCacheFrame.stFrame = pstFrame->stFrame;
-                    stFrameMap.stCacheFrame.bFrameDrop = AX_FALSE;
+            pCacheList->reserve(stStream.nCachePinned);
+
+            // newest first
+            for (AX_U32 i = stStream.nCacheCount; i > 0; i--) {
+                AX_SKEL_PUSH_FRAME_T *pFrame = stStream.vecCacheRing[(stStream.nCacheHead + i - 1) % nRingSize];
+
+                if (pFrame) {
+                    AX_SKEL_FRAME_CACHE_LIST_T cacheItem;
+                    cacheItem.nFrameId = pFrame->stCacheFrame.nFrameId;
+                    cacheItem.nStreamId = stStream.nStreamId;
+                    pCacheList->push_back(cacheItem);
                 }
-                    break;
+            }
 
-                case AX_SKEL_TRACK_STATUS_UPDATE:
-                {
-                    AX_SKEL_CROP_FRAME_T stCropFrame;
+            // the other streams only swap their list pointers, their frames are not copied again
+            std::lock_guard<std::mutex> lck(m_mtxCacheLists);
+            if (pCacheList->empty()) {
+                m_mapCacheLists.erase(stStream.nStreamId);
+            }
+            else {
+                m_mapCacheLists[stStream.nStreamId] = pCacheList;
+            }
 
-                    if (!TrackFind(pstFrame->nStreamId, nTrackId, stCropFrame)) {
-                        // not found, do nothing
-                    }
-                    else {
-                        // push count
-                        if (trackMap[nTrackId].nPushCounts >= m_stParam.stPushStrategy.nPushCounts) {
-                            return TrackDelete(pstFrame->nStreamId, nTrackId, AX_TRUE);
-                        }
+            auto pCacheLists = std::make_shared<std::vector<PushCacheListPtr>>();
+            pCacheLists->reserve(m_mapCacheLists.size());
+            for (auto iter = m_mapCacheLists.begin(); iter != m_mapCacheLists.end(); ++ iter) {
+                pCacheLists->push_back(iter->second);
+            }
 
-                        // update track
-                        if (TrackEliminationStrategy(pstFrame, stObjectItem, trackMap[nTrackId].stObjectItem)) {
-                            AX_U32 nUpdateCounts = trackMap[nTrackId].nUpdateCounts;
-                            AX_U32 nPushCounts = trackMap[nTrackId].nPushCounts;
-                            std::chrono::steady_clock::time_point pushTime = trackMap[nTrackId].pushTime;
-
-                            // new TrackId map
-                            TrackDelete(pstFrame->nStreamId, nTrackId);
-
-                            auto &stTrackMap = trackMap[nTrackId];
-                            stTrackMap.stObjectItem = stObjectItem;
-                            stTrackMap.stObjectItem.nPointSetSize = 0;
-                            stTrackMap.stObjectItem.pstPointSet = nullptr;
-                            stTrackMap.eTrackLastState = stObjectItem.eTrackState;
-                            stTrackMap.nUpdateCounts = nUpdateCounts + 1;
-                            stTrackMap.nPushCounts = nPushCounts;
-                            stTrackMap.pushTime = pushTime;
-                            stTrackMap.updateTime = nowTime;
-
-                            // new Frame map
-                            auto &stFrameMap = frameMap[pstFrame->nFrameId];
-                            stFrameMap.liTrackList.push_back(nTrackId);
-                            stFrameMap.stCacheFrame.nFrameId = pstFrame->nFrameId;
-                            stFrameMap.stCacheFrame.stFrame = pstFrame->stFrame;
-                            stFrameMap.stCacheFrame.bFrameDrop = AX_FALSE;
-                        }
-                        else {
-                            trackMap[nTrackId].nUpdateCounts ++;
-                            trackMap[nTrackId].eTrackLastState = stObjectItem.eTrackState;
-                            trackMap[nTrackId].stObjectItem.eTrackState = stObjectItem.eTrackState;
-                            trackMap[nTrackId].updateTime = nowTime;
-                        }
-                    }
-                }
-                    break;
+            std::atomic_store(&m_pCacheLists, PushCacheListsPtr(pCacheLists));
+        }
 
-                case AX_SKEL_TRACK_STATUS_DIE:
-                {
-                    return TrackDelete(pstFrame->nStreamId, nTrackId, AX_TRUE);
+        AX_SKEL_PUSH_TRACK_T* TrackerDealer::TrackFind(AX_SKEL_PUSH_STREAM_T &stStream, AX_U64 nTrackId) {
+            auto iter = stStream.mapTracks.find(nTrackId);
+
+            return (iter != stStream.mapTracks.end()) ? iter->second : nullptr;
+        }
+
+        AX_VOID TrackerDealer::TrackLink(AX_SKEL_PUSH_STREAM_T &stStream, AX_SKEL_PUSH_TRACK_T *pTrack, const AX_SKEL_FRAME_T *pstFrame) {
+            auto &pFrame = stStream.mapFrames[pstFrame->nFrameId];
+            if (!pFrame) {
+                pFrame = stStream.poolFrames.Alloc();
+                pFrame->stCacheFrame.nFrameId = pstFrame->nFrameId;
+                pFrame->stCacheFrame.stFrame = pstFrame->stFrame;
+                pFrame->stCacheFrame.bFrameDrop = AX_FALSE;
+            }
+
+            pTrack->pFrame = pFrame;
+            pTrack->pPrev = nullptr;
+            pTrack->pNext = pFrame->pTrackHead;
+            if (pFrame->pTrackHead) {
+                pFrame->pTrackHead->pPrev = pTrack;
+            }
+            pFrame->pTrackHead = pTrack;
+            pFrame->nRefCount ++;
+        }
+
+        AX_VOID TrackerDealer::TrackUnlink(AX_SKEL_PUSH_STREAM_T &stStream, AX_SKEL_PUSH_TRACK_T *pTrack) {
+            AX_SKEL_PUSH_FRAME_T *pFrame = pTrack->pFrame;
+            if (!pFrame) {
+                return;
+            }
+
+            if (pTrack->pPrev) {
+                pTrack->pPrev->pNext = pTrack->pNext;
+            }
+            else {
+                pFrame->pTrackHead = pTrack->pNext;
+            }
+            if (pTrack->pNext) {
+                pTrack->pNext->pPrev = pTrack->pPrev;
+            }
+
+            pTrack->pFrame = nullptr;
+            pTrack->pPrev = nullptr;
+            pTrack->pNext = nullptr;
+
+            // last track of the frame
+            if (-- pFrame->nRefCount == 0) {
+                if (pFrame->nCacheSlot >= 0) {
+                    stStream.vecCacheRing[pFrame->nCacheSlot] = nullptr;
+                    stStream.bCacheChanged = AX_TRUE;
+                    CacheUnpin(stStream, pFrame);
                 }
-                    break;
 
-                default:
-                    break;
+                stStream.mapFrames.erase(pFrame->stCacheFrame.nFrameId);
+                FrameRelease(stStream, pFrame);
+            }
+        }
+
+        AX_VOID TrackerDealer::FrameRelease(AX_SKEL_PUSH_STREAM_T &stStream, AX_SKEL_PUSH_FRAME_T *pFrame) {
+            PUSH_JENC_REL(pFrame->stPanoraFrame.pFrameData);
+
+            if (!pFrame->stCacheFrame.bFrameDrop) {
+                dec_io_ref_cnt(pFrame->stCacheFrame.stFrame);
+                pFrame->stCacheFrame.bFrameDrop = AX_TRUE;
             }
 
-            return AX_SKEL_SUCC;
+            stStream.poolFrames.Free(pFrame);
+        }
+
+        AX_VOID TrackerDealer::TrackRelease(AX_SKEL_PUSH_STREAM_T &stStream, AX_SKEL_PUSH_TRACK_T *pTrack) {
+            // release jenc buffer
+            PUSH_JENC_REL(pTrack->stObjectItem.stCropFrame.pFrameData);
+            PUSH_JENC_REL(pTrack->stObjectItem.stPanoraFrame.pFrameData);
+            pTrack->pCropCopy.reset();
+
+            // clear panoraFrame buffer
+            TrackUnlink(stStream, pTrack);
+
+            pTrack->stObjectItem.bPanoraFrame = AX_FALSE;
+            memset(&pTrack->stObjectItem.stPanoraFrame, 0x00, sizeof(pTrack->stObjectItem.stPanoraFrame));
+        }
+
+        AX_VOID TrackerDealer::TrackErase(AX_SKEL_PUSH_STREAM_T &stStream, AX_SKEL_PUSH_TRACK_T *pTrack) {
+            TrackRelease(stStream, pTrack);
+
+            stStream.mapTracks.erase(pTrack->nTrackId);
+            stStream.poolTracks.Free(pTrack);
+        }
+
+        AX_BOOL TrackerDealer::TrackDelete(AX_SKEL_PUSH_STREAM_T &stStream, AX_SKEL_PUSH_TRACK_T *pTrack, AX_BOOL bForce/* = AX_FALSE*/) {
+            // release track map
+            if (((stStream.pParam->Param().stPushStrategy.ePushMode == AX_SKEL_PUSH_MODE_FAST
+                  || stStream.pParam->Param().stPushStrategy.ePushMode == AX_SKEL_PUSH_MODE_INTERVAL)
+                 && pTrack->nPushCounts >= stStream.pParam->Param().stPushStrategy.nPushCounts)
+                || stStream.pParam->Param().stPushStrategy.ePushMode == AX_SKEL_PUSH_MODE_BEST
+                || bForce) {
+                TrackErase(stStream, pTrack);
+                return AX_TRUE;
+            }
+
+            TrackRelease(stStream, pTrack);
+
+            return AX_FALSE;
         }
 
-        AX_S32 TrackerDealer::UpdateBest(const AX_SKEL_FRAME_T *pstFrame, AX_SKEL_OBJECT_ITEM_T &stObjectItem) {
-            auto &trackMap = m_TrackMaps[pstFrame->nStreamId];
-            auto &frameMap = m_FrameMaps[pstFrame->nStreamId];
-            AX_U64 nTrackId = stObjectItem.nTrackId;
+        AX_S32 TrackerDealer::UpdateTrack(AX_SKEL_PUSH_STREAM_T &stStream, const AX_SKEL_FRAME_T *pstFrame, AX_SKEL_OBJECT_ITEM_T &stObjectItem, const AX_SKEL_PUSH_POLICY_T &stPolicy, AX_BOOL bDetected) {
+            AX_SKEL_PUSH_TRACK_T *pTrack = TrackFind(stStream, stObjectItem.nTrackId);
             auto nowTime = std::chrono::steady_clock::now();
+            AX_F32 fQuality = stObjectItem.fConfidence;
+            AX_F32 fSharpness = -1;
+
+            // the kalman box of a frame skipped by detection is not scored, cropped nor pushed,
+            // it only keeps the track from being forced to die
+            if (!bDetected) {
+                if (pTrack) {
+                    pTrack->updateTime = nowTime;
+                }
+
+                return AX_SKEL_SUCC;
+            }
 
             switch (stObjectItem.eTrackState) {
                 case AX_SKEL_TRACK_STATUS_NEW:
                 {
                     // new TrackId map
-                    auto &stTrackMap = trackMap[nTrackId];
-                    stTrackMap.stObjectItem = stObjectItem;
-                    stTrackMap.stObjectItem.nPointSetSize = 0;
-                    stTrackMap.stObjectItem.pstPointSet = nullptr;
-                    stTrackMap.eTrackLastState = stObjectItem.eTrackState;
-                    stTrackMap.updateTime = nowTime;
+                    if (!pTrack) {
+                        pTrack = stStream.poolTracks.Alloc(stObjectItem.nTrackId);
+                        pTrack->nLabel = LabelIndex(stObjectItem.pstrObjectCategory);
+                        stStream.mapTracks[stObjectItem.nTrackId] = pTrack;
+                    }
+                    else {
+                        TrackRelease(stStream, pTrack);
+                    }
+
+                    if (stPolicy.bQualityScore) {
+                        AX_F32 fBound = QualityBound(pstFrame->stFrame, stObjectItem.stRect, pTrack->nLabel, stObjectItem.fConfidence);
+                        fSharpness = Sharpness(pstFrame->stFrame, stObjectItem.stRect);
+                        fQuality = QualityScore(fBound, fSharpness);
+                    }
+
+                    pTrack->stObjectItem = stObjectItem;
+                    pTrack->stObjectItem.nPointSetSize = 0;
+                    pTrack->stObjectItem.pstPointSet = nullptr;
+                    pTrack->fQuality = fQuality;
+                    if (pTrack->nLabel == SKEL_LABEL_FACE && fSharpness >= 0) {
+                        pTrack->stObjectItem.stFacePostBlur.fBlur = 1 - fSharpness;
+                    }
+                    pTrack->eTrackLastState = stObjectItem.eTrackState;
+                    pTrack->updateTime = nowTime;
+                    if (stPolicy.bPushTimeOnNew) {
+                        pTrack->pushTime = nowTime;
+                    }
 
                     // new Frame map
-                    auto &stFrameMap = frameMap[pstFrame->nFrameId];
-                    stFrameMap.liTrackList.push_back(nTrackId);
-                    stFrameMap.stCacheFrame.nFrameId = pstFrame->nFrameId;
-                    stFrameMap.stCacheFrame.stFrame = pstFrame->stFrame;
-                    stFrameMap.stCacheFrame.bFrameDrop = AX_FALSE;
+                    TrackLink(stStream, pTrack, pstFrame);
                 }
                     break;
 
                 case AX_SKEL_TRACK_STATUS_UPDATE:
                 case AX_SKEL_TRACK_STATUS_DIE:
                 {
-                    AX_SKEL_CROP_FRAME_T stCropFrame;
-
-                    if (!TrackFind(pstFrame->nStreamId, nTrackId, stCropFrame)) {
+                    if (!pTrack) {
                         // not found, do nothing
+                        break;
                     }
-                    else {
-                        // update track
-                        if (TrackEliminationStrategy(pstFrame, stObjectItem, trackMap[nTrackId].stObjectItem)) {
-                            AX_U32 nUpdateCounts = trackMap[nTrackId].nUpdateCounts;
-
-                            // new TrackId map
-                            TrackDelete(pstFrame->nStreamId, nTrackId);
-
-                            auto &stTrackMap = trackMap[nTrackId];
-                            stTrackMap.stObjectItem = stObjectItem;
-                            stTrackMap.stObjectItem.nPointSetSize = 0;
-                            stTrackMap.stObjectItem.pstPointSet = nullptr;
-                            stTrackMap.eTrackLastState = stObjectItem.eTrackState;
-                            stTrackMap.nUpdateCounts = nUpdateCounts + 1;
-                            stTrackMap.updateTime = nowTime;
-
-                            // new Frame map
-                            auto &stFrameMap = frameMap[pstFrame->nFrameId];
-                            stFrameMap.liTrackList.push_back(nTrackId);
-                            stFrameMap.stCacheFrame.nFrameId = pstFrame->nFrameId;
-                            stFrameMap.stCacheFrame.stFrame = pstFrame->stFrame;
-                            stFrameMap.stCacheFrame.bFrameDrop = AX_FALSE;
+
+                    if (stObjectItem.eTrackState == AX_SKEL_TRACK_STATUS_DIE && stPolicy.bDieDelete) {
+                        TrackErase(stStream, pTrack);
+                        break;
+                    }
+
+                    // push count
+                    if (stPolicy.bPushCountsLimit
+                        && pTrack->nPushCounts >= stStream.pParam->Param().stPushStrategy.nPushCounts) {
+                        TrackErase(stStream, pTrack);
+                        break;
+                    }
+
+                    // update track
+                    AX_BOOL bReplace = stPolicy.bQualityScore
+                                       ? TrackQualityStrategy(pstFrame, pTrack->nLabel, stObjectItem, pTrack->stObjectItem, pTrack->fQuality, fQuality, fSharpness)
+                                       : TrackEliminationStrategy(pstFrame, stObjectItem, pTrack->stObjectItem);
+
+                    if (bReplace) {
+                        TrackRelease(stStream, pTrack);
+
+                        pTrack->stObjectItem = stObjectItem;
+                        pTrack->stObjectItem.nPointSetSize = 0;
+                        pTrack->stObjectItem.pstPointSet = nullptr;
+                        pTrack->fQuality = fQuality;
+                        if (pTrack->nLabel == SKEL_LABEL_FACE && fSharpness >= 0) {
+                            pTrack->stObjectItem.stFacePostBlur.fBlur = 1 - fSharpness;
                         }
-                        else {
-                            trackMap[nTrackId].nUpdateCounts ++;
-                            trackMap[nTrackId].eTrackLastState = stObjectItem.eTrackState;
-                            trackMap[nTrackId].stObjectItem.eTrackState = stObjectItem.eTrackState;
-                            trackMap[nTrackId].updateTime = nowTime;
+                        pTrack->eTrackLastState = stObjectItem.eTrackState;
+                        pTrack->nUpdateCounts ++;
+                        pTrack->updateTime = nowTime;
+                        if (stPolicy.bRenewOnReplace) {
+                            pTrack->nPushCounts = 0;
+                            pTrack->pushTime = nowTime;
                         }
+
+                        // new Frame map
+                        TrackLink(stStream, pTrack, pstFrame);
+                    }
+                    else {
+                        pTrack->nUpdateCounts ++;
+                        pTrack->eTrackLastState = stObjectItem.eTrackState;
+                        pTrack->stObjectItem.eTrackState = stObjectItem.eTrackState;
+                        pTrack->updateTime = nowTime;
                     }
                 }
                     break;
@@ -354,136 +617,131 @@ namespace skel {
             return AX_SKEL_SUCC;
         }
 
-        AX_S32 TrackerDealer::Update(const AX_SKEL_FRAME_T *pstFrame, AX_SKEL_OBJECT_ITEM_T &stObjectItem) {
-            std::lock_guard<std::mutex> lck(m_mtxMaps);
-
+        AX_S32 TrackerDealer::Update(const AX_SKEL_FRAME_T *pstFrame, vector<AX_SKEL_OBJECT_ITEM_T> &vecObjectItem, AX_BOOL bDetected/* = AX_TRUE*/) {
             if (!pstFrame) {
                 ALOGE("nil pointer");
                 return AX_ERR_SKEL_NULL_PTR;
             }
 
-            switch (m_stParam.stPushStrategy.ePushMode) {
-                case AX_SKEL_PUSH_MODE_FAST:
-                {
-                    return UpdateFast(pstFrame, stObjectItem);
-                }
-                    break;
+            if (vecObjectItem.empty()) {
+                return AX_SKEL_SUCC;
+            }
 
-                case AX_SKEL_PUSH_MODE_INTERVAL:
-                {
-                    return UpdateInterval(pstFrame, stObjectItem);
-                }
-                    break;
+            std::unique_lock<std::mutex> lck;
+            PushStreamPtr pStream = StreamLock(pstFrame->nStreamId, AX_TRUE, lck);
+            if (!pStream) {
+                // a result of the stream converted after it was closed
+                return AX_SKEL_SUCC;
+            }
+            auto &stStream = *pStream;
+            StreamParam(stStream, pstFrame->nFrameId);
 
-                case AX_SKEL_PUSH_MODE_BEST:
-                {
-                    return UpdateBest(pstFrame, stObjectItem);
-                }
-                    break;
+            AX_SKEL_PUSH_POLICY_T stPolicy;
+            if (!GetPushPolicy(stStream.pParam->Param().stPushStrategy.ePushMode, stPolicy)) {
+                return AX_SKEL_SUCC;
+            }
 
-                default:
-                    break;
+            // per object only the lock of its own stream is held
+            for (auto &stObjectItem : vecObjectItem) {
+                UpdateTrack(stStream, pstFrame, stObjectItem, stPolicy, bDetected);
             }
 
             return AX_SKEL_SUCC;
         }
 
         AX_S32 TrackerDealer::Release(AX_U32 nStreamId, const AX_SKEL_OBJECT_ITEM_T &stObjectItem) {
-            std::lock_guard<std::mutex> lck(m_mtxMaps);
+            std::unique_lock<std::mutex> lck;
+            PushStreamPtr pStream = StreamLock(nStreamId, AX_FALSE, lck);
+            if (!pStream) {
+                return AX_SKEL_SUCC;
+            }
 
-            if (stObjectItem.bCropFrame) {
-                TrackDelete(nStreamId, stObjectItem.nTrackId);
+            auto &stStream = *pStream;
+
+            AX_SKEL_PUSH_TRACK_T *pTrack = TrackFind(stStream, stObjectItem.nTrackId);
+            if (!pTrack) {
+                return AX_SKEL_SUCC;
             }
 
             if (stObjectItem.bCropFrame) {
-                FrameDelete(nStreamId, stObjectItem.stCropFrame.nFrameId, stObjectItem.nTrackId);
+                TrackDelete(stStream, pTrack);
             }
-
-            if (stObjectItem.bPanoraFrame) {
-                FrameDelete(nStreamId, stObjectItem.stPanoraFrame.nFrameId, stObjectItem.nTrackId);
+            else if (stObjectItem.bPanoraFrame
+                     && pTrack->pFrame
+                     && pTrack->pFrame->stCacheFrame.nFrameId == stObjectItem.stPanoraFrame.nFrameId) {
+                TrackUnlink(stStream, pTrack);
             }
 
+            // if a cached frame was released
+            StreamPublish(stStream);
+
             return AX_SKEL_SUCC;
         }
 
-        AX_S32 TrackerDealer::FinalizeFast(AX_U32 nStreamId, vector<AX_SKEL_OBJECT_ITEM_T> &vecObjectItem, vector<AX_SKEL_PUSH_CACHE_LIST_T> &dropCacheListVec) {
+        AX_S32 TrackerDealer::FinalizeFast(AX_SKEL_PUSH_STREAM_T &stStream, vector<AX_SKEL_OBJECT_ITEM_T> &vecObjectItem, vector<AX_SKEL_PUSH_CACHE_LIST_T> &dropCacheListVec) {
             AX_S32 nRet = AX_SKEL_SUCC;
-            auto &trackMap = m_TrackMaps[nStreamId];
-            auto &frameMap = m_FrameMaps[nStreamId];
             auto nowTime = std::chrono::steady_clock::now();
 
             // 2. push track
-            for (auto iter = trackMap.begin(); iter != trackMap.end();) {
-                auto &stTrackMap = iter->second;
-                AX_SKEL_OBJECT_ITEM_T stObjectItem = stTrackMap.stObjectItem;
+            for (auto iter = stStream.mapTracks.begin(); iter != stStream.mapTracks.end(); ++ iter) {
+                AX_SKEL_PUSH_TRACK_T *pTrack = iter->second;
+                const AX_SKEL_OBJECT_ITEM_T &stObjectItem = pTrack->stObjectItem;
+
+                // the pending encode decides
+                if (pTrack->bEncoding) {
+                    continue;
+                }
 
                 switch (stObjectItem.eTrackState) {
                     case AX_SKEL_TRACK_STATUS_NEW:
                     {
-                        if (!PushFliter(stObjectItem)
+                        if (!PushFliter(stStream, pTrack, stObjectItem)
                             && stObjectItem.fConfidence > 0
-                            && FrameFind(nStreamId, stObjectItem.nFrameId)
-                            && stTrackMap.nPushCounts == 0) {
-                            nRet = TrackPush(nStreamId, frameMap[stObjectItem.nFrameId].stCacheFrame, stObjectItem);
+                            && pTrack->pFrame
+                            && pTrack->nPushCounts == 0) {
+                            nRet = TrackPush(stStream, pTrack, AX_TRUE, vecObjectItem);
 
                             if (nRet == AX_SKEL_SUCC) {
-                                stObjectItem.stRect = {0, 0, 0, 0};
-                                vecObjectItem.push_back(stObjectItem);
-
                                 // update push status
-                                stTrackMap.nPushCounts ++;
-                                stTrackMap.pushTime = nowTime;
-
-                                // reset confidence
-                                stTrackMap.stObjectItem.fConfidence = 0;
-                            }
-                            else {
-                                // reset object confidence
-                                stTrackMap.stObjectItem.fConfidence = 0;
+                                pTrack->nPushCounts ++;
+                                pTrack->pushTime = nowTime;
                             }
+
+                            // reset object confidence
+                            pTrack->stObjectItem.fConfidence = 0;
                         }
                     }
                         break;
 
                     case AX_SKEL_TRACK_STATUS_UPDATE:
                     {
-                        AX_S32 nElapsed = (AX_S32)(std::chrono::duration_cast<std::chrono::milliseconds>(nowTime - stTrackMap.pushTime).count());
+                        AX_S32 nElapsed = (AX_S32)(std::chrono::duration_cast<std::chrono::milliseconds>(nowTime - pTrack->pushTime).count());
 
-                        if (nElapsed >= (AX_S32)m_stParam.stPushStrategy.nIntervalTimes) {
-                            if (!PushFliter(stObjectItem)
+                        if (nElapsed >= (AX_S32)stStream.pParam->Param().stPushStrategy.nIntervalTimes) {
+                            if (!PushFliter(stStream, pTrack, stObjectItem)
                                 && stObjectItem.fConfidence > 0
-                                && FrameFind(nStreamId, stObjectItem.nFrameId)) {
-                                nRet = TrackPush(nStreamId, frameMap[stObjectItem.nFrameId].stCacheFrame, stObjectItem);
+                                && pTrack->pFrame) {
+                                nRet = TrackPush(stStream, pTrack, AX_TRUE, vecObjectItem);
 
                                 if (nRet == AX_SKEL_SUCC) {
-                                    stObjectItem.stRect = {0, 0, 0, 0};
-                                    vecObjectItem.push_back(stObjectItem);
-
                                     // update push status
-                                    stTrackMap.nPushCounts ++;
-                                    stTrackMap.pushTime = nowTime;
-
-                                    // reset object confidence
-                                    stTrackMap.stObjectItem.fConfidence = 0;
-                                }
-                                else {
-                                    // reset object confidence
-                                    stTrackMap.stObjectItem.fConfidence = 0;
+                                    pTrack->nPushCounts ++;
+                                    pTrack->pushTime = nowTime;
                                 }
+
+                                // reset object confidence
+                                pTrack->stObjectItem.fConfidence = 0;
                             }
                         }
-                        else {
-                            AX_U32 nDropCacheListSize = dropCacheListVec.size();
-
-                            for (size_t i = 0; i < nDropCacheListSize; i++) {
+                        else if (pTrack->pFrame) {
+                            for (size_t i = 0; i < dropCacheListVec.size(); i++) {
                                 // find
-                                if (stTrackMap.stObjectItem.nFrameId == dropCacheListVec[i].nFrameId
-                                    && FrameFind(nStreamId, stTrackMap.stObjectItem.nFrameId)) {
-                                    nRet = TrackPush(nStreamId, frameMap[stTrackMap.stObjectItem.nFrameId].stCacheFrame, stTrackMap.stObjectItem);
+                                if (pTrack->stObjectItem.nFrameId == dropCacheListVec[i].nFrameId) {
+                                    nRet = TrackPush(stStream, pTrack, AX_FALSE, vecObjectItem);
 
                                     if (nRet != AX_SKEL_SUCC) {
                                         // reset object confidence
-                                        stTrackMap.stObjectItem.fConfidence = 0;
+                                        pTrack->stObjectItem.fConfidence = 0;
                                     }
                                     break;
                                 }
@@ -495,29 +753,25 @@ namespace skel {
                     default:
                         break;
                 }
-
-                ++ iter;
             }
 
             // force drop track
-            for (auto iter = trackMap.begin(); iter != trackMap.end();) {
-                auto &stTrackMap = iter->second;
+            for (auto iter = stStream.mapTracks.begin(); iter != stStream.mapTracks.end();) {
+                AX_SKEL_PUSH_TRACK_T *pTrack = iter->second;
 
-                AX_S32 nElapsed = (AX_S32)(std::chrono::duration_cast<std::chrono::milliseconds>(nowTime - stTrackMap.updateTime).count());
+                AX_S32 nElapsed = (AX_S32)(std::chrono::duration_cast<std::chrono::milliseconds>(nowTime - pTrack->updateTime).count());
 
-                if (stTrackMap.eTrackLastState != AX_SKEL_TRACK_STATUS_DIE
+                if (pTrack->eTrackLastState != AX_SKEL_TRACK_STATUS_DIE
                     && nElapsed > PUSH_DIE_FORCE_TIMEOUT) {
-                    // release jenc buffer
-                    PUSH_JENC_REL(stTrackMap.stObjectItem.stCropFrame.pFrameData);
+                    TrackRelease(stStream, pTrack);
 
-                    FrameDelete(nStreamId, stTrackMap.stObjectItem.nFrameId, iter->first);
-
-                    stTrackMap.stObjectItem.eTrackState = AX_SKEL_TRACK_STATUS_DIE;
-                    vecObjectItem.push_back(stTrackMap.stObjectItem);
+                    pTrack->stObjectItem.eTrackState = AX_SKEL_TRACK_STATUS_DIE;
+                    vecObjectItem.push_back(pTrack->stObjectItem);
 
                     ALOGI("TRACK ID[%lld] force to drop, timeout(%d)", iter->first, nElapsed);
 
-                    trackMap.erase(iter++);
+                    iter = stStream.mapTracks.erase(iter);
+                    stStream.poolTracks.Free(pTrack);
 
                     continue;
                 }
@@ -528,59 +782,51 @@ namespace skel {
             return AX_SKEL_SUCC;
         }
 
-        AX_S32 TrackerDealer::FinalizeInterval(AX_U32 nStreamId, vector<AX_SKEL_OBJECT_ITEM_T> &vecObjectItem, vector<AX_SKEL_PUSH_CACHE_LIST_T> &dropCacheListVec) {
+        AX_S32 TrackerDealer::FinalizeInterval(AX_SKEL_PUSH_STREAM_T &stStream, vector<AX_SKEL_OBJECT_ITEM_T> &vecObjectItem, vector<AX_SKEL_PUSH_CACHE_LIST_T> &dropCacheListVec) {
             AX_S32 nRet = AX_SKEL_SUCC;
-            auto &trackMap = m_TrackMaps[nStreamId];
-            auto &frameMap = m_FrameMaps[nStreamId];
             auto nowTime = std::chrono::steady_clock::now();
 
             // 2. push track
-            for (auto iter = trackMap.begin(); iter != trackMap.end();) {
-                auto &stTrackMap = iter->second;
-                AX_SKEL_OBJECT_ITEM_T stObjectItem = stTrackMap.stObjectItem;
+            for (auto iter = stStream.mapTracks.begin(); iter != stStream.mapTracks.end(); ++ iter) {
+                AX_SKEL_PUSH_TRACK_T *pTrack = iter->second;
+                const AX_SKEL_OBJECT_ITEM_T &stObjectItem = pTrack->stObjectItem;
+
+                // the pending encode decides
+                if (pTrack->bEncoding) {
+                    continue;
+                }
 
                 switch (stObjectItem.eTrackState) {
                     case AX_SKEL_TRACK_STATUS_NEW:
                     case AX_SKEL_TRACK_STATUS_UPDATE:
                     {
-                        AX_S32 nElapsed = (AX_S32)(std::chrono::duration_cast<std::chrono::milliseconds>(nowTime - stTrackMap.pushTime).count());
+                        AX_S32 nElapsed = (AX_S32)(std::chrono::duration_cast<std::chrono::milliseconds>(nowTime - pTrack->pushTime).count());
 
-                        if (nElapsed >= (AX_S32)m_stParam.stPushStrategy.nIntervalTimes) {
-                            if (!PushFliter(stObjectItem)
+                        if (nElapsed >= (AX_S32)stStream.pParam->Param().stPushStrategy.nIntervalTimes) {
+                            if (!PushFliter(stStream, pTrack, stObjectItem)
                                 && stObjectItem.fConfidence > 0
-                                && FrameFind(nStreamId, stObjectItem.nFrameId)) {
-                                nRet = TrackPush(nStreamId, frameMap[stObjectItem.nFrameId].stCacheFrame, stObjectItem);
+                                && pTrack->pFrame) {
+                                nRet = TrackPush(stStream, pTrack, AX_TRUE, vecObjectItem);
 
                                 if (nRet == AX_SKEL_SUCC) {
-                                    stObjectItem.stRect = {0, 0, 0, 0};
-                                    vecObjectItem.push_back(stObjectItem);
-
                                     // update push status
-                                    stTrackMap.nPushCounts ++;
-                                    stTrackMap.pushTime = nowTime;
-
-                                    // reset object confidence
-                                    stTrackMap.stObjectItem.fConfidence = 0;
-                                }
-                                else {
-                                    // reset object confidence
-                                    stTrackMap.stObjectItem.fConfidence = 0;
+                                    pTrack->nPushCounts ++;
+                                    pTrack->pushTime = nowTime;
                                 }
+
+                                // reset object confidence
+                                pTrack->stObjectItem.fConfidence = 0;
                             }
                         }
-                        else {
-                            AX_U32 nDropCacheListSize = dropCacheListVec.size();
-
-                            for (size_t i = 0; i < nDropCacheListSize; i++) {
+                        else if (pTrack->stObjectItem.fConfidence > 0 && pTrack->pFrame) {
+                            for (size_t i = 0; i < dropCacheListVec.size(); i++) {
                                 // find
-                                if (stTrackMap.stObjectItem.fConfidence > 0
-                                    && stTrackMap.stObjectItem.nFrameId == dropCacheListVec[i].nFrameId
-                                    && FrameFind(nStreamId, stTrackMap.stObjectItem.nFrameId)) {
-                                    nRet = TrackPush(nStreamId, frameMap[stTrackMap.stObjectItem.nFrameId].stCacheFrame, stTrackMap.stObjectItem);
+                                if (pTrack->stObjectItem.nFrameId == dropCacheListVec[i].nFrameId) {
+                                    nRet = TrackPush(stStream, pTrack, AX_FALSE, vecObjectItem);
 
                                     if (nRet != AX_SKEL_SUCC) {
                                         // reset object confidence
-                                        stTrackMap.stObjectItem.fConfidence = 0;
+                                        pTrack->stObjectItem.fConfidence = 0;
                                     }
                                     break;
                                 }
@@ -592,29 +838,25 @@ namespace skel {
                     default:
                         break;
                 }
-
-                ++ iter;
             }
 
             // force drop track
-            for (auto iter = trackMap.begin(); iter != trackMap.end();) {
-                auto &stTrackMap = iter->second;
+            for (auto iter = stStream.mapTracks.begin(); iter != stStream.mapTracks.end();) {
+                AX_SKEL_PUSH_TRACK_T *pTrack = iter->second;
 
-                AX_S32 nElapsed = (AX_S32)(std::chrono::duration_cast<std::chrono::milliseconds>(nowTime - stTrackMap.updateTime).count());
+                AX_S32 nElapsed = (AX_S32)(std::chrono::duration_cast<std::chrono::milliseconds>(nowTime - pTrack->updateTime).count());
 
-                if (stTrackMap.eTrackLastState != AX_SKEL_TRACK_STATUS_DIE
+                if (pTrack->eTrackLastState != AX_SKEL_TRACK_STATUS_DIE
                     && nElapsed > PUSH_DIE_FORCE_TIMEOUT) {
-                    // release jenc buffer
-                    PUSH_JENC_REL(stTrackMap.stObjectItem.stCropFrame.pFrameData);
+                    TrackRelease(stStream, pTrack);
 
-                    FrameDelete(nStreamId, stTrackMap.stObjectItem.nFrameId, iter->first);
-
-                    stTrackMap.stObjectItem.eTrackState = AX_SKEL_TRACK_STATUS_DIE;
-                    vecObjectItem.push_back(stTrackMap.stObjectItem);
+                    pTrack->stObjectItem.eTrackState = AX_SKEL_TRACK_STATUS_DIE;
+                    vecObjectItem.push_back(pTrack->stObjectItem);
 
                     ALOGI("TRACK ID[%lld] force to drop, timeout(%d)", iter->first, nElapsed);
 
-                    trackMap.erase(iter++);
+                    iter = stStream.mapTracks.erase(iter);
+                    stStream.poolTracks.Free(pTrack);
 
                     continue;
                 }
@@ -625,74 +867,70 @@ namespace skel {
             return AX_SKEL_SUCC;
         }
 
-        AX_S32 TrackerDealer::FinalizeBest(AX_U32 nStreamId, vector<AX_SKEL_OBJECT_ITEM_T> &vecObjectItem, vector<AX_SKEL_PUSH_CACHE_LIST_T> &dropCacheListVec) {
+        AX_S32 TrackerDealer::FinalizeBest(AX_SKEL_PUSH_STREAM_T &stStream, vector<AX_SKEL_OBJECT_ITEM_T> &vecObjectItem, vector<AX_SKEL_PUSH_CACHE_LIST_T> &dropCacheListVec) {
             AX_S32 nRet = AX_SKEL_SUCC;
-            auto &trackMap = m_TrackMaps[nStreamId];
-            auto &frameMap = m_FrameMaps[nStreamId];
             auto nowTime = std::chrono::steady_clock::now();
 
             // 2. push track die
-            for (auto iter = trackMap.begin(); iter != trackMap.end();) {
-                auto &stTrackMap = iter->second;
+            for (auto iter = stStream.mapTracks.begin(); iter != stStream.mapTracks.end();) {
+                AX_SKEL_PUSH_TRACK_T *pTrack = iter->second;
 
-                AX_S32 nElapsed = (AX_S32)(std::chrono::duration_cast<std::chrono::milliseconds>(nowTime - stTrackMap.updateTime).count());
+                AX_S32 nElapsed = (AX_S32)(std::chrono::duration_cast<std::chrono::milliseconds>(nowTime - pTrack->updateTime).count());
 
-                if (nElapsed > PUSH_DIE_FORCE_TIMEOUT) {
-                    stTrackMap.eTrackLastState = AX_SKEL_TRACK_STATUS_DIE;
+                if (nElapsed > PUSH_DIE_FORCE_TIMEOUT && pTrack->eTrackLastState != AX_SKEL_TRACK_STATUS_DIE) {
+                    pTrack->eTrackLastState = AX_SKEL_TRACK_STATUS_DIE;
                     ALOGI("TRACK ID[%lld] force to die, timeout(%d)", iter->first, nElapsed);
                 }
 
-                if (stTrackMap.eTrackLastState == AX_SKEL_TRACK_STATUS_DIE) {
-                    if (stTrackMap.nUpdateCounts >= STRATEGY_BEST_MIN_PUSH_COUNT
-                        && !PushFliter(stTrackMap.stObjectItem)
-                        && FrameFind(nStreamId, stTrackMap.stObjectItem.nFrameId)) {
-                        nRet = TrackPush(nStreamId, frameMap[stTrackMap.stObjectItem.nFrameId].stCacheFrame, stTrackMap.stObjectItem);
-
-                        if (nRet == AX_SKEL_SUCC) {
-                            // update push status
-                            stTrackMap.nPushCounts ++;
-                            stTrackMap.pushTime = nowTime;
+                // the pending encode decides, it drops the track once done
+                if (pTrack->bEncoding) {
+                    ++ iter;
+                    continue;
+                }
 
-                            memset(&stTrackMap.stObjectItem.stRect, 0x00, sizeof(stTrackMap.stObjectItem.stRect));
-                            vecObjectItem.push_back(stTrackMap.stObjectItem);
-                        }
-                        else {
-                            // release jenc buffer
-                            PUSH_JENC_REL(stTrackMap.stObjectItem.stCropFrame.pFrameData);
+                if (pTrack->eTrackLastState == AX_SKEL_TRACK_STATUS_DIE) {
+                    nRet = AX_ERR_SKEL_ILLEGAL_PARAM;
 
-                            FrameDelete(nStreamId, stTrackMap.stObjectItem.nFrameId, iter->first);
+                    if (pTrack->nUpdateCounts >= STRATEGY_BEST_MIN_PUSH_COUNT
+                        && !PushFliter(stStream, pTrack, pTrack->stObjectItem)
+                        && pTrack->pFrame) {
+                        nRet = TrackPush(stStream, pTrack, AX_TRUE, vecObjectItem);
+                    }
 
-                            vecObjectItem.push_back(stTrackMap.stObjectItem);
+                    if (nRet == AX_SKEL_SUCC) {
+                        // update push status
+                        pTrack->nPushCounts ++;
+                        pTrack->pushTime = nowTime;
 
-                            trackMap.erase(iter++);
+                        if (pTrack->bEncoding) {
+                            ++ iter;
                             continue;
                         }
+
+                        // pushed already
+                        TrackRelease(stStream, pTrack);
                     }
                     else {
-                        // release jenc buffer
-                        PUSH_JENC_REL(stTrackMap.stObjectItem.stCropFrame.pFrameData);
-
-                        FrameDelete(nStreamId, stTrackMap.stObjectItem.nFrameId, iter->first);
+                        TrackRelease(stStream, pTrack);
 
-                        vecObjectItem.push_back(stTrackMap.stObjectItem);
-
-                        trackMap.erase(iter++);
-                        continue;
+                        vecObjectItem.push_back(pTrack->stObjectItem);
                     }
-                }
-                else if (stTrackMap.eTrackLastState == AX_SKEL_TRACK_STATUS_NEW
-                         || stTrackMap.eTrackLastState == AX_SKEL_TRACK_STATUS_UPDATE) {
-                    AX_U32 nDropCacheListSize = dropCacheListVec.size();
 
-                    for (size_t i = 0; i < nDropCacheListSize; i++) {
+                    iter = stStream.mapTracks.erase(iter);
+                    stStream.poolTracks.Free(pTrack);
+                    continue;
+                }
+                else if ((pTrack->eTrackLastState == AX_SKEL_TRACK_STATUS_NEW
+                          || pTrack->eTrackLastState == AX_SKEL_TRACK_STATUS_UPDATE)
+                         && pTrack->pFrame) {
+                    for (size_t i = 0; i < dropCacheListVec.size(); i++) {
                         // find
-                        if (stTrackMap.stObjectItem.nFrameId == dropCacheListVec[i].nFrameId
-                            && FrameFind(nStreamId, stTrackMap.stObjectItem.nFrameId)) {
-                            nRet = TrackPush(nStreamId, frameMap[stTrackMap.stObjectItem.nFrameId].stCacheFrame, stTrackMap.stObjectItem);
+                        if (pTrack->stObjectItem.nFrameId == dropCacheListVec[i].nFrameId) {
+                            nRet = TrackPush(stStream, pTrack, AX_FALSE, vecObjectItem);
 
                             if (nRet != AX_SKEL_SUCC) {
                                 // reset object confidence
-                                stTrackMap.stObjectItem.fConfidence = 0;
+                                pTrack->stObjectItem.fConfidence = 0;
                             }
                             break;
                         }
@@ -705,63 +943,57 @@ namespace skel {
             return AX_SKEL_SUCC;
         }
 
-        AX_S32 TrackerDealer::Finalize(const AX_SKEL_FRAME_T *pstFrame, AX_SKEL_RESULT_T *pstResult, vector<AX_SKEL_OBJECT_ITEM_T> &vecObjectItem) {
-            std::lock_guard<std::mutex> lck(m_mtxMaps);
-            auto &frameMap = m_FrameMaps[pstFrame->nStreamId];
-            auto &cacheListVec = m_CacheListVec[pstFrame->nStreamId];
-
-            vector<AX_SKEL_PUSH_CACHE_LIST_T> tmpCacheListVec = cacheListVec;
-
-            // 1. insert new cache list
-            cacheListVec.clear();
-
-            for (auto iter = frameMap.begin(); iter != frameMap.end();) {
-                AX_SKEL_FRAME_T stFrame;
-                stFrame.nFrameId = iter->second.stCacheFrame.nFrameId;
-                stFrame.nStreamId = pstFrame->nStreamId;
-                stFrame.stFrame = iter->second.stCacheFrame.stFrame;
-                CachePush(&stFrame);
-
-                ++ iter;
+        AX_S32 TrackerDealer::Finalize(const AX_SKEL_FRAME_T *pstFrame, PushCacheListsPtr &pCacheLists, vector<AX_SKEL_OBJECT_ITEM_T> &vecObjectItem) {
+            std::unique_lock<std::mutex> lck;
+            PushStreamPtr pStream = StreamLock(pstFrame->nStreamId, AX_TRUE, lck);
+            if (!pStream) {
+                pCacheLists = std::atomic_load(&m_pCacheLists);
+                return AX_SKEL_SUCC;
             }
+            auto &stStream = *pStream;
+            StreamParam(stStream, pstFrame->nFrameId);
 
+            // 1. insert current frame into the cache ring, older frames may be evicted.
+            //    with copies the frame is not cached, its io ref is dropped in step 3
             vector<AX_SKEL_PUSH_CACHE_LIST_T> dropCacheListVec;
+            AX_BOOL bFrameTracked = AX_FALSE;
+            AX_BOOL bFrameCached = AX_FALSE;
 
-            AX_U32 nTmpCacheListSize = tmpCacheListVec.size();
-            AX_U32 nCacheListSize = cacheListVec.size();
+            CacheResize(stStream, CacheDepth(stStream), dropCacheListVec);
 
-            for (size_t i = 0; i < nTmpCacheListSize; i++) {
-                AX_BOOL bDrop = AX_TRUE;
+            auto iterFrame = stStream.mapFrames.find(pstFrame->nFrameId);
+            if (iterFrame != stStream.mapFrames.end()) {
+                bFrameTracked = AX_TRUE;
 
-                for (size_t j = 0; j < nCacheListSize; j++) {
-                    if (tmpCacheListVec[i].nFrameId == cacheListVec[j].nFrameId) {
-                        bDrop = AX_FALSE;
-                        break;
-                    }
-                }
-
-                if (bDrop) {
-                    dropCacheListVec.push_back(tmpCacheListVec[i]);
+                if (!(stStream.pParam->Param().bFrameCacheCopy
+                      && stStream.pParam->Param().stPushStrategy.ePushMode == AX_SKEL_PUSH_MODE_BEST
+                      && FrameCopy(stStream, iterFrame->second))) {
+                    bFrameCached = CachePush(stStream, iterFrame->second, dropCacheListVec);
                 }
             }
 
-            // 2. Finalize track
-            switch (m_stParam.stPushStrategy.ePushMode) {
+            CacheBudget(stStream, dropCacheListVec);
+
+            // 2. deliver pushes encoded since the last frame, then Finalize track
+            vecObjectItem.insert(vecObjectItem.end(), stStream.vecPushDone.begin(), stStream.vecPushDone.end());
+            stStream.vecPushDone.clear();
+
+            switch (stStream.pParam->Param().stPushStrategy.ePushMode) {
                 case AX_SKEL_PUSH_MODE_FAST:
                 {
-                    FinalizeFast(pstFrame->nStreamId, vecObjectItem, dropCacheListVec);
+                    FinalizeFast(stStream, vecObjectItem, dropCacheListVec);
                 }
                     break;
 
                 case AX_SKEL_PUSH_MODE_INTERVAL:
                 {
-                    FinalizeInterval(pstFrame->nStreamId, vecObjectItem, dropCacheListVec);
+                    FinalizeInterval(stStream, vecObjectItem, dropCacheListVec);
                 }
                     break;
 
                 case AX_SKEL_PUSH_MODE_BEST:
                 {
-                    FinalizeBest(pstFrame->nStreamId, vecObjectItem, dropCacheListVec);
+                    FinalizeBest(stStream, vecObjectItem, dropCacheListVec);
                 }
                     break;
 
@@ -769,135 +1001,353 @@ namespace skel {
                     break;
             }
 
-            // 3. clear drop list ref cnt
-            for (auto iter = frameMap.begin(); iter != frameMap.end();) {
-                if (!iter->second.stCacheFrame.bFrameDrop) {
-                    AX_BOOL bFound = AX_FALSE;
-                    for (size_t i = 0; i < nCacheListSize; i++) {
-                        // found
-                        if (iter->second.stCacheFrame.nFrameId == cacheListVec[i].nFrameId) {
-                            bFound = AX_TRUE;
-                            break;
-                        }
+            // the frames of the pushes are still referenced here
+            EncodeSubmit(stStream);
+
+            // 3. clear drop list ref cnt, frames released in step 2 have dropped their ref already
+            for (size_t i = 0; i < dropCacheListVec.size(); i++) {
+                auto iter = stStream.mapFrames.find(dropCacheListVec[i].nFrameId);
+                if (iter != stStream.mapFrames.end()) {
+                    auto &stCacheFrame = iter->second->stCacheFrame;
+                    if (!stCacheFrame.bFrameDrop) {
+                        dec_io_ref_cnt(stCacheFrame.stFrame);
+                        stCacheFrame.bFrameDrop = AX_TRUE;
                     }
+                }
+            }
 
-                    if (!bFound) {
-                        dec_io_ref_cnt(iter->second.stCacheFrame.stFrame);
-                        iter->second.stCacheFrame.bFrameDrop = AX_TRUE;
+            if (!bFrameCached) {
+                iterFrame = stStream.mapFrames.find(pstFrame->nFrameId);
+                if (iterFrame != stStream.mapFrames.end()) {
+                    auto &stCacheFrame = iterFrame->second->stCacheFrame;
+                    if (!stCacheFrame.bFrameDrop) {
+                        dec_io_ref_cnt(stCacheFrame.stFrame);
+                        stCacheFrame.bFrameDrop = AX_TRUE;
                     }
                 }
+                else if (!bFrameTracked) {
+                    dec_io_ref_cnt(pstFrame->stFrame);
+                }
+            }
+
+            // 4. set cache list, republished only if the ring changed. the other streams are read
+            //    from what they published, never locked
+            StreamPublish(stStream);
+            stStream.bFrameParam = AX_FALSE;
+            lck.unlock();
+
+            pCacheLists = std::atomic_load(&m_pCacheLists);
+
+            return AX_SKEL_SUCC;
+        }
+
+        AX_U32 TrackerDealer::CacheDepth(const AX_SKEL_PUSH_STREAM_T &stStream) {
+            if (stStream.pParam->Param().stPushStrategy.ePushMode == AX_SKEL_PUSH_MODE_FAST
+                || stStream.pParam->Param().stPushStrategy.ePushMode == AX_SKEL_PUSH_MODE_INTERVAL) {
+                return 1;
+            }
+
+            return stStream.pParam->Param().nFrameCacheDepth;
+        }
+
+        AX_VOID TrackerDealer::CacheEvict(AX_SKEL_PUSH_STREAM_T &stStream, vector<AX_SKEL_PUSH_CACHE_LIST_T> &dropCacheListVec) {
+            AX_SKEL_PUSH_FRAME_T *pFrame = stStream.vecCacheRing[stStream.nCacheHead];
+
+            if (pFrame) {
+                pFrame->nCacheSlot = -1;
+                dropCacheListVec.push_back(pFrame->stCacheFrame);
+                stStream.bCacheChanged = AX_TRUE;
+                CacheUnpin(stStream, pFrame);
+            }
+
+            stStream.vecCacheRing[stStream.nCacheHead] = nullptr;
+            stStream.nCacheHead = (stStream.nCacheHead + 1) % stStream.vecCacheRing.size();
+            stStream.nCacheCount --;
+        }
+
+        AX_VOID TrackerDealer::CacheResize(AX_SKEL_PUSH_STREAM_T &stStream, AX_U32 nDepth, vector<AX_SKEL_PUSH_CACHE_LIST_T> &dropCacheListVec) {
+            if (stStream.vecCacheRing.size() == nDepth) {
+                return;
+            }
+
+            while (stStream.nCacheCount > nDepth) {
+                CacheEvict(stStream, dropCacheListVec);
+            }
+
+            vector<AX_SKEL_PUSH_FRAME_T *> vecCacheRing(nDepth, nullptr);
+            for (AX_U32 i = 0; i < stStream.nCacheCount; i++) {
+                AX_SKEL_PUSH_FRAME_T *pFrame = stStream.vecCacheRing[(stStream.nCacheHead + i) % stStream.vecCacheRing.size()];
+                vecCacheRing[i] = pFrame;
+                if (pFrame) {
+                    pFrame->nCacheSlot = i;
+                }
+            }
 
-                ++ iter;
+            stStream.vecCacheRing.swap(vecCacheRing);
+            stStream.nCacheHead = 0;
+        }
+
+        AX_BOOL TrackerDealer::CachePush(AX_SKEL_PUSH_STREAM_T &stStream, AX_SKEL_PUSH_FRAME_T *pFrame, vector<AX_SKEL_PUSH_CACHE_LIST_T> &dropCacheListVec) {
+            AX_U32 nRingSize = stStream.vecCacheRing.size();
+
+            if (nRingSize == 0) {
+                return AX_FALSE;
+            }
+
+            if (pFrame->nCacheSlot >= 0) {
+                return AX_TRUE;
             }
 
-            AX_BOOL bFound = AX_FALSE;
-            for (size_t i = 0; i < nCacheListSize; i++) {
-                // found
-                if (pstFrame->nFrameId == cacheListVec[i].nFrameId) {
-                    bFound = AX_TRUE;
+            // skip holes left by released frames at the oldest end
+            while (stStream.nCacheCount > 0 && !stStream.vecCacheRing[stStream.nCacheHead]) {
+                CacheEvict(stStream, dropCacheListVec);
+            }
+
+            if (stStream.nCacheCount == nRingSize) {
+                CacheEvict(stStream, dropCacheListVec);
+            }
+
+            AX_U32 nSlot = (stStream.nCacheHead + stStream.nCacheCount) % nRingSize;
+            stStream.vecCacheRing[nSlot] = pFrame;
+            stStream.nCacheCount ++;
+            pFrame->nCacheSlot = nSlot;
+            stStream.bCacheChanged = AX_TRUE;
+            CachePin(stStream, pFrame);
+
+            return AX_TRUE;
+        }
+
+        AX_VOID TrackerDealer::CacheBudget(AX_SKEL_PUSH_STREAM_T &stStream, vector<AX_SKEL_PUSH_CACHE_LIST_T> &dropCacheListVec) {
+            AX_U32 nBudget = stStream.pParam->Param().nFrameCacheBudget;
+
+            // over budget: the oldest frames of this stream leave the cache early, their tracks
+            // get their best shot encoded now through the drop list. a stream sheds down to its share
+            // of the budget only, the streams over theirs shed on their own Finalize. with fewer
+            // frames in a budget than streams each stream keeps one
+            while (stStream.nCacheCount > 0) {
+                AX_BOOL bOver = AX_FALSE;
+                if (nBudget > 0 && m_nCachePinned > nBudget
+                    && stStream.nCachePinned > AX_MAX(nBudget / AX_MAX(m_nCacheStreams.load(), 1U), 1U)) {
+                    bOver = AX_TRUE;
+                }
+                if (m_nBudgetGlobal > 0 && s_nCachePinnedGlobal.load() > m_nBudgetGlobal
+                    && stStream.nCachePinned > AX_MAX(m_nBudgetGlobal / AX_MAX(s_nCacheStreamsGlobal.load(), 1U), 1U)) {
+                    bOver = AX_TRUE;
+                }
+                if (!bOver) {
                     break;
                 }
+
+                if (stStream.vecCacheRing[stStream.nCacheHead]) {
+                    m_nBudgetEvicts ++;
+                }
+
+                CacheEvict(stStream, dropCacheListVec);
             }
+        }
+
+        AX_VOID TrackerDealer::CachePin(AX_SKEL_PUSH_STREAM_T &stStream, AX_SKEL_PUSH_FRAME_T *pFrame) {
+            AX_U32 nBytes = pFrame->stCacheFrame.stFrame.u32FrameSize;
+
+            if (stStream.nCachePinned ++ == 0) {
+                m_nCacheStreams ++;
+                s_nCacheStreamsGlobal ++;
+            }
+            stStream.nCacheBytes += nBytes;
+            m_nCachePinned ++;
+            m_nCacheBytes += nBytes;
+            s_nCachePinnedGlobal ++;
+        }
 
-            if (!bFound) {
-                dec_io_ref_cnt(pstFrame->stFrame);
+        AX_VOID TrackerDealer::CacheUnpin(AX_SKEL_PUSH_STREAM_T &stStream, AX_SKEL_PUSH_FRAME_T *pFrame) {
+            AX_U32 nBytes = pFrame->stCacheFrame.stFrame.u32FrameSize;
+
+            if (-- stStream.nCachePinned == 0) {
+                m_nCacheStreams --;
+                s_nCacheStreamsGlobal --;
             }
+            stStream.nCacheBytes -= nBytes;
+            m_nCachePinned --;
+            m_nCacheBytes -= nBytes;
+            s_nCachePinnedGlobal --;
+        }
 
-            // 4. set cache list
-            vector<AX_SKEL_FRAME_CACHE_LIST_T> cacheList;
+        AX_BOOL TrackerDealer::FrameCopy(AX_SKEL_PUSH_STREAM_T &stStream, AX_SKEL_PUSH_FRAME_T *pFrame) {
+            const AX_VIDEO_FRAME_T &stSrc = pFrame->stCacheFrame.stFrame;
 
-            for (auto iter = m_CacheListVec.begin(); iter != m_CacheListVec.end();) {
-                for (size_t i = 0;  i < iter->second.size(); i++) {
-                    AX_SKEL_FRAME_CACHE_LIST_T cacheItem = {0};
-                    cacheItem.nFrameId = iter->second[i].nFrameId;
-                    cacheItem.nStreamId = iter->first;
+            // jenc takes nv12 only
+            if (stSrc.enImgFormat != AX_FORMAT_YUV420_SEMIPLANAR) {
+                return AX_FALSE;
+            }
 
-                    cacheList.push_back(cacheItem);
+            AX_BOOL bSucc = AX_TRUE;
+
+            for (AX_SKEL_PUSH_TRACK_T *pTrack = pFrame->pTrackHead; pTrack && bSucc; pTrack = pTrack->pNext) {
+                if (pTrack->stObjectItem.stCropFrame.pFrameData) {
+                    continue;
                 }
 
-                ++ iter;
+                skel::infer::Rect stCopyRect;
+                bSucc = PushCopyRect(stSrc, PushCropRect(pTrack->nLabel, pTrack->stObjectItem.stRect), stCopyRect);
+
+                if (bSucc) {
+                    pTrack->pCropCopy = CopyAlloc(stCopyRect.width, stCopyRect.height, stSrc.enImgFormat);
+                    bSucc = (pTrack->pCropCopy
+                             && CropResizeFrameTo(stSrc, *pTrack->pCropCopy, stCopyRect) == 0) ? AX_TRUE : AX_FALSE;
+                }
             }
 
-            nCacheListSize = cacheList.size();
-            pstResult->pstCacheList = new AX_SKEL_FRAME_CACHE_LIST_T[nCacheListSize];
+            if (bSucc && stStream.pParam->Param().stPushPanoramaConfig.bEnable) {
+                const AX_SKEL_RESIZE_CONFIG_T stCopyResize = {PUSH_COPY_PANORA_WIDTH, PUSH_COPY_PANORA_HEIGHT};
+                AX_U32 nWidth = ALIGN_DOWN(stSrc.u32Width, PUSH_COPY_WIDTH_ALIGN);
+                AX_U32 nHeight = ALIGN_DOWN(stSrc.u32Height, 2);
+
+                // the smaller of the copy bound and the configured panorama size
+                PushPanoraSize(stCopyResize, stSrc, nWidth, nHeight);
+                PushPanoraSize(stStream.pParam->Param().stPanoramaResizeConfig, stSrc, nWidth, nHeight);
 
-            if (!pstResult->pstCacheList) {
-                ALOGW("SKEL alloc cache list fail");
-                return AX_ERR_SKEL_NOMEM;
+                pFrame->pPanoraCopy = CopyAlloc(nWidth, nHeight, stSrc.enImgFormat);
+                bSucc = (pFrame->pPanoraCopy
+                         && CropResizeFrameTo(stSrc, *pFrame->pPanoraCopy, skel::infer::Rect()) == 0) ? AX_TRUE : AX_FALSE;
             }
 
-            memcpy(pstResult->pstCacheList, cacheList.data(), sizeof(AX_SKEL_FRAME_CACHE_LIST_T) * nCacheListSize);
+            // all or nothing, the frame is cached as before
+            if (!bSucc) {
+                ALOGW("SKEL FrameId: %llu copy fail, cache the frame", (unsigned long long)pFrame->stCacheFrame.nFrameId);
 
-            pstResult->nCacheListSize = nCacheListSize;
+                for (AX_SKEL_PUSH_TRACK_T *pTrack = pFrame->pTrackHead; pTrack; pTrack = pTrack->pNext) {
+                    pTrack->pCropCopy.reset();
+                }
+                pFrame->pPanoraCopy.reset();
 
-            return AX_SKEL_SUCC;
-        }
+                return AX_FALSE;
+            }
 
-        AX_S32 TrackerDealer::CachePush(const AX_SKEL_FRAME_T *pstFrame) {
-            std::lock_guard<std::mutex> lck(m_mtxSet);
+            pFrame->bCopied = AX_TRUE;
 
-            AX_U32 nFrameCacheDepth = m_stParam.nFrameCacheDepth;
-            auto &cacheListVec = m_CacheListVec[pstFrame->nStreamId];
+            return AX_TRUE;
+        }
 
-            if (m_stParam.stPushStrategy.ePushMode == AX_SKEL_PUSH_MODE_FAST
-                || m_stParam.stPushStrategy.ePushMode == AX_SKEL_PUSH_MODE_INTERVAL) {
-                nFrameCacheDepth = 1;
+        static AX_S32 CopyClass(AX_U32 nSize) {
+            AX_U32 nCapacity = PUSH_COPY_CLASS_MIN;
+            for (AX_S32 i = 0; i < PUSH_COPY_CLASS_NUM; i++) {
+                if (nSize <= nCapacity) {
+                    return i;
+                }
+                nCapacity <<= 1;
             }
 
-            AX_BOOL bInsertBack = AX_TRUE;
-            AX_SKEL_PUSH_CACHE_LIST_T stFrameCache;
-            stFrameCache.nFrameId = pstFrame->nFrameId;
-            stFrameCache.stFrame = pstFrame->stFrame;
+            return -1;
+        }
 
-            AX_U32 nCacheListSize = cacheListVec.size();
+        PushCopyPtr TrackerDealer::CopyAlloc(AX_U32 nWidth, AX_U32 nHeight, AX_IMG_FORMAT_E eFormat) {
+            AX_VIDEO_FRAME_T *pCopy = new (std::nothrow) AX_VIDEO_FRAME_T;
+            if (!pCopy) {
+                return nullptr;
+            }
 
-            if (nCacheListSize > 0) {
-                for (size_t i = 0; i < nCacheListSize; i++) {
-                    if (pstFrame->nFrameId > cacheListVec[i].nFrameId) {
-                        bInsertBack = AX_FALSE;
-                        cacheListVec.emplace(cacheListVec.begin() + i, stFrameCache);
-                        break;
-                    }
-                    else if (pstFrame->nFrameId < cacheListVec[i].nFrameId) {
-                        bInsertBack = AX_TRUE;
-                    }
+            memset(pCopy, 0x00, sizeof(AX_VIDEO_FRAME_T));
+            pCopy->u32Width = nWidth;
+            pCopy->u32Height = nHeight;
+            pCopy->u32PicStride[0] = nWidth;
+            pCopy->u32PicStride[1] = nWidth;
+            pCopy->u32PicStride[2] = nWidth;
+            pCopy->enImgFormat = eFormat;
+            pCopy->u32FrameSize = get_image_data_size(pCopy);
+
+            // the copy is laid on a block of its size class, crops of any size reuse the blocks freed
+            AX_S32 nClass = CopyClass(pCopy->u32FrameSize);
+            AX_U32 nCapacity = (nClass >= 0) ? ((AX_U32)PUSH_COPY_CLASS_MIN << nClass) : pCopy->u32FrameSize;
+
+            AX_VIDEO_FRAME_T stBlock;
+            memset(&stBlock, 0x00, sizeof(stBlock));
+            if (nClass >= 0) {
+                std::lock_guard<std::mutex> lck(m_mtxCopy);
+                auto &vecFree = m_vecCopyFree[nClass];
+                if (!vecFree.empty()) {
+                    stBlock = vecFree.back();
+                    vecFree.pop_back();
+                    m_nCopyCached -= nCapacity;
                 }
             }
 
-            if (bInsertBack) {
-                cacheListVec.push_back(stFrameCache);
+            if (stBlock.u64PhyAddr[0] == 0
+                && AX_SYS_MemAlloc((AX_U64*)&stBlock.u64PhyAddr[0], (AX_VOID **)&stBlock.u64VirAddr[0], nCapacity,
+                                   SKEL_IO_CMM_ALIGN_SIZE, (AX_S8*)"skel_push_copy_in") != 0) {
+                ALOGE("SKEL alloc push copy %d bytes fail", nCapacity);
+                delete pCopy;
+                return nullptr;
             }
 
-            while (cacheListVec.size() > 0
-                   && cacheListVec.size() > nFrameCacheDepth) {
-                cacheListVec.pop_back();
+            pCopy->u64PhyAddr[0] = stBlock.u64PhyAddr[0];
+            pCopy->u64VirAddr[0] = stBlock.u64VirAddr[0];
+            pCopy->u64PhyAddr[1] = pCopy->u64PhyAddr[0] + pCopy->u32PicStride[0] * nHeight;
+            pCopy->u64VirAddr[1] = pCopy->u64VirAddr[0] + pCopy->u32PicStride[0] * nHeight;
+            if (eFormat == AX_FORMAT_BGR888 || eFormat == AX_FORMAT_RGB888) {
+                pCopy->u64PhyAddr[2] = pCopy->u64PhyAddr[1] + pCopy->u32PicStride[1] * nHeight;
+                pCopy->u64VirAddr[2] = pCopy->u64VirAddr[1] + pCopy->u32PicStride[1] * nHeight;
             }
 
+            m_nCopyBytes += nCapacity;
+
+            return PushCopyPtr(pCopy, [this, nClass, nCapacity](AX_VIDEO_FRAME_T *p) {
+                CopyFree(p, nClass, nCapacity);
+            });
+        }
+
+        AX_VOID TrackerDealer::CopyFree(AX_VIDEO_FRAME_T *pCopy, AX_S32 nClass, AX_U32 nCapacity) {
+            // the block under the copy, back to its class unless the pool holds enough
+            AX_VIDEO_FRAME_T stBlock;
+            memset(&stBlock, 0x00, sizeof(stBlock));
+            stBlock.u64PhyAddr[0] = pCopy->u64PhyAddr[0];
+            stBlock.u64VirAddr[0] = pCopy->u64VirAddr[0];
+            stBlock.u32FrameSize = nCapacity;
+            delete pCopy;
+
+            m_nCopyBytes -= nCapacity;
+
+            if (nClass >= 0) {
+                std::lock_guard<std::mutex> lck(m_mtxCopy);
+                auto &vecFree = m_vecCopyFree[nClass];
+                if (vecFree.size() < PUSH_COPY_CLASS_CACHE && m_nCopyCached + nCapacity <= PUSH_COPY_POOL_BYTES) {
+                    vecFree.push_back(stBlock);
+                    m_nCopyCached += nCapacity;
+                    return;
+                }
+            }
+
+            FreeFrame(stBlock);
+        }
+
+        AX_S32 TrackerDealer::EncodeRate(AX_SKEL_JENC_RATE_STAT_T &stStat) {
+            m_Rate.Stat(stStat);
+
             return AX_SKEL_SUCC;
         }
 
-        AX_BOOL TrackerDealer::PushFliter(AX_SKEL_OBJECT_ITEM_T &stObjectItem) {
-            AX_SKEL_PARAM_T stParam;
-            std::string strObjectCategory = stObjectItem.pstrObjectCategory;
+        AX_S32 TrackerDealer::CacheOccupancy(AX_SKEL_PUSH_CACHE_OCCUPANCY_T &stOccupancy) {
+            stOccupancy.nPinned = m_nCachePinned.load();
+            stOccupancy.nPinnedBytes = m_nCacheBytes.load();
+            stOccupancy.nBudget = m_Param.Load()->Param().nFrameCacheBudget;
+            stOccupancy.nPinnedGlobal = s_nCachePinnedGlobal.load();
+            stOccupancy.nBudgetGlobal = m_nBudgetGlobal;
+            stOccupancy.nBudgetEvicts = m_nBudgetEvicts.load();
+            stOccupancy.nCopyBytes = m_nCopyBytes.load();
 
-            {
-                std::unique_lock<std::mutex> lck(m_mtxSet);
-                stParam = m_stParam;
-            }
+            return AX_SKEL_SUCC;
+        }
 
-            vector<float> tlwh;
-            tlwh.resize(4);
-            tlwh[0] = stObjectItem.stRect.fX;
-            tlwh[1] = stObjectItem.stRect.fY;
-            tlwh[2] = stObjectItem.stRect.fW;
-            tlwh[3] = stObjectItem.stRect.fH;
+        AX_BOOL TrackerDealer::PushFliter(const AX_SKEL_PUSH_STREAM_T &stStream, const AX_SKEL_PUSH_TRACK_T *pTrack, const AX_SKEL_OBJECT_ITEM_T &stObjectItem) {
+            const AX_SKEL_PARAM_T &stParam = stStream.pParam->Param();
+            const AX_SKEL_LABEL_CONFIG_T &stLabel = stStream.pParam->Label(pTrack->nLabel);
+            const AX_SKEL_RECT_T &stRect = stObjectItem.stRect;
 
             // check roi
             if (stParam.stRoi.bEnable) {
-                float x1 = (float)tlwh[0];
-                float y1 = (float)tlwh[1];
-                float x2 = x1 + (float)tlwh[2];
-                float y2 = y1 + (float)tlwh[3];
+                float x1 = stRect.fX;
+                float y1 = stRect.fY;
+                float x2 = x1 + stRect.fW;
+                float y2 = y1 + stRect.fH;
 
                 float x1_roi = (float)stParam.stRoi.stRect.fX;
                 float y1_roi = (float)stParam.stRoi.stRect.fY;
@@ -910,305 +1360,467 @@ namespace skel {
                 }
             }
 
-            if (strObjectCategory == "body") {
-                // check filter size
+            if (pTrack->nLabel < 0) {
+                return AX_FALSE;
+            }
 
-                // check filter size
-                if (!(tlwh[2] >= stParam.stFilterMaps["body"].minSize.width && tlwh[3] >= stParam.stFilterMaps["body"].minSize.height)) {
-                    ALOGI("SKEL body filter(%fx%f:%dx%d)", tlwh[2], tlwh[3], stParam.stFilterMaps["body"].minSize.width, stParam.stFilterMaps["body"].minSize.height);
+            // check filter size
+            if (!(stRect.fW >= stLabel.stFilter.minSize.width && stRect.fH >= stLabel.stFilter.minSize.height)) {
+                ALOGI("SKEL %s filter(%fx%f:%dx%d)", SKEL_LABEL_NAMES[pTrack->nLabel], stRect.fW, stRect.fH, stLabel.stFilter.minSize.width, stLabel.stFilter.minSize.height);
+                return AX_TRUE;
+            }
+
+            // check Attr filter size
+            if (pTrack->nLabel == SKEL_LABEL_FACE) {
+                const AX_SKEL_FACE_ATTR_FILTER_CONFIG_T &stFaceAttr = stLabel.stAttrFilter.stFaceAttrFilterConfig;
+                if (!(stRect.fW >= stFaceAttr.nWidth && stRect.fH >= stFaceAttr.nHeight)) {
+                    ALOGI("SKEL face filter(%fx%f:%dx%d)", stRect.fW, stRect.fH, stFaceAttr.nWidth, stFaceAttr.nHeight);
                     return AX_TRUE;
                 }
 
-                // check Attr filter size
-                if (stObjectItem.fConfidence < stParam.stAttrFliterMaps["body"].stCommonAttrFilterConfig.fQuality) {
-                    ALOGI("SKEL body quality filter(%f:%f)", stObjectItem.fConfidence, stParam.stAttrFliterMaps["body"].stCommonAttrFilterConfig.fQuality);
+                // fBlur is only measured in best mode, 0 otherwise
+                if (stObjectItem.stFacePostBlur.fBlur > stFaceAttr.stPoseblur.fBlur) {
+                    ALOGI("SKEL face blur filter(%f:%f)", stObjectItem.stFacePostBlur.fBlur, stFaceAttr.stPoseblur.fBlur);
                     return AX_TRUE;
                 }
             }
-            else if (strObjectCategory == "vehicle")
-            {
-                // check filter size
-                if (!(tlwh[2] >= stParam.stFilterMaps["vehicle"].minSize.width && tlwh[3] >= stParam.stFilterMaps["vehicle"].minSize.height)) {
-                    ALOGI("SKEL vehicle filter(%fx%f:%dx%d)", tlwh[2], tlwh[3], stParam.stFilterMaps["vehicle"].minSize.width, stParam.stFilterMaps["vehicle"].minSize.height);
-                    return AX_TRUE;
+            else if (stObjectItem.fConfidence < stLabel.stAttrFilter.stCommonAttrFilterConfig.fQuality) {
+                ALOGI("SKEL %s quality filter(%f:%f)", SKEL_LABEL_NAMES[pTrack->nLabel], stObjectItem.fConfidence, stLabel.stAttrFilter.stCommonAttrFilterConfig.fQuality);
+                return AX_TRUE;
+            }
+
+            return AX_FALSE;
+        }
+
+        AX_S32 TrackerDealer::TrackPush(AX_SKEL_PUSH_STREAM_T &stStream, AX_SKEL_PUSH_TRACK_T *pTrack, AX_BOOL bDeliver, vector<AX_SKEL_OBJECT_ITEM_T> &vecObjectItem) {
+            AX_SKEL_PUSH_FRAME_T *pFrame = pTrack->pFrame;
+            const AX_SKEL_PUSH_CACHE_LIST_T &stCacheFrame = pFrame->stCacheFrame;
+            AX_SKEL_OBJECT_ITEM_T &stObjectStore = pTrack->stObjectItem;
+
+            AX_BOOL bCropEncode = stObjectStore.stCropFrame.pFrameData ? AX_FALSE : AX_TRUE;
+            AX_BOOL bPanoraEncode = (stStream.pParam->Param().stPushPanoramaConfig.bEnable
+                                     && !stObjectStore.stPanoraFrame.pFrameData) ? AX_TRUE : AX_FALSE;
+
+            // encoded already for an earlier push of the frame
+            if (bPanoraEncode && pFrame->stPanoraFrame.pFrameData) {
+                JENCOBJ->Ref(pFrame->stPanoraFrame.pFrameData);
+                stObjectStore.bPanoraFrame = AX_TRUE;
+                stObjectStore.stPanoraFrame = pFrame->stPanoraFrame;
+                bPanoraEncode = AX_FALSE;
+            }
+
+            // the copies stand in for the source frame, which is gone
+            if (pFrame->bCopied) {
+                if (bCropEncode && !pTrack->pCropCopy) {
+                    ALOGW("SKEL FrameId: %llu has no crop copy for trackId: %llu",
+                          (unsigned long long)stCacheFrame.nFrameId, (unsigned long long)pTrack->nTrackId);
+                    return AX_ERR_SKEL_ILLEGAL_PARAM;
                 }
 
-                // check Attr filter size
-                if (stObjectItem.fConfidence < stParam.stAttrFliterMaps["vehicle"].stCommonAttrFilterConfig.fQuality) {
-                    ALOGI("SKEL vehicle quality filter(%f:%f)", stObjectItem.fConfidence, stParam.stAttrFliterMaps["vehicle"].stCommonAttrFilterConfig.fQuality);
-                    return AX_TRUE;
+                if (!pFrame->pPanoraCopy) {
+                    bPanoraEncode = AX_FALSE;
                 }
             }
-            else if (strObjectCategory == "cycle")
-            {
-                // check filter size
-                if (!(tlwh[2] >= stParam.stFilterMaps["cycle"].minSize.width && tlwh[3] >= stParam.stFilterMaps["cycle"].minSize.height)) {
-                    ALOGI("SKEL cycle filter(%fx%f:%dx%d)", tlwh[2], tlwh[3], stParam.stFilterMaps["cycle"].minSize.width, stParam.stFilterMaps["cycle"].minSize.height);
-                    return AX_TRUE;
-                }
 
-                // check Attr filter size
-                if (stObjectItem.fConfidence < stParam.stAttrFliterMaps["cycle"].stCommonAttrFilterConfig.fQuality) {
-                    ALOGI("SKEL cycle quality filter(%f:%f)", stObjectItem.fConfidence, stParam.stAttrFliterMaps["cycle"].stCommonAttrFilterConfig.fQuality);
-                    return AX_TRUE;
+            // buffers are ready
+            if (!bCropEncode && !bPanoraEncode) {
+                if (bDeliver) {
+                    TrackDeliver(pTrack, vecObjectItem);
                 }
+
+                return AX_SKEL_SUCC;
             }
-            else if (strObjectCategory == "face")
-            {
-                // check filter size
-                if (!(tlwh[2] >= stParam.stFilterMaps["face"].minSize.width && tlwh[3] >= stParam.stFilterMaps["face"].minSize.height)) {
-                    ALOGI("SKEL face filter(%fx%f:%dx%d)", tlwh[2], tlwh[3], stParam.stFilterMaps["face"].minSize.width, stParam.stFilterMaps["face"].minSize.height);
-                    return AX_TRUE;
+
+            if (stCacheFrame.bFrameDrop && !pFrame->bCopied) {
+                if (bCropEncode) {
+                    ALOGW("SKEL FrameId: %llu is drop for trackId: %llu crop. L: %d, S: %d, N: %d, U: %d",
+                          (unsigned long long)stCacheFrame.nFrameId, (unsigned long long)pTrack->nTrackId, pTrack->eTrackLastState, stObjectStore.eTrackState, pTrack->nPushCounts, pTrack->nUpdateCounts);
+
+                    return AX_ERR_SKEL_ILLEGAL_PARAM;
                 }
 
-                // check Attr filter size
-                if (!(tlwh[2] >= stParam.stAttrFliterMaps["face"].stFaceAttrFilterConfig.nWidth && tlwh[3] >= stParam.stAttrFliterMaps["face"].stFaceAttrFilterConfig.nHeight)) {
-                    ALOGI("SKEL face filter(%fx%f:%dx%d)", tlwh[2], tlwh[3], stParam.stAttrFliterMaps["face"].stFaceAttrFilterConfig.nWidth, stParam.stAttrFliterMaps["face"].stFaceAttrFilterConfig.nHeight);
-                    return AX_TRUE;
+                ALOGW("SKEL FrameId: %llu is drop for trackId: %llu panora.", (unsigned long long)stCacheFrame.nFrameId, (unsigned long long)pTrack->nTrackId);
+
+                if (bDeliver) {
+                    TrackDeliver(pTrack, vecObjectItem);
                 }
+
+                return AX_SKEL_SUCC;
             }
-            else if (strObjectCategory == "plate")
-            {
-                // check filter size
-                if (!(tlwh[2] >= stParam.stFilterMaps["plate"].minSize.width && tlwh[3] >= stParam.stFilterMaps["plate"].minSize.height)) {
-                    ALOGI("SKEL plate filter(%fx%f:%dx%d)", tlwh[2], tlwh[3], stParam.stFilterMaps["plate"].minSize.width, stParam.stFilterMaps["plate"].minSize.height);
-                    return AX_TRUE;
+
+            AX_SKEL_PUSH_ENCODE_JOB_T stJob = AX_SKEL_PUSH_ENCODE_JOB_T();
+            stJob.nStreamId = stStream.nStreamId;
+            stJob.nTrackId = pTrack->nTrackId;
+            stJob.nFrameId = stCacheFrame.nFrameId;
+            stJob.bDeliver = bDeliver;
+            stJob.bCropEncode = bCropEncode;
+            stJob.bPanoraEncode = bPanoraEncode;
+            stJob.stObjectItem = stObjectStore;
+
+            if (bCropEncode) {
+                if (pFrame->bCopied) {
+                    stJob.pCropCopy = pTrack->pCropCopy;
                 }
+                else {
+                    stJob.stCropRect = PushCropRect(pTrack->nLabel, stObjectStore.stRect);
+                }
+            }
 
-                // check Attr filter size
-                if (stObjectItem.fConfidence < stParam.stAttrFliterMaps["plate"].stCommonAttrFilterConfig.fQuality) {
-                    ALOGI("SKEL plate quality filter(%f:%f)", stObjectItem.fConfidence, stParam.stAttrFliterMaps["plate"].stCommonAttrFilterConfig.fQuality);
-                    return AX_TRUE;
+            // the push takes the buffers the track holds already
+            if (bDeliver) {
+                stJob.stCropFrame = stObjectStore.stCropFrame;
+                stJob.stPanoraFrame = stObjectStore.stPanoraFrame;
+            }
+
+            // joins the pushes of the same frame, submitted by EncodeSubmit
+            AX_SKEL_PUSH_ENCODE_BATCH_T *pBatch = nullptr;
+            for (auto &stBatch : stStream.vecEncodeBatch) {
+                if (stBatch.nFrameId == stCacheFrame.nFrameId) {
+                    pBatch = &stBatch;
+                    break;
                 }
             }
 
-            return AX_FALSE;
+            if (!pBatch) {
+                stStream.vecEncodeBatch.emplace_back();
+                pBatch = &stStream.vecEncodeBatch.back();
+                pBatch->nStreamId = stStream.nStreamId;
+                pBatch->nFrameId = stCacheFrame.nFrameId;
+                pBatch->stFrame = stCacheFrame.stFrame;
+                pBatch->bCopied = pFrame->bCopied;
+                pBatch->pPanoraCopy = pFrame->pPanoraCopy;
+                if (pFrame->pPanoraCopy) {
+                    pBatch->stFrame = *pFrame->pPanoraCopy;
+                }
+                else if (!pFrame->bCopied) {
+                    pBatch->nPanoraWidth = pBatch->stFrame.u32Width;
+                    pBatch->nPanoraHeight = pBatch->stFrame.u32Height;
+                    if (!PushPanoraSize(stStream.pParam->Param().stPanoramaResizeConfig, pBatch->stFrame, pBatch->nPanoraWidth, pBatch->nPanoraHeight)) {
+                        pBatch->nPanoraWidth = 0;
+                        pBatch->nPanoraHeight = 0;
+                    }
+                }
+            }
+
+            pBatch->vecJobs.push_back(stJob);
+
+            if (bDeliver) {
+                stObjectStore.bCropFrame = AX_FALSE;
+                memset(&stObjectStore.stCropFrame, 0x00, sizeof(stObjectStore.stCropFrame));
+                stObjectStore.bPanoraFrame = AX_FALSE;
+                memset(&stObjectStore.stPanoraFrame, 0x00, sizeof(stObjectStore.stPanoraFrame));
+            }
+
+            pTrack->bEncoding = AX_TRUE;
+
+            return AX_SKEL_SUCC;
         }
 
-        AX_S32 TrackerDealer::TrackPush(AX_U32 nStreamId, const AX_SKEL_PUSH_CACHE_LIST_T &stCacheFrame, AX_SKEL_OBJECT_ITEM_T &stObjectItem) {
-            AX_U64 nTrackId = stObjectItem.nTrackId;
-            AX_U64 nFrameId = stObjectItem.nFrameId;
-            auto &trackMap = m_TrackMaps[nStreamId];
-            auto &frameMap = m_FrameMaps[nStreamId];
-
-            AX_VOID *pBuf = nullptr;
-            AX_U32 nBufSize = 0;
-            AX_U32 nDstWidth = 0;
-            AX_U32 nDstHeight = 0;
-            AX_S32 nRet = 0;
-
-            // not found Or buffer is nil
-            if (!TrackFind(nStreamId, nTrackId, stObjectItem.stCropFrame)
-                || !stObjectItem.stCropFrame.pFrameData) {
-                AX_SKEL_CROP_ENCODER_THRESHOLD_CONFIG_T stEncoderScaleSet = s_stEncoderScaleDefaultMaps[stObjectItem.pstrObjectCategory];
-
-                AX_SKEL_RECT_T stRect = stObjectItem.stRect;
-                stRect.fX = stRect.fX - stRect.fW * stEncoderScaleSet.fScaleLeft;
-                stRect.fY = stRect.fY - stRect.fH * stEncoderScaleSet.fScaleTop;
-                stRect.fW = stRect.fW * (1 + stEncoderScaleSet.fScaleLeft + stEncoderScaleSet.fScaleRight);
-                stRect.fH = stRect.fH * (1 + stEncoderScaleSet.fScaleTop + stEncoderScaleSet.fScaleBottom);
-
-                if (!stCacheFrame.bFrameDrop) {
-                    nRet = JENCOBJ->Get(stCacheFrame.stFrame, stRect, nDstWidth, nDstHeight, &pBuf, &nBufSize, m_stParam.fCropEncoderQpLevel);
-
-                    if (nRet == 0) {
-                        auto &stObjectStore = trackMap[nTrackId].stObjectItem;
-                        stObjectStore.bCropFrame = AX_TRUE;
-                        stObjectStore.stCropFrame.nFrameId = nFrameId;
-                        stObjectStore.stCropFrame.pFrameData = (AX_U8 *)pBuf;
-                        stObjectStore.stCropFrame.nFrameDataSize = nBufSize;
-                        stObjectStore.stCropFrame.nFrameWidth = nDstWidth;
-                        stObjectStore.stCropFrame.nFrameHeight = nDstHeight;
-
-                        stObjectItem.eTrackState = AX_SKEL_TRACK_STATUS_SELECT;
-                        stObjectItem.bCropFrame = AX_TRUE;
-                        stObjectItem.stCropFrame = stObjectStore.stCropFrame;
+        AX_VOID TrackerDealer::TrackDeliver(AX_SKEL_PUSH_TRACK_T *pTrack, vector<AX_SKEL_OBJECT_ITEM_T> &vecObjectItem) {
+            AX_SKEL_OBJECT_ITEM_T &stObjectStore = pTrack->stObjectItem;
+            AX_SKEL_OBJECT_ITEM_T stObjectItem = stObjectStore;
+
+            stObjectItem.eTrackState = AX_SKEL_TRACK_STATUS_SELECT;
+            stObjectItem.stRect = {0, 0, 0, 0};
+            stObjectItem.bCropFrame = AX_TRUE;
+            stObjectItem.bPanoraFrame = stObjectItem.stPanoraFrame.pFrameData ? AX_TRUE : AX_FALSE;
+            vecObjectItem.push_back(stObjectItem);
+
+            // the result owns the jenc buffers now
+            stObjectStore.bCropFrame = AX_FALSE;
+            memset(&stObjectStore.stCropFrame, 0x00, sizeof(stObjectStore.stCropFrame));
+            stObjectStore.bPanoraFrame = AX_FALSE;
+            memset(&stObjectStore.stPanoraFrame, 0x00, sizeof(stObjectStore.stPanoraFrame));
+        }
+
+        AX_VOID TrackerDealer::EncodeSubmit(AX_SKEL_PUSH_STREAM_T &stStream) {
+            for (auto &stBatch : stStream.vecEncodeBatch) {
+                auto pBatch = std::make_shared<AX_SKEL_PUSH_ENCODE_BATCH_T>(std::move(stBatch));
+
+                // one Qfactor for the batch, from its largest image which weighs the most bytes
+                AX_U32 nPixels = 0;
+                for (auto &stJob : pBatch->vecJobs) {
+                    if (stJob.bCropEncode) {
+                        nPixels = AX_MAX(nPixels, stJob.pCropCopy ? stJob.pCropCopy->u32Width * stJob.pCropCopy->u32Height
+                                                                  : (AX_U32)(stJob.stCropRect.fW * stJob.stCropRect.fH));
                     }
-                    else {
-                        return AX_ERR_SKEL_ILLEGAL_PARAM;
+                    if (stJob.bPanoraEncode) {
+                        nPixels = AX_MAX(nPixels, pBatch->nPanoraWidth > 0 ? pBatch->nPanoraWidth * pBatch->nPanoraHeight
+                                                                           : pBatch->stFrame.u32Width * pBatch->stFrame.u32Height);
                     }
                 }
+                pBatch->nQpLevel = m_Rate.Qfactor(nPixels, stStream.nEncodePending);
+
+                if (!pBatch->bCopied) {
+                    inc_io_ref_cnt(pBatch->stFrame);
+                }
+
+                AX_S32 nRet = m_EncodeWorkers.Submit(pBatch->nStreamId, [this, pBatch] {
+                    EncodeTask(*pBatch);
+                }, 0);
+
+                if (nRet == AX_SKEL_SUCC) {
+                    stStream.nEncodePending ++;
+                }
                 else {
-                    auto &stTrackMap = trackMap[nTrackId];
+                    if (!pBatch->bCopied) {
+                        dec_io_ref_cnt(pBatch->stFrame);
+                    }
 
-                    ALOGW("SKEL FrameId: %lld is drop for trackId: %lld crop. L: %d, S: %d, N: %d, U: %d",
-                          stCacheFrame.nFrameId, nTrackId, stTrackMap.eTrackLastState, stObjectItem.eTrackState, stTrackMap.nPushCounts, stTrackMap.nUpdateCounts);
+                    // the track goes on, the frame is not waited for: counted and shown by Statistics
+                    m_nEncodeDrops += pBatch->vecJobs.size();
+                    ALOGW("SKEL push encode queue full, drop %zu pushes of FrameId: %llu", pBatch->vecJobs.size(), (unsigned long long)pBatch->nFrameId);
 
-                    return AX_ERR_SKEL_ILLEGAL_PARAM;
+                    for (auto &stJob : pBatch->vecJobs) {
+                        EncodeDone(&stStream, stJob, AX_FALSE);
+                    }
                 }
             }
-            else {
-                stObjectItem.eTrackState = AX_SKEL_TRACK_STATUS_SELECT;
-                stObjectItem.bCropFrame = AX_TRUE;
+
+            stStream.vecEncodeBatch.clear();
+        }
+
+        AX_VOID TrackerDealer::EncodeTask(AX_SKEL_PUSH_ENCODE_BATCH_T &stBatch) {
+            auto &vecJobs = stBatch.vecJobs;
+            AX_BOOL bPanoraEncode = AX_FALSE;
+            std::vector<AX_SKEL_JENC_REGION_T> vecRegions;
+
+            for (auto &stJob : vecJobs) {
+                if (stJob.bPanoraEncode) {
+                    bPanoraEncode = AX_TRUE;
+                }
             }
 
-            if (m_stParam.stPushPanoramaConfig.bEnable) {
-                AX_BOOL isPanoPush = AX_TRUE;
+            // the panorama is encoded once for the frame, region 0
+            PushCopyPtr pPanoraResize;
+            if (bPanoraEncode) {
+                vecRegions.emplace_back();
 
-                if (!FrameFind(nStreamId, nFrameId, stObjectItem.stPanoraFrame)
-                    || !stObjectItem.stPanoraFrame.pFrameData) {
-                    if (!stCacheFrame.bFrameDrop) {
-                        AX_SKEL_RECT_T stRect{0};
-                        AX_S32 nRet = JENCOBJ->Get(stCacheFrame.stFrame, stRect, nDstWidth, nDstHeight, &pBuf, &nBufSize, m_stParam.fCropEncoderQpLevel);
-
-                        if (nRet == 0) {
-                            auto &stPanoraStore = frameMap[nFrameId].stPanoraFrame;
-                            stPanoraStore.nFrameId = nFrameId;
-                            stPanoraStore.pFrameData = (AX_U8 *)pBuf;
-                            stPanoraStore.nFrameDataSize = nBufSize;
-                            stPanoraStore.nFrameWidth = nDstWidth;
-                            stPanoraStore.nFrameHeight = nDstHeight;
-
-                            stObjectItem.stPanoraFrame = stPanoraStore;
-                        }
-                        else {
-                            isPanoPush = AX_FALSE;
-                        }
+                // one downscale for every push of the frame, the full frame is encoded if it fails
+                if (stBatch.nPanoraWidth > 0) {
+                    pPanoraResize = CopyAlloc(stBatch.nPanoraWidth, stBatch.nPanoraHeight, stBatch.stFrame.enImgFormat);
+                    if (pPanoraResize && CropResizeFrameTo(stBatch.stFrame, *pPanoraResize, skel::infer::Rect()) == 0) {
+                        vecRegions.back().pFrame = pPanoraResize.get();
                     }
                     else {
-                        ALOGW("SKEL FrameId: %lld is drop for trackId: %lld panora.", stCacheFrame.nFrameId, nTrackId);
+                        ALOGW("SKEL FrameId: %llu panora resize %dx%d fail", (unsigned long long)stBatch.nFrameId, stBatch.nPanoraWidth, stBatch.nPanoraHeight);
                     }
                 }
+            }
 
-                if (isPanoPush) {
-                    stObjectItem.bPanoraFrame = AX_TRUE;
-
-                    auto &stObjectStore = trackMap[nTrackId].stObjectItem;
-                    stObjectStore.bPanoraFrame = AX_TRUE;
-                    stObjectStore.stPanoraFrame = stObjectItem.stPanoraFrame;
+            for (auto &stJob : vecJobs) {
+                if (stJob.bCropEncode) {
+                    vecRegions.emplace_back();
+                    vecRegions.back().pFrame = stJob.pCropCopy.get();
+                    vecRegions.back().stRect = stJob.stCropRect;
                 }
             }
 
-            return AX_SKEL_SUCC;
-        }
+            AX_S32 nRet = JENCOBJ->GetBatch(stBatch.stFrame, vecRegions, stBatch.nQpLevel);
 
-        AX_BOOL TrackerDealer::TrackFind(AX_U32 nStreamId, AX_U64 nTrackId, AX_SKEL_CROP_FRAME_T &stCropFrame) {
-            auto &trackMap = m_TrackMaps[nStreamId];
+            if (!stBatch.bCopied) {
+                dec_io_ref_cnt(stBatch.stFrame);
+            }
 
-            for (auto iter = trackMap.begin(); iter != trackMap.end();) {
-                if (iter->first == nTrackId) {
-                    stCropFrame = iter->second.stObjectItem.stCropFrame;
-                    return AX_TRUE;
-                }
+            std::vector<AX_BOOL> vecSucc(vecJobs.size(), AX_FALSE);
+            size_t nRegion = bPanoraEncode ? 1 : 0;
 
-                ++ iter;
+            for (size_t i = 0; i < vecJobs.size(); i++) {
+                auto &stJob = vecJobs[i];
+                vecSucc[i] = (nRet == AX_SKEL_SUCC) ? AX_TRUE : AX_FALSE;
+
+                if (stJob.bCropEncode) {
+                    const AX_SKEL_JENC_REGION_T &stRegion = vecRegions[nRegion ++];
+
+                    if (stRegion.nRet == AX_SKEL_SUCC && stRegion.pBuf) {
+                        m_Rate.Account(stRegion.nDstWidth * stRegion.nDstHeight, stBatch.nQpLevel, stRegion.nBufSize);
+                    }
+
+                    if (vecSucc[i] && stRegion.nRet == AX_SKEL_SUCC) {
+                        stJob.stCropFrame.nFrameId = stJob.nFrameId;
+                        stJob.stCropFrame.pFrameData = (AX_U8 *)stRegion.pBuf;
+                        stJob.stCropFrame.nFrameDataSize = stRegion.nBufSize;
+                        stJob.stCropFrame.nFrameWidth = stRegion.nDstWidth;
+                        stJob.stCropFrame.nFrameHeight = stRegion.nDstHeight;
+                    }
+                    else {
+                        vecSucc[i] = AX_FALSE;
+                    }
+                }
             }
 
-            return AX_FALSE;
-        }
+            // the stream may be closed meanwhile, the buffers are released then
+            std::unique_lock<std::mutex> lck;
+            PushStreamPtr pStream = StreamLock(stBatch.nStreamId, AX_FALSE, lck);
 
-        AX_BOOL TrackerDealer::FrameFind(AX_U32 nStreamId, AX_U64 nFrameId, AX_SKEL_CROP_FRAME_T &stPanoraFrame) {
-            auto &frameMap = m_FrameMaps[nStreamId];
+            if (pStream && pStream->nEncodePending > 0) {
+                pStream->nEncodePending --;
+            }
 
-            for (auto iter = frameMap.begin(); iter != frameMap.end();) {
-                if (iter->first == nFrameId) {
-                    stPanoraFrame = iter->second.stPanoraFrame;
+            // every push of the frame shares the panorama, pushed without it if it fails
+            if (bPanoraEncode) {
+                const AX_SKEL_JENC_REGION_T &stPanora = vecRegions[0];
+                AX_BOOL bTaken = AX_FALSE;
 
-                    return AX_TRUE;
+                if (stPanora.nRet == AX_SKEL_SUCC && stPanora.pBuf) {
+                    m_Rate.Account(stPanora.nDstWidth * stPanora.nDstHeight, stBatch.nQpLevel, stPanora.nBufSize);
                 }
 
-                ++ iter;
-            }
+                for (size_t i = 0; i < vecJobs.size() && stPanora.nRet == AX_SKEL_SUCC && stPanora.pBuf; i++) {
+                    auto &stJob = vecJobs[i];
+                    if (!vecSucc[i] || !stJob.bPanoraEncode) {
+                        continue;
+                    }
 
-            return AX_FALSE;
-        }
+                    // one reference per push
+                    if (bTaken) {
+                        JENCOBJ->Ref(stPanora.pBuf);
+                    }
 
-        AX_BOOL TrackerDealer::FrameFind(AX_U32 nStreamId, AX_U64 nFrameId) {
-            auto &frameMap = m_FrameMaps[nStreamId];
+                    bTaken = AX_TRUE;
 
-            for (auto iter = frameMap.begin(); iter != frameMap.end();) {
-                if (iter->first == nFrameId) {
-                    return AX_TRUE;
+                    stJob.stPanoraFrame.nFrameId = stJob.nFrameId;
+                    stJob.stPanoraFrame.pFrameData = (AX_U8 *)stPanora.pBuf;
+                    stJob.stPanoraFrame.nFrameDataSize = stPanora.nBufSize;
+                    stJob.stPanoraFrame.nFrameWidth = stPanora.nDstWidth;
+                    stJob.stPanoraFrame.nFrameHeight = stPanora.nDstHeight;
                 }
 
-                ++ iter;
-            }
+                // and so do the later pushes while the frame is tracked
+                if (pStream && stPanora.nRet == AX_SKEL_SUCC && stPanora.pBuf) {
+                    auto iterFrame = pStream->mapFrames.find(stBatch.nFrameId);
+                    if (iterFrame != pStream->mapFrames.end() && !iterFrame->second->stPanoraFrame.pFrameData) {
+                        if (bTaken) {
+                            JENCOBJ->Ref(stPanora.pBuf);
+                        }
 
-            return AX_FALSE;
-        }
+                        bTaken = AX_TRUE;
 
-        AX_S32 TrackerDealer::TrackDelete(AX_U32 nStreamId, AX_U64 nTrackId, AX_BOOL bForce/* = AX_FALSE*/) {
-            auto &trackMap = m_TrackMaps[nStreamId];
+                        AX_SKEL_CROP_FRAME_T &stPanoraFrame = iterFrame->second->stPanoraFrame;
+                        stPanoraFrame.nFrameId = stBatch.nFrameId;
+                        stPanoraFrame.pFrameData = (AX_U8 *)stPanora.pBuf;
+                        stPanoraFrame.nFrameDataSize = stPanora.nBufSize;
+                        stPanoraFrame.nFrameWidth = stPanora.nDstWidth;
+                        stPanoraFrame.nFrameHeight = stPanora.nDstHeight;
+                    }
+                }
 
-            for (auto iter = trackMap.begin(); iter != trackMap.end();) {
-                if (iter->first == nTrackId) {
-                    // release jenc buffer
-                    PUSH_JENC_REL(iter->second.stObjectItem.stCropFrame.pFrameData);
+                if (!bTaken) {
+                    JENCOBJ->Rel(stPanora.pBuf);
+                }
+            }
 
-                    // clear panoraFrame buffer
-                    FrameDelete(nStreamId, iter->second.stObjectItem.nFrameId, nTrackId);
+            for (size_t i = 0; i < vecJobs.size(); i++) {
+                EncodeDone(pStream.get(), vecJobs[i], vecSucc[i]);
+            }
+        }
 
-                    iter->second.stObjectItem.bPanoraFrame = AX_FALSE;
-                    memset(&iter->second.stObjectItem.stPanoraFrame, 0x00, sizeof(iter->second.stObjectItem.stPanoraFrame));
+        AX_VOID TrackerDealer::EncodeDone(AX_SKEL_PUSH_STREAM_T *pStream, AX_SKEL_PUSH_ENCODE_JOB_T &stJob, AX_BOOL bSucc) {
+            if (!pStream) {
+                PUSH_JENC_REL(stJob.stCropFrame.pFrameData);
+                PUSH_JENC_REL(stJob.stPanoraFrame.pFrameData);
+                return;
+            }
 
-                    // release track map
-                    if (((m_stParam.stPushStrategy.ePushMode == AX_SKEL_PUSH_MODE_FAST
-                          || m_stParam.stPushStrategy.ePushMode == AX_SKEL_PUSH_MODE_INTERVAL)
-                         && iter->second.nPushCounts >= m_stParam.stPushStrategy.nPushCounts)
-                        || m_stParam.stPushStrategy.ePushMode == AX_SKEL_PUSH_MODE_BEST
-                        || bForce) {
-                        trackMap.erase(iter++);
-                    }
+            auto &stStream = *pStream;
+            AX_SKEL_PUSH_TRACK_T *pTrack = TrackFind(stStream, stJob.nTrackId);
 
-                    return AX_SKEL_SUCC;
+            if (pTrack) {
+                pTrack->bEncoding = AX_FALSE;
+            }
+
+            if (stJob.bDeliver && bSucc) {
+                AX_SKEL_OBJECT_ITEM_T stObjectItem = stJob.stObjectItem;
+                stObjectItem.eTrackState = AX_SKEL_TRACK_STATUS_SELECT;
+                stObjectItem.stRect = {0, 0, 0, 0};
+                stObjectItem.bCropFrame = AX_TRUE;
+                stObjectItem.stCropFrame = stJob.stCropFrame;
+                stObjectItem.bPanoraFrame = stJob.stPanoraFrame.pFrameData ? AX_TRUE : AX_FALSE;
+                stObjectItem.stPanoraFrame = stJob.stPanoraFrame;
+                stStream.vecPushDone.push_back(stObjectItem);
+
+                // best shot of a dead track, nothing left to push
+                if (pTrack && pTrack->eTrackLastState == AX_SKEL_TRACK_STATUS_DIE) {
+                    TrackErase(stStream, pTrack);
                 }
 
-                ++ iter;
+                return;
             }
 
-            return AX_SKEL_SUCC;
-        }
+            // keep the buffers if the track still holds the item they were encoded for
+            if (pTrack && pTrack->stObjectItem.nFrameId == stJob.nFrameId) {
+                auto &stObjectStore = pTrack->stObjectItem;
 
-        AX_S32 TrackerDealer::FrameDelete(AX_U32 nStreamId, AX_U64 nFrameId, AX_U64 nTrackId) {
-            auto &frameMap = m_FrameMaps[nStreamId];
+                if (stJob.stCropFrame.pFrameData && !stObjectStore.stCropFrame.pFrameData) {
+                    stObjectStore.bCropFrame = AX_TRUE;
+                    stObjectStore.stCropFrame = stJob.stCropFrame;
+                    stJob.stCropFrame.pFrameData = nullptr;
 
-            for (auto iter = frameMap.begin(); iter != frameMap.end();) {
-                if (iter->first == nFrameId) {
-                    iter->second.liTrackList.remove(nTrackId);
+                    // encoded, the copy is not needed anymore
+                    pTrack->pCropCopy.reset();
+                }
 
-                    // track list empty
-                    if (iter->second.liTrackList.size() == 0) {
-                        // release jenc buffer
-                        PUSH_JENC_REL(iter->second.stPanoraFrame.pFrameData);
+                if (stJob.stPanoraFrame.pFrameData && !stObjectStore.stPanoraFrame.pFrameData) {
+                    stObjectStore.bPanoraFrame = AX_TRUE;
+                    stObjectStore.stPanoraFrame = stJob.stPanoraFrame;
+                    stJob.stPanoraFrame.pFrameData = nullptr;
+                }
 
-                        if (!iter->second.stCacheFrame.bFrameDrop) {
-                            dec_io_ref_cnt(iter->second.stCacheFrame.stFrame);
-                            iter->second.stCacheFrame.bFrameDrop = AX_TRUE;
-                        }
+                if (!bSucc) {
+                    // reset object confidence
+                    stObjectStore.fConfidence = 0;
+                }
+            }
 
-                        frameMap.erase(iter++);
-                    }
-                    break;
+            if (!bSucc) {
+                ALOGW("SKEL push encode fail, trackId: %llu, FrameId: %llu", (unsigned long long)stJob.nTrackId, (unsigned long long)stJob.nFrameId);
+            }
+
+            if (stJob.bDeliver && pTrack) {
+                if (pTrack->nPushCounts > 0) {
+                    pTrack->nPushCounts --;
                 }
 
-                ++ iter;
+                if (pTrack->eTrackLastState == AX_SKEL_TRACK_STATUS_DIE) {
+                    TrackRelease(stStream, pTrack);
+
+                    stStream.vecPushDone.push_back(pTrack->stObjectItem);
+
+                    stStream.mapTracks.erase(pTrack->nTrackId);
+                    stStream.poolTracks.Free(pTrack);
+                }
             }
 
-            return AX_SKEL_SUCC;
+            PUSH_JENC_REL(stJob.stCropFrame.pFrameData);
+            PUSH_JENC_REL(stJob.stPanoraFrame.pFrameData);
         }
 
         AX_S32 TrackerDealer::GetConfig(AX_SKEL_PARAM_T &stParam) {
-            std::lock_guard<std::mutex> lck(m_mtxSet);
-
-            stParam = m_stParam;
+            stParam = m_Param.Load()->Param();
 
             return AX_SKEL_SUCC;
         }
 
         AX_S32 TrackerDealer::SetConfig(const AX_SKEL_PARAM_T &stParam) {
             std::lock_guard<std::mutex> lck(m_mtxSet);
+            const AX_SKEL_PARAM_T &stCurParam = m_Param.Load()->Param();
 
             // clear maps
             if (!stParam.bPushEnable
-                || stParam.stPushStrategy.ePushMode != m_stParam.stPushStrategy.ePushMode
-                || stParam.stPushStrategy.nIntervalTimes != m_stParam.stPushStrategy.nIntervalTimes
-                || stParam.stPushStrategy.nPushCounts != m_stParam.stPushStrategy.nPushCounts
-                || stParam.stPushStrategy.bPushSameFrame != m_stParam.stPushStrategy.bPushSameFrame) {
-                std::lock_guard<std::mutex> lck(m_mtxMaps);
+                || stParam.stPushStrategy.ePushMode != stCurParam.stPushStrategy.ePushMode
+                || stParam.stPushStrategy.nIntervalTimes != stCurParam.stPushStrategy.nIntervalTimes
+                || stParam.stPushStrategy.nPushCounts != stCurParam.stPushStrategy.nPushCounts
+                || stParam.stPushStrategy.bPushSameFrame != stCurParam.stPushStrategy.bPushSameFrame) {
+                m_Param.Store(stParam);
+                m_Rate.Configure(stParam.nPushByteRate, (AX_U32)stParam.fCropEncoderQpLevel);
                 ClearPush();
+
+                return AX_SKEL_SUCC;
             }
 
-            m_stParam = stParam;
+            // takes effect from the next frame
+            m_Param.Store(stParam);
+            m_Rate.Configure(stParam.nPushByteRate, (AX_U32)stParam.fCropEncoderQpLevel);
 
             return AX_SKEL_SUCC;
         }
@@ -1216,83 +1828,101 @@ namespace skel {
         AX_S32 TrackerDealer::Statistics(AX_VOID) {
             ALOGN("Push Statistics:");
 
-            if (m_TrackMaps.size() > 0) {
-                for (auto iterStream = m_TrackMaps.begin(); iterStream != m_TrackMaps.end();) {
-                    if (iterStream->second.size() > 0) {
-                        ALOGN("\tStream[%d] Track Maps:", iterStream->first);
-                        for (auto iter = iterStream->second.begin(); iter != iterStream->second.end();) {
-                            ALOGN("\t\tTrack Id[%lld]: (N: %d, U:%d, L: %d, S: %d, F: %lld, C:%p, P:%p, c=%f)",
-                                  iter->first, iter->second.nPushCounts, iter->second.nUpdateCounts,
-                                  iter->second.eTrackLastState, iter->second.stObjectItem.eTrackState,
-                                  iter->second.stObjectItem.nFrameId,
-                                  iter->second.stObjectItem.stCropFrame.pFrameData,
-                                  iter->second.stObjectItem.stPanoraFrame.pFrameData,
-                                  iter->second.stObjectItem.fConfidence);
-                            ++ iter;
+            vector<PushStreamPtr> vecStreams;
+            {
+                std::lock_guard<std::mutex> lck(m_mtxMaps);
+                for (auto iterStream = m_PushStreams.begin(); iterStream != m_PushStreams.end(); ++ iterStream) {
+                    vecStreams.push_back(iterStream->second);
+                }
+            }
+
+            AX_U32 nTrackUsed = 0;
+            AX_U32 nTrackCapacity = 0;
+            AX_U32 nFrameUsed = 0;
+            AX_U32 nFrameCapacity = 0;
+
+            if (vecStreams.size() > 0) {
+                for (auto &pStream : vecStreams) {
+                    std::lock_guard<std::mutex> lck(pStream->mtx);
+                    auto &stStream = *pStream;
+
+                    nTrackUsed += stStream.poolTracks.Used();
+                    nTrackCapacity += stStream.poolTracks.Capacity();
+                    nFrameUsed += stStream.poolFrames.Used();
+                    nFrameCapacity += stStream.poolFrames.Capacity();
+
+                    if (stStream.mapTracks.size() > 0) {
+                        ALOGN("\tStream[%d] Track Maps:", stStream.nStreamId);
+                        for (auto iter = stStream.mapTracks.begin(); iter != stStream.mapTracks.end(); ++ iter) {
+                            AX_SKEL_PUSH_TRACK_T *pTrack = iter->second;
+                            ALOGN("\t\tTrack Id[%llu]: (N: %d, U:%d, L: %d, S: %d, E: %d, F: %llu, C:%p, P:%p, c=%f)",
+                                  (unsigned long long)iter->first, pTrack->nPushCounts, pTrack->nUpdateCounts,
+                                  pTrack->eTrackLastState, pTrack->stObjectItem.eTrackState, pTrack->bEncoding,
+                                  (unsigned long long)pTrack->stObjectItem.nFrameId,
+                                  pTrack->stObjectItem.stCropFrame.pFrameData,
+                                  pTrack->stObjectItem.stPanoraFrame.pFrameData,
+                                  pTrack->stObjectItem.fConfidence);
                         }
                     }
                     else {
-                        ALOGN("\tStream[%d] Track Maps: nil", iterStream->first);
+                        ALOGN("\tStream[%d] Track Maps: nil", stStream.nStreamId);
                     }
 
-                    ++ iterStream;
-                }
-            }
-            else {
-                ALOGN("\tTrack Maps: nil");
-            }
-
-            if (m_FrameMaps.size() > 0) {
-                for (auto iterStream = m_FrameMaps.begin(); iterStream != m_FrameMaps.end();) {
-                    if (iterStream->second.size() > 0) {
-                        ALOGN("\tStream[%d] Frame Maps:", iterStream->first);
-                        for (auto iter = iterStream->second.begin(); iter != iterStream->second.end();) {
-                            ALOGN("\t\tFrame Id[%lld]: (T:%ld, F: %lld, P=%p)",
-                                  iter->first,
-                                  iter->second.liTrackList.size(),
-                                  iter->second.stPanoraFrame.nFrameId,
-                                  iter->second.stPanoraFrame.pFrameData);
-                            if (iter->second.liTrackList.size() > 0) {
-                                for (auto iterList = iter->second.liTrackList.begin(); iterList != iter->second.liTrackList.end();) {
-                                    ALOGN("\t\t\tTrack Id[%lld]", *iterList);
-                                    ++ iterList;
-                                }
+                    if (stStream.mapFrames.size() > 0) {
+                        ALOGN("\tStream[%d] Frame Maps:", stStream.nStreamId);
+                        for (auto iter = stStream.mapFrames.begin(); iter != stStream.mapFrames.end(); ++ iter) {
+                            AX_SKEL_PUSH_FRAME_T *pFrame = iter->second;
+                            ALOGN("\t\tFrame Id[%llu]: (T:%d, S:%d, D:%d)",
+                                  (unsigned long long)iter->first,
+                                  pFrame->nRefCount,
+                                  pFrame->nCacheSlot,
+                                  pFrame->stCacheFrame.bFrameDrop);
+                            for (AX_SKEL_PUSH_TRACK_T *pTrack = pFrame->pTrackHead; pTrack; pTrack = pTrack->pNext) {
+                                ALOGN("\t\t\tTrack Id[%llu]", (unsigned long long)pTrack->nTrackId);
                             }
-                            ++ iter;
                         }
                     }
                     else {
-                        ALOGN("\t\tStream[%d] Frame Maps: nil", iterStream->first);
+                        ALOGN("\t\tStream[%d] Frame Maps: nil", stStream.nStreamId);
                     }
 
-                    ++ iterStream;
-                }
-            }
-            else {
-                ALOGN("\t\tFrame Maps: nil");
-            }
+                    if (stStream.vecPushDone.size() > 0) {
+                        ALOGN("\tStream[%d] Push Done: %zu", stStream.nStreamId, stStream.vecPushDone.size());
+                    }
 
-            if (m_CacheListVec.size() > 0) {
-                for (auto iterStream = m_CacheListVec.begin(); iterStream != m_CacheListVec.end();) {
-                    if (iterStream->second.size() > 0) {
-                        ALOGN("\tStream[%d] Cache List:", iterStream->first);
-                        for (auto iter = iterStream->second.begin(); iter != iterStream->second.end();) {
-                            ALOGN("\t\tCache Id[%lld]",
-                                  iter->nFrameId);
-                            ++ iter;
+                    if (stStream.nCacheCount > 0) {
+                        ALOGN("\tStream[%d] Cache Ring(%zu): pinned %d (%llu bytes)", stStream.nStreamId, stStream.vecCacheRing.size(),
+                              stStream.nCachePinned, (unsigned long long)stStream.nCacheBytes);
+                        for (AX_U32 i = 0; i < stStream.nCacheCount; i++) {
+                            AX_SKEL_PUSH_FRAME_T *pFrame = stStream.vecCacheRing[(stStream.nCacheHead + i) % stStream.vecCacheRing.size()];
+                            if (pFrame) {
+                                ALOGN("\t\tCache Id[%llu]", (unsigned long long)pFrame->stCacheFrame.nFrameId);
+                            }
                         }
                     }
                     else {
-                        ALOGN("\tStream[%d] Cache List: nil", iterStream->first);
+                        ALOGN("\tStream[%d] Cache Ring: nil", stStream.nStreamId);
                     }
-
-                    ++ iterStream;
                 }
             }
             else {
-                ALOGN("\tCache List: nil");
+                ALOGN("\tPush Maps: nil");
+            }
+
+            ALOGN("\tPool: track %d/%d, frame %d/%d", nTrackUsed, nTrackCapacity, nFrameUsed, nFrameCapacity);
+
+            ALOGN("\tCache: pinned %d (%llu bytes)/%d, global %d/%d, budget evicts %llu",
+                  m_nCachePinned.load(), (unsigned long long)m_nCacheBytes.load(), m_Param.Load()->Param().nFrameCacheBudget,
+                  s_nCachePinnedGlobal.load(), m_nBudgetGlobal, (unsigned long long)m_nBudgetEvicts.load());
+            {
+                std::lock_guard<std::mutex> lck(m_mtxCopy);
+                ALOGN("\tCopy: %llu bytes, pool %llu bytes", (unsigned long long)m_nCopyBytes.load(), (unsigned long long)m_nCopyCached);
             }
 
+            ALOGN("\tEncode: workers %d, dropped %llu pushes on a full queue",
+                  m_EncodeWorkers.Size(), (unsigned long long)m_nEncodeDrops.load());
+
+            m_Rate.Statistics();
             JENCOBJ->Statistics();
 
             return AX_SKEL_SUCC;
@@ -13,12 +13,18 @@
 
 #include "ax_skel_type.h"
 #include "api/ax_skel_def.h"
+#include "utils/slab_pool.h"
+#include "utils/param_snapshot.h"
+#include "utils/worker_pool.h"
+#include "utils/jenc_rate.h"
 
+#include <atomic>
 #include <chrono>
+#include <memory>
 #include <unordered_map>
+#include <unordered_set>
 #include <mutex>
 #include <vector>
-#include <list>
 
 namespace skel {
     namespace utils {
@@ -34,33 +40,174 @@ namespace skel {
             }
         } AX_SKEL_PUSH_CACHE_LIST_T;
 
-        typedef struct axSKEL_PUSH_TRACK_MAPS {
+        struct axSKEL_PUSH_FRAME_T;
+
+        // cached frames of one stream newest first, immutable once published
+        typedef std::shared_ptr<const std::vector<AX_SKEL_FRAME_CACHE_LIST_T>> PushCacheListPtr;
+        // the published lists of all streams caching a frame, what a result reports as its cache list
+        typedef std::shared_ptr<const std::vector<PushCacheListPtr>> PushCacheListsPtr;
+
+        // private CMM copy of a part of a source frame, freed or given back to its pool with the last reference
+        typedef std::shared_ptr<AX_VIDEO_FRAME_T> PushCopyPtr;
+
+        typedef struct axSKEL_PUSH_TRACK_T {
+            AX_U64 nTrackId;
+            AX_S32 nLabel;                      // SKEL_LABEL_E of the object category, -1 if unknown
             AX_U32 nPushCounts;
             AX_U32 nUpdateCounts;
             AX_SKEL_TRACK_STATUS_E eTrackLastState;
-            AX_SKEL_OBJECT_ITEM_T stObjectItem;
+            AX_SKEL_OBJECT_ITEM_T stObjectItem; // owns the crop and panorama jenc buffers
+            AX_F32 fQuality;                    // best shot score of stObjectItem, see utils/quality.h
+            AX_BOOL bEncoding;                  // a push encode job is pending, the track is not pushed again until it is done
             std::chrono::steady_clock::time_point updateTime;
             std::chrono::steady_clock::time_point pushTime;
+            PushCopyPtr pCropCopy;              // expanded object region of stObjectItem if its frame is copied
 
-            axSKEL_PUSH_TRACK_MAPS() {
+            // frame of stObjectItem, the track is linked in its track list
+            axSKEL_PUSH_FRAME_T *pFrame;
+            axSKEL_PUSH_TRACK_T *pPrev;
+            axSKEL_PUSH_TRACK_T *pNext;
+
+            explicit axSKEL_PUSH_TRACK_T(AX_U64 nId) {
+                nTrackId = nId;
+                nLabel = -1;
                 nPushCounts = 0;
                 nUpdateCounts = 1;
                 eTrackLastState = AX_SKEL_TRACK_STATUS_NEW;
                 memset(&stObjectItem, 0x00, sizeof(stObjectItem));
+                bEncoding = AX_FALSE;
+                fQuality = 0;
                 updateTime = std::chrono::steady_clock::now();
                 pushTime = std::chrono::steady_clock::now();
+                pFrame = nullptr;
+                pPrev = nullptr;
+                pNext = nullptr;
             }
-        } AX_SKEL_PUSH_TRACK_MAPS;
+        } AX_SKEL_PUSH_TRACK_T;
 
-        typedef struct axSKEL_PUSH_FRAME_MAPS {
-            std::list<AX_U64> liTrackList;
+        typedef struct axSKEL_PUSH_FRAME_T {
+            AX_U32 nRefCount;                   // tracks linked in pTrackHead
+            AX_S32 nCacheSlot;                  // slot in the stream cache ring, -1 if not cached
+            AX_SKEL_PUSH_TRACK_T *pTrackHead;
             AX_SKEL_PUSH_CACHE_LIST_T stCacheFrame;
-            AX_SKEL_CROP_FRAME_T stPanoraFrame;
+            AX_BOOL bCopied;                    // the tracks hold crop copies, the source frame is not cached
+            PushCopyPtr pPanoraCopy;            // downscaled whole frame, only with panorama push
+            AX_SKEL_CROP_FRAME_T stPanoraFrame; // encoded panorama, shared by the later pushes of the frame
 
-            axSKEL_PUSH_FRAME_MAPS() {
+            axSKEL_PUSH_FRAME_T() {
+                nRefCount = 0;
+                nCacheSlot = -1;
+                pTrackHead = nullptr;
+                bCopied = AX_FALSE;
                 memset(&stPanoraFrame, 0x00, sizeof(stPanoraFrame));
             }
-        } AX_SKEL_PUSH_FRAME_MAPS;
+        } AX_SKEL_PUSH_FRAME_T;
+
+        // one push encoded off the tracking path
+        typedef struct axSKEL_PUSH_ENCODE_JOB_T {
+            AX_U32 nStreamId;
+            AX_U64 nTrackId;
+            AX_U64 nFrameId;
+            AX_BOOL bDeliver;                   // push stObjectItem once encoded, otherwise only store the crop into the track
+            AX_BOOL bCropEncode;
+            AX_BOOL bPanoraEncode;
+            AX_SKEL_RECT_T stCropRect;          // zero with pCropCopy
+            PushCopyPtr pCropCopy;
+            AX_SKEL_OBJECT_ITEM_T stObjectItem;
+            AX_SKEL_CROP_FRAME_T stCropFrame;
+            AX_SKEL_CROP_FRAME_T stPanoraFrame;
+        } AX_SKEL_PUSH_ENCODE_JOB_T;
+
+        // the pushes of one source frame, encoded in one submission. the frame io ref is held until it is done
+        typedef struct axSKEL_PUSH_ENCODE_BATCH_T {
+            AX_U32 nStreamId;
+            AX_U64 nFrameId;
+            AX_U32 nQpLevel;                    // from the rate control when submitted
+            AX_VIDEO_FRAME_T stFrame;
+            AX_BOOL bCopied;                    // encoded from the copies of the frame, no io ref is held
+            PushCopyPtr pPanoraCopy;
+            AX_U32 nPanoraWidth;                // resize_panorama_encoder_config of the source frame, 0 encodes it as is
+            AX_U32 nPanoraHeight;
+            std::vector<AX_SKEL_PUSH_ENCODE_JOB_T> vecJobs;
+        } AX_SKEL_PUSH_ENCODE_BATCH_T;
+
+        // buckets of the track and frame maps of a stream, the tables are not rehashed below this
+        #define PUSH_STREAM_MAP_BUCKETS 64
+
+        // nodes come from the arena of the stream, inserting allocates nothing once it has grown
+        typedef std::unordered_map<AX_U64, AX_SKEL_PUSH_TRACK_T*, std::hash<AX_U64>, std::equal_to<AX_U64>,
+                SlabAllocator<std::pair<const AX_U64, AX_SKEL_PUSH_TRACK_T*>>> PushTrackMap;
+        typedef std::unordered_map<AX_U64, AX_SKEL_PUSH_FRAME_T*, std::hash<AX_U64>, std::equal_to<AX_U64>,
+                SlabAllocator<std::pair<const AX_U64, AX_SKEL_PUSH_FRAME_T*>>> PushFrameMap;
+
+        // the push state of one stream, locked on its own so the streams never wait for each other
+        typedef struct axSKEL_PUSH_STREAM_T {
+            std::mutex mtx;                     // guards all below
+            AX_BOOL bClosed;                    // cleared and out of the stream map, the holder looks it up again
+            AX_U32 nStreamId;
+            ParamSnapshotPtr pParam;            // of the frame in progress, see StreamParam
+            AX_BOOL bFrameParam;                // pParam is loaded for nParamFrameId, cleared by Finalize
+            AX_U64 nParamFrameId;
+            SlabPool<AX_SKEL_PUSH_TRACK_T> poolTracks;
+            SlabPool<AX_SKEL_PUSH_FRAME_T> poolFrames;
+            SlabArena arenaMaps;                // declared before the maps, outlives them
+            PushTrackMap mapTracks;
+            PushFrameMap mapFrames;
+
+            // frames holding an io ref, oldest at nCacheHead. released frames leave a nil slot
+            std::vector<AX_SKEL_PUSH_FRAME_T*> vecCacheRing;
+            AX_U32 nCacheHead;
+            AX_U32 nCacheCount;
+            AX_U32 nCachePinned;                // frames in vecCacheRing, nil slots excluded
+            AX_U64 nCacheBytes;
+
+            // pushes collected during Finalize, one batch per source frame, submitted at its end
+            std::vector<AX_SKEL_PUSH_ENCODE_BATCH_T> vecEncodeBatch;
+            AX_U32 nEncodePending;              // batches submitted and not done, the load the rate control sees
+            // pushes encoded by the encode workers, delivered with the next result of the stream
+            std::vector<AX_SKEL_OBJECT_ITEM_T> vecPushDone;
+
+            AX_BOOL bCacheChanged;              // frames entered or left vecCacheRing since StreamPublish
+
+            axSKEL_PUSH_STREAM_T():
+                    mapTracks(PUSH_STREAM_MAP_BUCKETS, std::hash<AX_U64>(), std::equal_to<AX_U64>(),
+                              PushTrackMap::allocator_type(&arenaMaps)),
+                    mapFrames(PUSH_STREAM_MAP_BUCKETS, std::hash<AX_U64>(), std::equal_to<AX_U64>(),
+                              PushFrameMap::allocator_type(&arenaMaps)) {
+                bClosed = AX_FALSE;
+                nStreamId = 0;
+                bFrameParam = AX_FALSE;
+                nParamFrameId = 0;
+                nCacheHead = 0;
+                nCacheCount = 0;
+                nCachePinned = 0;
+                nCacheBytes = 0;
+                nEncodePending = 0;
+                bCacheChanged = AX_FALSE;
+            }
+        } AX_SKEL_PUSH_STREAM_T;
+
+        typedef std::shared_ptr<AX_SKEL_PUSH_STREAM_T> PushStreamPtr;
+
+        // VB blocks pinned by the frame caches, one block per cached frame. a budget of 0 is unlimited
+        typedef struct axSKEL_PUSH_CACHE_OCCUPANCY_T {
+            AX_U32 nPinned;
+            AX_U64 nPinnedBytes;
+            AX_U32 nBudget;
+            AX_U32 nPinnedGlobal;               // all handles of the process
+            AX_U32 nBudgetGlobal;
+            AX_U64 nBudgetEvicts;               // frames evicted early to keep in budget
+            AX_U64 nCopyBytes;                  // held by the private copies instead
+        } AX_SKEL_PUSH_CACHE_OCCUPANCY_T;
+
+        // what tells the push modes apart when a track is updated
+        typedef struct axSKEL_PUSH_POLICY_T {
+            AX_BOOL bPushCountsLimit;   // the track is dropped once nPushCounts are pushed
+            AX_BOOL bPushTimeOnNew;     // the push interval starts when the track is new
+            AX_BOOL bDieDelete;         // die drops the track at once instead of updating it
+            AX_BOOL bRenewOnReplace;    // a better item restarts the push counts and time
+            AX_BOOL bQualityScore;      // items are ranked by QualityScore instead of confidence
+        } AX_SKEL_PUSH_POLICY_T;
 
 
         class TrackerDealer    {
@@ -69,38 +216,91 @@ namespace skel {
             virtual ~TrackerDealer(AX_VOID);
 
         public:
-            virtual AX_S32 Update(const AX_SKEL_FRAME_T *pstFrame, AX_SKEL_OBJECT_ITEM_T &stObjectItem);
+            // the objects of one frame, the stream is looked up and locked once for them. items of a frame not
+            // detected, only predicted, keep their tracks alive and are never pushed
+            virtual AX_S32 Update(const AX_SKEL_FRAME_T *pstFrame, std::vector<AX_SKEL_OBJECT_ITEM_T> &vecObjectItem, AX_BOOL bDetected = AX_TRUE);
             virtual AX_S32 Release(AX_U32 nStreamId, const AX_SKEL_OBJECT_ITEM_T &stObjectItem);
-            virtual AX_S32 Finalize(const AX_SKEL_FRAME_T *pstFrame, AX_SKEL_RESULT_T *pstResult, std::vector<AX_SKEL_OBJECT_ITEM_T> &vecObjectItem);
+            // pCacheLists is set to the cache list of the result, vecObjectItem gets the pushes appended
+            virtual AX_S32 Finalize(const AX_SKEL_FRAME_T *pstFrame, PushCacheListsPtr &pCacheLists, std::vector<AX_SKEL_OBJECT_ITEM_T> &vecObjectItem);
             virtual AX_S32 GetConfig(AX_SKEL_PARAM_T &stParam);
             virtual AX_S32 SetConfig(const AX_SKEL_PARAM_T &stParam);
             virtual AX_S32 Statistics(AX_VOID);
+            // pushes dropped on a full encode queue
+            AX_U64 EncodeDrops(AX_VOID) {
+                return m_nEncodeDrops.load();
+            }
+            // a closed stream is not created again by Update/Finalize until it is opened
+            virtual AX_S32 CloseStream(AX_U32 nStreamId);
+            virtual AX_S32 OpenStream(AX_U32 nStreamId);
+            virtual AX_S32 CacheOccupancy(AX_SKEL_PUSH_CACHE_OCCUPANCY_T &stOccupancy);
+            virtual AX_S32 EncodeRate(AX_SKEL_JENC_RATE_STAT_T &stStat);
 
         private:
+            static AX_BOOL GetPushPolicy(AX_SKEL_PUSH_MODE_E ePushMode, AX_SKEL_PUSH_POLICY_T &stPolicy);
+
             AX_S32 ClearPush(AX_VOID);
-            AX_S32 CachePush(const AX_SKEL_FRAME_T *pstFrame);
-            AX_S32 TrackPush(AX_U32 nStreamId, const AX_SKEL_PUSH_CACHE_LIST_T &stCacheFrame, AX_SKEL_OBJECT_ITEM_T &stObjectItem);
-            AX_S32 UpdateFast(const AX_SKEL_FRAME_T *pstFrame, AX_SKEL_OBJECT_ITEM_T &stObjectItem);
-            AX_S32 UpdateInterval(const AX_SKEL_FRAME_T *pstFrame, AX_SKEL_OBJECT_ITEM_T &stObjectItem);
-            AX_S32 UpdateBest(const AX_SKEL_FRAME_T *pstFrame, AX_SKEL_OBJECT_ITEM_T &stObjectItem);
-            AX_S32 FinalizeFast(AX_U32 nStreamId, std::vector<AX_SKEL_OBJECT_ITEM_T> &vecObjectItem, std::vector<AX_SKEL_PUSH_CACHE_LIST_T> &dropCacheListVec);
-            AX_S32 FinalizeInterval(AX_U32 nStreamId, std::vector<AX_SKEL_OBJECT_ITEM_T> &vecObjectItem, std::vector<AX_SKEL_PUSH_CACHE_LIST_T> &dropCacheListVec);
-            AX_S32 FinalizeBest(AX_U32 nStreamId, std::vector<AX_SKEL_OBJECT_ITEM_T> &vecObjectItem, std::vector<AX_SKEL_PUSH_CACHE_LIST_T> &dropCacheListVec);
-            AX_S32 TrackDelete(AX_U32 nStreamId, AX_U64 nTrackId, AX_BOOL bForce = AX_FALSE);
-            AX_S32 FrameDelete(AX_U32 nStreamId, AX_U64 nFrameId, AX_U64 nTrackId);
-            AX_BOOL TrackFind(AX_U32 nStreamId, AX_U64 nTrackId, AX_SKEL_CROP_FRAME_T &stCropFrame);
-            AX_BOOL FrameFind(AX_U32 nStreamId, AX_U64 nFrameId, AX_SKEL_CROP_FRAME_T &stPanoraFrame);
-            AX_BOOL FrameFind(AX_U32 nStreamId, AX_U64 nFrameId);
-            AX_BOOL PushFliter(AX_SKEL_OBJECT_ITEM_T &stObjectItem);
+            AX_VOID ClearStream(AX_SKEL_PUSH_STREAM_T &stStream);
+            PushStreamPtr StreamLock(AX_U32 nStreamId, AX_BOOL bCreate, std::unique_lock<std::mutex> &lck);
+            AX_VOID StreamParam(AX_SKEL_PUSH_STREAM_T &stStream, AX_U64 nFrameId);
+            AX_VOID StreamPublish(AX_SKEL_PUSH_STREAM_T &stStream);
+            AX_U32 CacheDepth(const AX_SKEL_PUSH_STREAM_T &stStream);
+            AX_VOID CacheEvict(AX_SKEL_PUSH_STREAM_T &stStream, std::vector<AX_SKEL_PUSH_CACHE_LIST_T> &dropCacheListVec);
+            AX_VOID CacheResize(AX_SKEL_PUSH_STREAM_T &stStream, AX_U32 nDepth, std::vector<AX_SKEL_PUSH_CACHE_LIST_T> &dropCacheListVec);
+            AX_BOOL CachePush(AX_SKEL_PUSH_STREAM_T &stStream, AX_SKEL_PUSH_FRAME_T *pFrame, std::vector<AX_SKEL_PUSH_CACHE_LIST_T> &dropCacheListVec);
+            AX_VOID CacheBudget(AX_SKEL_PUSH_STREAM_T &stStream, std::vector<AX_SKEL_PUSH_CACHE_LIST_T> &dropCacheListVec);
+            AX_VOID CachePin(AX_SKEL_PUSH_STREAM_T &stStream, AX_SKEL_PUSH_FRAME_T *pFrame);
+            AX_VOID CacheUnpin(AX_SKEL_PUSH_STREAM_T &stStream, AX_SKEL_PUSH_FRAME_T *pFrame);
+            AX_BOOL FrameCopy(AX_SKEL_PUSH_STREAM_T &stStream, AX_SKEL_PUSH_FRAME_T *pFrame);
+            PushCopyPtr CopyAlloc(AX_U32 nWidth, AX_U32 nHeight, AX_IMG_FORMAT_E eFormat);
+            AX_VOID CopyFree(AX_VIDEO_FRAME_T *pCopy, AX_S32 nClass, AX_U32 nCapacity);
+            AX_S32 TrackPush(AX_SKEL_PUSH_STREAM_T &stStream, AX_SKEL_PUSH_TRACK_T *pTrack, AX_BOOL bDeliver, std::vector<AX_SKEL_OBJECT_ITEM_T> &vecObjectItem);
+            AX_VOID TrackDeliver(AX_SKEL_PUSH_TRACK_T *pTrack, std::vector<AX_SKEL_OBJECT_ITEM_T> &vecObjectItem);
+            AX_VOID EncodeSubmit(AX_SKEL_PUSH_STREAM_T &stStream);
+            AX_VOID EncodeTask(AX_SKEL_PUSH_ENCODE_BATCH_T &stBatch);
+            AX_VOID EncodeDone(AX_SKEL_PUSH_STREAM_T *pStream, AX_SKEL_PUSH_ENCODE_JOB_T &stJob, AX_BOOL bSucc);
+            AX_S32 UpdateTrack(AX_SKEL_PUSH_STREAM_T &stStream, const AX_SKEL_FRAME_T *pstFrame, AX_SKEL_OBJECT_ITEM_T &stObjectItem, const AX_SKEL_PUSH_POLICY_T &stPolicy, AX_BOOL bDetected);
+            AX_S32 FinalizeFast(AX_SKEL_PUSH_STREAM_T &stStream, std::vector<AX_SKEL_OBJECT_ITEM_T> &vecObjectItem, std::vector<AX_SKEL_PUSH_CACHE_LIST_T> &dropCacheListVec);
+            AX_S32 FinalizeInterval(AX_SKEL_PUSH_STREAM_T &stStream, std::vector<AX_SKEL_OBJECT_ITEM_T> &vecObjectItem, std::vector<AX_SKEL_PUSH_CACHE_LIST_T> &dropCacheListVec);
+            AX_S32 FinalizeBest(AX_SKEL_PUSH_STREAM_T &stStream, std::vector<AX_SKEL_OBJECT_ITEM_T> &vecObjectItem, std::vector<AX_SKEL_PUSH_CACHE_LIST_T> &dropCacheListVec);
+            AX_SKEL_PUSH_TRACK_T* TrackFind(AX_SKEL_PUSH_STREAM_T &stStream, AX_U64 nTrackId);
+            AX_VOID TrackLink(AX_SKEL_PUSH_STREAM_T &stStream, AX_SKEL_PUSH_TRACK_T *pTrack, const AX_SKEL_FRAME_T *pstFrame);
+            AX_VOID TrackUnlink(AX_SKEL_PUSH_STREAM_T &stStream, AX_SKEL_PUSH_TRACK_T *pTrack);
+            AX_VOID TrackRelease(AX_SKEL_PUSH_STREAM_T &stStream, AX_SKEL_PUSH_TRACK_T *pTrack);
+            AX_VOID TrackErase(AX_SKEL_PUSH_STREAM_T &stStream, AX_SKEL_PUSH_TRACK_T *pTrack);
+            AX_BOOL TrackDelete(AX_SKEL_PUSH_STREAM_T &stStream, AX_SKEL_PUSH_TRACK_T *pTrack, AX_BOOL bForce = AX_FALSE);
+            AX_VOID FrameRelease(AX_SKEL_PUSH_STREAM_T &stStream, AX_SKEL_PUSH_FRAME_T *pFrame);
+            AX_BOOL PushFliter(const AX_SKEL_PUSH_STREAM_T &stStream, const AX_SKEL_PUSH_TRACK_T *pTrack, const AX_SKEL_OBJECT_ITEM_T &stObjectItem);
 
         protected:
+            // only guards the map, a stream is locked after m_mtxMaps is dropped
             std::mutex m_mtxMaps;
-            std::unordered_map<AX_U32, std::unordered_map<AX_U64, AX_SKEL_PUSH_TRACK_MAPS>> m_TrackMaps;
-            std::unordered_map<AX_U32, std::unordered_map<AX_U64, AX_SKEL_PUSH_FRAME_MAPS>> m_FrameMaps;
-            std::unordered_map<AX_U32, std::vector<AX_SKEL_PUSH_CACHE_LIST_T>> m_CacheListVec;
+            std::unordered_map<AX_U32, PushStreamPtr> m_PushStreams;
+            std::unordered_set<AX_U32> m_ClosedStreams;
 
             std::mutex m_mtxSet;
-            AX_SKEL_PARAM_T m_stParam;
+            ParamPublisher m_Param;
+
+            // the cache lists of the streams, republished when one of them changes
+            std::mutex m_mtxCacheLists;
+            std::unordered_map<AX_U32, PushCacheListPtr> m_mapCacheLists;
+            PushCacheListsPtr m_pCacheLists;
+
+            std::atomic<AX_U32> m_nCachePinned;
+            std::atomic<AX_U32> m_nCacheStreams;     // streams with a frame pinned, the budget is shared by them
+            std::atomic<AX_U64> m_nCacheBytes;
+            std::atomic<AX_U64> m_nBudgetEvicts;
+            AX_U32 m_nBudgetGlobal;
+
+            // the blocks of freed copies kept for reuse by size class, so crops of changing sizes reuse them as
+            // well as the panoramas. copies are freed on the encode workers too
+            std::mutex m_mtxCopy;
+            std::vector<std::vector<AX_VIDEO_FRAME_T>> m_vecCopyFree;   // CMM blocks by size class, u32FrameSize the block size
+            AX_U64 m_nCopyCached;                   // bytes in m_vecCopyFree
+            std::atomic<AX_U64> m_nCopyBytes;
+
+            JencRate m_Rate;
+            WorkerPool m_EncodeWorkers;
+            std::atomic<AX_U64> m_nEncodeDrops;     // pushes not encoded, their batch found the queue full
         };
     }
 }
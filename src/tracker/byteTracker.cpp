@@ -12,6 +12,9 @@
 
 #include "utils/logger.h"
 
+#include <cmath>
+#include <algorithm>
+
 using namespace std;
 using namespace skel::tracker;
 using namespace skel::detection;
@@ -19,40 +22,221 @@ using namespace skel::infer;
 
 bool CBYTETracker::Init(const BYTETrackerConfig& config) {
     m_N_CLASSES = config.n_classes;
-    m_frame_id = 0;
     m_max_time_lost = config.track_buffer;
     m_high_det_thresh = config.high_det_thresh;
     m_new_track_thresh = config.new_track_thresh;
     m_high_match_thresh = config.high_match_thresh;
     m_low_match_thresh = config.low_match_thresh;
     m_unconfirmed_match_thresh = config.unconfirmed_match_thresh;
+    m_fast_motion_thresh = config.fast_motion_thresh;
+    SetMatchMode(config.match_mode, config.match_conflict_ratio);
 
     m_hasInited = true;
 
     return true;
 }
 
-track_map<AX_U32, vector<CTrack*>> CBYTETracker::Update(AX_SKEL_FRAME_T* frame, const vector<Object>& objects) {
+void CBYTETracker::SetMatchMode(AX_U32 match_mode, float conflict_ratio) {
+    m_match_mode = match_mode < TRACK_MATCH_MODE_MAX ? match_mode : (AX_U32)TRACK_MATCH_MODE_LAPJV;
+    m_match_conflict_ratio = min(max(conflict_ratio, 0.f), 1.f);
+}
+
+shared_ptr<BYTETrackerStream> CBYTETracker::GetStream(AX_U32 nStreamId) {
+    lock_guard<mutex> lck(m_streams_mtx);
+
+    auto &stream = m_streams[nStreamId];
+    if (!stream) {
+        stream = make_shared<BYTETrackerStream>();
+    }
+
+    return stream;
+}
+
+float CBYTETracker::ElapsedFrames(BYTETrackerStream& stream, AX_U64 nFrameId) {
+    // user frame ids count every captured frame, so gaps from skipped or dropped frames are kept
+    float dt = 1.f;
+    if (stream.real_frame_id > 0 && nFrameId > stream.real_frame_id) {
+        dt = (float)min(nFrameId - stream.real_frame_id, (AX_U64)max(this->m_max_time_lost, 1U));
+    }
+    stream.real_frame_id = nFrameId;
+
+    return dt;
+}
+
+void CBYTETracker::UpdateMotion(BYTETrackerStream& stream) {
+    bool fast_motion = false;
+    for (auto &it : stream.tracked_tracks_dict) {
+        for (auto &track : it.second) {
+            if (track.state != TrackState::Tracked || track.mean[3] <= 0) {
+                continue;
+            }
+
+            float motion_thresh = this->m_fast_motion_thresh * track.mean[3];
+            if (fabs(track.mean[4]) > motion_thresh || fabs(track.mean[5]) > motion_thresh) {
+                fast_motion = true;
+                break;
+            }
+        }
+
+        if (fast_motion) {
+            break;
+        }
+    }
+
+    stream.fast_motion = fast_motion;
+}
+
+TrackSnapshotPtr CBYTETracker::makeSnapshot(track_map<AX_U32, vector<CTrack*>>& output_tracks_dict) {
+    TrackSnapshotPtr snapshot = m_snapshot_pool.Acquire();
+
+    // class order keeps the output stable
+    for (AX_U32 cls_id = 0; cls_id < this->m_N_CLASSES; ++cls_id) {
+        auto it = output_tracks_dict.find(cls_id);
+        if (it == output_tracks_dict.end()) {
+            continue;
+        }
+
+        for (const CTrack* track : it->second) {
+            TrackSnapshot item;
+            item.track_id = track->track_id;
+            item.real_frame_id = track->real_frame_id;
+            item.class_id = track->class_id;
+            item.state = track->state;
+            item.score = track->score;
+            for (AX_U32 i = 0; i < 4; ++i) {
+                item.tlwh[i] = track->_tlwh[i];
+            }
+            snapshot->push_back(item);
+        }
+    }
+
+    return snapshot;
+}
+
+bool CBYTETracker::NeedDetect(AX_U32 nStreamId) {
+    lock_guard<mutex> lck(m_streams_mtx);
+
+    auto it = m_streams.find(nStreamId);
+    if (it == m_streams.end()) {
+        return true;
+    }
+
+    return it->second->fast_motion;
+}
+
+TrackResultType CBYTETracker::CloseStream(AX_U32 nStreamId) {
+    shared_ptr<BYTETrackerStream> stream;
+    {
+        lock_guard<mutex> lck(m_streams_mtx);
+
+        auto it = m_streams.find(nStreamId);
+        if (it == m_streams.end()) {
+            return m_snapshot_pool.Acquire();
+        }
+
+        stream = it->second;
+        m_streams.erase(it);
+    }
+
+    // wait for the last update of the stream, the state is freed with the last reference
+    lock_guard<mutex> lck(stream->mtx);
+
+    track_map<AX_U32, vector<CTrack*>> output_tracks_dict;
+    for (AX_U32 cls_id = 0; cls_id < this->m_N_CLASSES; ++cls_id) {
+        auto &cls_tracked_tracks_global = stream->tracked_tracks_dict[cls_id];
+        auto &cls_lost_tracks_global = stream->lost_tracks_dict[cls_id];
+        auto &cls_output_tracks_inner = output_tracks_dict[cls_id];
+
+        // only tracks the user has seen need a removed state
+        for (AX_U32 i = 0; i < cls_tracked_tracks_global.size(); ++i) {
+            if (cls_tracked_tracks_global[i].is_activated) {
+                cls_tracked_tracks_global[i].markRemoved();
+                cls_output_tracks_inner.push_back(&cls_tracked_tracks_global[i]);
+            }
+        }
+        for (AX_U32 i = 0; i < cls_lost_tracks_global.size(); ++i) {
+            cls_lost_tracks_global[i].markRemoved();
+            cls_output_tracks_inner.push_back(&cls_lost_tracks_global[i]);
+        }
+    }
+
+    return makeSnapshot(output_tracks_dict);
+}
+
+TrackResultType CBYTETracker::Predict(AX_SKEL_FRAME_T* frame) {
     if (!m_hasInited) {
         ALOGE("CBYTETracker has not inited!\n");
-        return track_map<AX_U32, vector<CTrack*>>{};
+        return m_snapshot_pool.Acquire();
     }
 
-    AX_U32 nStreamId = frame->nStreamId;
     AX_U64 nFrameId = frame->nFrameId;
 
-    // frame id updating
-    this->m_frame_id++;
+    shared_ptr<BYTETrackerStream> stream = GetStream(frame->nStreamId);
+    lock_guard<mutex> lck(stream->mtx);
 
-    auto &this_tracked_tracks_dict = this->m_tracked_tracks_dict[nStreamId];
-    auto &this_lost_tracks_dict = this->m_lost_tracks_dict[nStreamId];
-    auto &this_removed_tracks_dict = this->m_removed_tracks_dict[nStreamId];
+    stream->frame_id++;
+    float dt = ElapsedFrames(*stream, nFrameId);
+
+    track_map<AX_U32, vector<CTrack*>> output_tracks_dict;
+    for (AX_U32 cls_id = 0; cls_id < this->m_N_CLASSES; ++cls_id) {
+        auto &cls_tracked_tracks_global = stream->tracked_tracks_dict[cls_id];
+        auto &cls_lost_tracks_global = stream->lost_tracks_dict[cls_id];
+        auto &cls_output_tracks_inner = output_tracks_dict[cls_id];
 
-    // ---------- Track's track id initialization
-    if (this->m_frame_id == 1) {
-        CTrack::initTrackIDDict(this->m_N_CLASSES);
+        // lost tracks keep moving too, so they can be matched again on the next detected frame
+        vector<CTrack*> cls_track_pool;
+        for (AX_U32 i = 0; i < cls_tracked_tracks_global.size(); ++i) {
+            if (cls_tracked_tracks_global[i].is_activated) {
+                cls_track_pool.push_back(&cls_tracked_tracks_global[i]);
+            }
+        }
+        for (AX_U32 i = 0; i < cls_lost_tracks_global.size(); ++i) {
+            cls_track_pool.push_back(&cls_lost_tracks_global[i]);
+        }
+        CTrack::multiPredict(cls_track_pool, this->m_kalman_filter, dt);
+
+        // state is left untouched, only confirmed tracks are reported so NEW/DIE are never repeated
+        for (AX_U32 i = 0; i < cls_tracked_tracks_global.size(); ++i) {
+            CTrack &track = cls_tracked_tracks_global[i];
+            if (!track.is_activated || track.state != TrackState::Tracked) {
+                continue;
+            }
+
+            track.staticTLWH();
+            track.staticTLBR();
+            track._tlwh.assign(track.tlwh.begin(), track.tlwh.end());
+            track.real_frame_id = nFrameId;
+            cls_output_tracks_inner.push_back(&track);
+        }
+    }
+
+    UpdateMotion(*stream);
+
+    return makeSnapshot(output_tracks_dict);
+}
+
+TrackResultType CBYTETracker::Update(AX_SKEL_FRAME_T* frame, const vector<Object>& objects) {
+    if (!m_hasInited) {
+        ALOGE("CBYTETracker has not inited!\n");
+        return m_snapshot_pool.Acquire();
     }
 
+    AX_U32 nStreamId = frame->nStreamId;
+    AX_U64 nFrameId = frame->nFrameId;
+
+    // streams are independent, only frames of the same stream are serialized
+    shared_ptr<BYTETrackerStream> stream = GetStream(nStreamId);
+    lock_guard<mutex> lck(stream->mtx);
+
+    // frame id updating
+    stream->frame_id++;
+    const AX_U64 frame_id = stream->frame_id;
+    const float dt = ElapsedFrames(*stream, nFrameId);
+
+    auto &this_tracked_tracks_dict = stream->tracked_tracks_dict;
+    auto &this_lost_tracks_dict = stream->lost_tracks_dict;
+    auto &this_removed_tracks_dict = stream->removed_tracks_dict;
+
     // 8 current frame's containers
     track_map<AX_U32, vector<CTrack*>> unconfirmed_tracks_dict;
     track_map<AX_U32, vector<CTrack*>> tracked_tracks_dict;
@@ -150,7 +334,7 @@ track_map<AX_U32, vector<CTrack*>> CBYTETracker::Update(AX_SKEL_FRAME_T* frame,
 
         ////////////////// Step 2: First association, with IoU //////////////////
         cls_track_pool_inner = joinTracks(cls_tracked_tracks_inner, cls_lost_tracks_global);
-        CTrack::multiPredict(cls_track_pool_inner, this->m_kalman_filter);
+        CTrack::multiPredict(cls_track_pool_inner, this->m_kalman_filter, dt);
 
         vector<vector<float>> dists;
         AX_U32 dist_size = 0, dist_size_size = 0;
@@ -167,10 +351,10 @@ track_map<AX_U32, vector<CTrack*>> CBYTETracker::Update(AX_SKEL_FRAME_T* frame,
             //if (track->state == TrackState::New
             //    || track->state == TrackState::Tracked) {
             if (track->state == TrackState::Tracked) {
-                track->update(*det, this->m_frame_id, nFrameId);
+                track->update(*det, frame_id, nFrameId);
                 cls_activated_tracks_inner.push_back(*track);
             } else {
-                track->reActivate(*det, this->m_frame_id, nFrameId, false);
+                track->reActivate(*det, frame_id, nFrameId);
                 cls_refind_tracks_inner.push_back(*track);
             }
         }
@@ -207,10 +391,10 @@ track_map<AX_U32, vector<CTrack*>> CBYTETracker::Update(AX_SKEL_FRAME_T* frame,
             //if (track->state == TrackState::New
             //    || track->state == TrackState::Tracked) {
             if (track->state == TrackState::Tracked) {
-                track->update(*det, this->m_frame_id, nFrameId);
+                track->update(*det, frame_id, nFrameId);
                 cls_activated_tracks_inner.push_back(*track);
             } else {
-                track->reActivate(*det, this->m_frame_id, nFrameId, false);
+                track->reActivate(*det, frame_id, nFrameId);
                 cls_refind_tracks_inner.push_back(*track);
             }
         }
@@ -240,7 +424,7 @@ track_map<AX_U32, vector<CTrack*>> CBYTETracker::Update(AX_SKEL_FRAME_T* frame,
         for (AX_U32 i = 0; i < matches.size(); ++i) {
             CTrack* track = cls_unconfirmed_tracks_inner[matches[i][0]];
             CTrack* det = &cls_dets[matches[i][1]];
-            track->update(*det, this->m_frame_id, nFrameId);
+            track->update(*det, frame_id, nFrameId);
             cls_activated_tracks_inner.push_back(*track);
         }
 
@@ -256,7 +440,7 @@ track_map<AX_U32, vector<CTrack*>> CBYTETracker::Update(AX_SKEL_FRAME_T* frame,
             if (track->score < this->m_new_track_thresh) {
                 continue;
             }
-            track->activate(this->m_kalman_filter, this->m_frame_id, nFrameId);
+            track->activate(this->m_kalman_filter, stream->track_id_count, frame_id, nFrameId);
             cls_activated_tracks_inner.push_back(*track);
         }
 
@@ -264,7 +448,7 @@ track_map<AX_U32, vector<CTrack*>> CBYTETracker::Update(AX_SKEL_FRAME_T* frame,
         // ---------- update lost tracks' state
         for (AX_U32 i = 0; i < cls_lost_tracks_global.size(); ++i) {
             CTrack& track = cls_lost_tracks_global[i];
-            if (this->m_frame_id - track.endFrame() > this->m_max_time_lost) {
+            if (frame_id - track.endFrame() > this->m_max_time_lost) {
                 track.markRemoved();
                 cls_removed_tracks_inner.push_back(track);
             }
@@ -325,5 +509,7 @@ track_map<AX_U32, vector<CTrack*>> CBYTETracker::Update(AX_SKEL_FRAME_T* frame,
         }
     }  // End of class itereations
 
-    return output_tracks_dict;
+    UpdateMotion(*stream);
+
+    return makeSnapshot(output_tracks_dict);
 }
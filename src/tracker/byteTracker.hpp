@@ -13,6 +13,11 @@
 #include "ax_skel_type.h"
 #include "inference/detection.hpp"
 #include "tracker/track.hpp"
+#include "tracker/trackSnapshot.hpp"
+
+#include <mutex>
+#include <atomic>
+#include <memory>
 
 namespace skel {
     namespace tracker {
@@ -23,6 +28,14 @@ namespace skel {
         #define DEFAULT_HIGH_MATCH_THRESH   0.8f
         #define DEFAULT_LOW_MATCH_THRESH    0.5f
         #define DEFAULT_UNCONFIRMED_MATCH_THRESH    0.7f
+        #define DEFAULT_FAST_MOTION_THRESH  0.1f
+        #define DEFAULT_MATCH_CONFLICT_RATIO    0.2f
+
+        enum TrackMatchMode {
+            TRACK_MATCH_MODE_LAPJV = 0,     // optimal assignment
+            TRACK_MATCH_MODE_GREEDY,        // mutual best pairs then lowest cost first
+            TRACK_MATCH_MODE_MAX
+        };
 
         struct BYTETrackerConfig {
             AX_U32 n_classes;
@@ -33,7 +46,11 @@ namespace skel {
             float high_match_thresh;
             float low_match_thresh;
             float unconfirmed_match_thresh;
-
+            // a tracked target moving more than this ratio of its height per frame needs detection
+            float fast_motion_thresh;
+            AX_U32 match_mode;
+            // greedy matching is only trusted while ambiguous rows/cols stay below this ratio
+            float match_conflict_ratio;
 
             BYTETrackerConfig(AX_U32 _n_classes = 1):
                 n_classes(_n_classes),
@@ -43,12 +60,30 @@ namespace skel {
                 new_track_thresh(DEFAULT_NEW_TRACK_THRESH),
                 high_match_thresh(DEFAULT_HIGH_MATCH_THRESH),
                 low_match_thresh(DEFAULT_LOW_MATCH_THRESH),
-                unconfirmed_match_thresh(DEFAULT_UNCONFIRMED_MATCH_THRESH) {
+                unconfirmed_match_thresh(DEFAULT_UNCONFIRMED_MATCH_THRESH),
+                fast_motion_thresh(DEFAULT_FAST_MOTION_THRESH),
+                match_mode(TRACK_MATCH_MODE_LAPJV),
+                match_conflict_ratio(DEFAULT_MATCH_CONFLICT_RATIO) {
 
             }
         };
 
-        typedef track_map<AX_U32, std::vector<CTrack*>>  TrackResultType;
+        // per-frame output, a snapshot stays valid after later updates of the same stream
+        typedef TrackSnapshotPtr  TrackResultType;
+
+        // tracking state of one stream, streams never share tracks, frame counter or track ids
+        struct BYTETrackerStream {
+            std::mutex mtx;
+            AX_U64 frame_id{};
+            AX_U64 track_id_count{};
+            AX_U64 real_frame_id{};     // last frame id given by user, used for kalman dt
+            std::atomic<bool> fast_motion{false};
+
+            // 3 containers of the tracker, indexed by class id
+            track_map<AX_U32, std::vector<CTrack>> tracked_tracks_dict;
+            track_map<AX_U32, std::vector<CTrack>> lost_tracks_dict;
+            track_map<AX_U32, std::vector<CTrack>> removed_tracks_dict;
+        };
 
         class CBYTETracker {
         public:
@@ -58,15 +93,30 @@ namespace skel {
             }
             ~CBYTETracker() = default;
             bool Init(const BYTETrackerConfig& config);
+            // thread safe for different streams, frames of the same stream must be updated in order
             TrackResultType Update(AX_SKEL_FRAME_T* frame, const std::vector<skel::detection::Object>& objects);
+            // kalman prediction only, for frames skipped by detection
+            TrackResultType Predict(AX_SKEL_FRAME_T* frame);
+            // whether the stream has fast moving targets which prediction can not follow
+            bool NeedDetect(AX_U32 nStreamId);
+            // drop all state of the stream, tracks still alive are reported as removed
+            TrackResultType CloseStream(AX_U32 nStreamId);
+            // may be changed while tracking, takes effect from the next association
+            void SetMatchMode(AX_U32 match_mode, float conflict_ratio);
 
         private:
+            std::shared_ptr<BYTETrackerStream> GetStream(AX_U32 nStreamId);
+            float ElapsedFrames(BYTETrackerStream& stream, AX_U64 nFrameId);
+            void UpdateMotion(BYTETrackerStream& stream);
+            TrackResultType makeSnapshot(track_map<AX_U32, std::vector<CTrack*>>& output_tracks_dict);
+
             std::vector<CTrack*> joinTracks(std::vector<CTrack*>& tlista, std::vector<CTrack>& tlistb);
             std::vector<CTrack> joinTracks(std::vector<CTrack>& tlista, std::vector<CTrack>& tlistb);
             std::vector<CTrack> subTracks(std::vector<CTrack>& tlista, std::vector<CTrack>& tlistb);
             void removeDuplicateTracks(std::vector<CTrack>& resa, std::vector<CTrack>& resb, std::vector<CTrack>& tracks_a, std::vector<CTrack>& tracks_b);
             void linearAssignment(std::vector<std::vector<float>>& cost_matrix, AX_U32 cost_matrix_size, AX_U32 cost_matrix_size_size, float thresh,
                                   std::vector<std::vector<AX_S32>>& matches, std::vector<AX_S32>& unmatched_a, std::vector<AX_S32>& unmatched_b);
+            bool greedyAssignment(const std::vector<std::vector<float>>& cost, float thresh, std::vector<AX_S32>& rowsol, std::vector<AX_S32>& colsol);
             std::vector<std::vector<float>> iouDistance(std::vector<CTrack*>& atracks, std::vector<CTrack>& btracks, AX_U32& dist_size, AX_U32& dist_size_size);
             std::vector<std::vector<float>> iouDistance(std::vector<CTrack>& atracks, std::vector<CTrack>& btracks);
             std::vector<std::vector<float>> ious(std::vector<std::vector<float>>& atlbrs, std::vector<std::vector<float>>& btlbrs);
@@ -80,16 +130,19 @@ namespace skel {
             float m_high_match_thresh{};
             float m_low_match_thresh{};
             float m_unconfirmed_match_thresh{};
-            AX_U64 m_frame_id{};
+            float m_fast_motion_thresh{};
+            std::atomic<AX_U32> m_match_mode{TRACK_MATCH_MODE_LAPJV};
+            std::atomic<float> m_match_conflict_ratio{DEFAULT_MATCH_CONFLICT_RATIO};
             AX_U32 m_max_time_lost{};
 
             // tracking object class number
             AX_U32 m_N_CLASSES{};
 
-            // 3 containers of the tracker
-            track_map<AX_U32, track_map<AX_U32, std::vector<CTrack>>> m_tracked_tracks_dict;
-            track_map<AX_U32, track_map<AX_U32, std::vector<CTrack>>> m_lost_tracks_dict;
-            track_map<AX_U32, track_map<AX_U32, std::vector<CTrack>>> m_removed_tracks_dict;
+            // per stream tracking state, the map lock is only held for lookup
+            std::mutex m_streams_mtx;
+            track_map<AX_U32, std::shared_ptr<BYTETrackerStream>> m_streams;
+
+            CTrackSnapshotPool m_snapshot_pool;
 
             KalmanFilter m_kalman_filter;
         };
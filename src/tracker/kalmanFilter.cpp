@@ -59,7 +59,7 @@ KAL_DATA KalmanFilter::initiate(const DETECT_BOX& measurement) {  // xyah
     return std::make_pair(mean, var);
 }
 
-void KalmanFilter::predict(KAL_MEAN& mean, KAL_COVA& covariance) {
+void KalmanFilter::predict(KAL_MEAN& mean, KAL_COVA& covariance, float dt) {
     // revise the data;
     DETECT_BOX std_pos;
     std_pos << _std_weight_position * mean(3), _std_weight_position * mean(3), 1e-2, _std_weight_position * mean(3);
@@ -70,8 +70,26 @@ void KalmanFilter::predict(KAL_MEAN& mean, KAL_COVA& covariance) {
     tmp.block<1, 4>(0, 4) = std_vel;
     tmp = tmp.array().square();
     KAL_COVA motion_cov = tmp.asDiagonal();
-    KAL_MEAN mean1 = this->_motion_mat * mean.transpose();
-    KAL_COVA covariance1 = this->_motion_mat * covariance * (_motion_mat.transpose());
+
+    if (dt == 1.f) {
+        KAL_MEAN mean1 = this->_motion_mat * mean.transpose();
+        KAL_COVA covariance1 = this->_motion_mat * covariance * (_motion_mat.transpose());
+        covariance1 += motion_cov;
+
+        mean = mean1;
+        covariance = covariance1;
+        return;
+    }
+
+    // constant velocity over dt frames, process noise grows linearly with the elapsed time
+    Eigen::Matrix<float, 8, 8, Eigen::RowMajor> motion_mat = this->_motion_mat;
+    for (AX_U32 i = 0; i < 4; i++) {
+        motion_mat(i, 4 + i) = dt;
+    }
+    motion_cov *= dt;
+
+    KAL_MEAN mean1 = motion_mat * mean.transpose();
+    KAL_COVA covariance1 = motion_mat * covariance * (motion_mat.transpose());
     covariance1 += motion_cov;
 
     mean = mean1;
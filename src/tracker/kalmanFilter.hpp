@@ -20,7 +20,8 @@ namespace skel {
 
             KalmanFilter();
             KAL_DATA initiate(const DETECT_BOX& measurement);
-            void predict(KAL_MEAN& mean, KAL_COVA& covariance);
+            // dt: elapsed time in frames since the last prediction of this track
+            void predict(KAL_MEAN& mean, KAL_COVA& covariance, float dt = 1.f);
             KAL_HDATA project(const KAL_MEAN& mean, const KAL_COVA& covariance, float score = .0f);  // NSA kalman filter
             KAL_DATA update(const KAL_MEAN& mean, const KAL_COVA& covariance, const DETECT_BOX& measurement,
                             float score = .0f);  // NSA kalman filter //
@@ -13,9 +13,6 @@
 using namespace std;
 using namespace skel::detection;
 
-//unordered_map<AX_U32, AX_U64> CTrack::static_track_id_dict;
-AX_U64 skel::tracker::CTrack::static_track_id_dict = 0;
-
 skel::tracker::CTrack::CTrack(const vector<float>& tlwh_,
                 const float& score,
                 const AX_U32& cls_id,
@@ -48,19 +45,9 @@ skel::tracker::CTrack::CTrack(const vector<float>& tlwh_,
 skel::tracker::CTrack::~CTrack() {
 }
 
-void skel::tracker::CTrack::initTrackIDDict(const AX_U32 n_classes) {
-#if 0
-    for (AX_U32 i = 0; i < n_classes; ++i) {
-        CTrack::static_track_id_dict[i] = 0;
-    }
-#else
-    static_track_id_dict = 0;
-#endif
-}
-
-void skel::tracker::CTrack::activate(KalmanFilter& kalman_filter, AX_U64 frame_id, AX_U64 real_frame_id) {
+void skel::tracker::CTrack::activate(KalmanFilter& kalman_filter, AX_U64& track_id_count, AX_U64 frame_id, AX_U64 real_frame_id) {
     this->kalman_filter = kalman_filter;  // send the shared kalman filter
-    this->track_id = CTrack::nextID(this->class_id);
+    this->track_id = CTrack::nextID(track_id_count);
 
     vector<float> _tlwh_tmp(4);
     _tlwh_tmp[0] = this->_tlwh[0];
@@ -99,7 +86,7 @@ void skel::tracker::CTrack::activate(KalmanFilter& kalman_filter, AX_U64 frame_i
     this->start_frame = frame_id;
 }
 
-void skel::tracker::CTrack::reActivate(CTrack& new_track, AX_U64 frame_id, AX_U64 real_frame_id, bool new_id) {
+void skel::tracker::CTrack::reActivate(CTrack& new_track, AX_U64 frame_id, AX_U64 real_frame_id, AX_U64* track_id_count) {
     vector<float> xyah = tlwhToxyah(new_track.tlwh);
 
     DETECT_BOX xyah_box;
@@ -127,10 +114,10 @@ void skel::tracker::CTrack::reActivate(CTrack& new_track, AX_U64 frame_id, AX_U6
     this->state = TrackState::Tracked;
     this->is_activated = true;  // set to be activated
 
-    if (new_id) {
+    if (track_id_count) {
         // FIXME.
         this->state = TrackState::New;
-        this->track_id = CTrack::nextID(this->class_id);
+        this->track_id = CTrack::nextID(*track_id_count);
     }
 }
 
@@ -217,24 +204,20 @@ void skel::tracker::CTrack::markRemoved() {
     state = TrackState::Removed;
 }
 
-AX_U64 skel::tracker::CTrack::nextID(const AX_U32& cls_id) {
-#if 0
-    CTrack::static_track_id_dict[cls_id] += 1;
-    return CTrack::static_track_id_dict[cls_id];
-#else
-    return (++ static_track_id_dict);
-#endif
+// track id counter is owned by the caller (one per stream), no global state here
+AX_U64 skel::tracker::CTrack::nextID(AX_U64& track_id_count) {
+    return (++ track_id_count);
 }
 
 AX_U64 skel::tracker::CTrack::endFrame() {
     return this->frame_id;
 }
 
-void skel::tracker::CTrack::multiPredict(vector<CTrack*>& tracks, KalmanFilter& kalman_filter) {
+void skel::tracker::CTrack::multiPredict(vector<CTrack*>& tracks, KalmanFilter& kalman_filter, float dt) {
     for (AX_U32 i = 0; i < tracks.size(); ++i) {
         if (tracks[i]->state != TrackState::Tracked) {
             tracks[i]->mean[7] = 0;
         }
-        kalman_filter.predict(tracks[i]->mean, tracks[i]->covariance);
+        kalman_filter.predict(tracks[i]->mean, tracks[i]->covariance, dt);
     }
 }
@@ -32,19 +32,17 @@ namespace skel {
             ~CTrack();
 
             std::vector<float> static tlbrTotlwh(std::vector<float>& tlbr);
-            void static multiPredict(std::vector<CTrack*>& tracks, KalmanFilter& kalman_filter);
+            void static multiPredict(std::vector<CTrack*>& tracks, KalmanFilter& kalman_filter, float dt = 1.f);
             void staticTLWH();
             void staticTLBR();
             std::vector<float> tlwhToxyah(std::vector<float> tlwh_tmp);
             std::vector<float> toXYAH();
             void markLost();
             void markRemoved();
-            static void initTrackIDDict(const AX_U32 n_classes);
-            static AX_U64 nextID(const AX_U32& cls_id);
-            // static void printIDDict();
+            static AX_U64 nextID(AX_U64& track_id_count);
             AX_U64 endFrame();
-            void activate(KalmanFilter& kalman_filter, AX_U64 frame_id, AX_U64 real_frame_id);
-            void reActivate(CTrack& new_track, AX_U64 frame_id, AX_U64 real_frame_id, bool new_id = false);
+            void activate(KalmanFilter& kalman_filter, AX_U64& track_id_count, AX_U64 frame_id, AX_U64 real_frame_id);
+            void reActivate(CTrack& new_track, AX_U64 frame_id, AX_U64 real_frame_id, AX_U64* track_id_count = nullptr);
             void update(CTrack& new_track, AX_U64 frame_id, AX_U64 real_frame_id);
 
         public:
@@ -67,10 +65,6 @@ namespace skel {
             AX_U64 real_frame_id{}; // real frame id
             skel::detection::Object object{}; // object data (valid for NEW and UPDATE status)
 
-            // mapping each class id to the track id count of this class
-            //static track_map<AX_U32, AX_U64> static_track_id_dict;
-            static AX_U64 static_track_id_dict;
-
         private:
             KalmanFilter kalman_filter;
         };
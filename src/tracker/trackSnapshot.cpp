@@ -0,0 +1,57 @@
+/**************************************************************************************************
+ *
+ * Copyright (c) 2019-2023 Axera Semiconductor (Shanghai) Co., Ltd. All Rights Reserved.
+ *
+ * This source file is the property of Axera Semiconductor (Shanghai) Co., Ltd. and
+ * may not be copied or distributed in any isomorphic form without the prior
+ * written consent of Axera Semiconductor (Shanghai) Co., Ltd.
+ *
+ **************************************************************************************************/
+
+#include "tracker/trackSnapshot.hpp"
+
+using namespace std;
+using namespace skel::tracker;
+
+CTrackSnapshotPool::Store::~Store() {
+    for (auto p : free_list) {
+        delete p;
+    }
+    free_list.clear();
+}
+
+CTrackSnapshotPool::CTrackSnapshotPool(AX_U32 max_free):
+    m_store(make_shared<Store>()) {
+    m_store->max_free = max_free;
+}
+
+TrackSnapshotPtr CTrackSnapshotPool::Acquire() {
+    TrackSnapshotBuffer* buffer = nullptr;
+    {
+        lock_guard<mutex> lck(m_store->mtx);
+        if (!m_store->free_list.empty()) {
+            buffer = m_store->free_list.back();
+            m_store->free_list.pop_back();
+        }
+    }
+
+    if (!buffer) {
+        buffer = new TrackSnapshotBuffer();
+    }
+
+    weak_ptr<Store> store = m_store;
+    return TrackSnapshotPtr(buffer, [store](TrackSnapshotBuffer* p) {
+        auto s = store.lock();
+        if (s) {
+            p->clear();
+
+            lock_guard<mutex> lck(s->mtx);
+            if (s->free_list.size() < s->max_free) {
+                s->free_list.push_back(p);
+                return;
+            }
+        }
+
+        delete p;
+    });
+}
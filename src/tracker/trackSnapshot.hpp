@@ -0,0 +1,58 @@
+/**************************************************************************************************
+ *
+ * Copyright (c) 2019-2023 Axera Semiconductor (Shanghai) Co., Ltd. All Rights Reserved.
+ *
+ * This source file is the property of Axera Semiconductor (Shanghai) Co., Ltd. and
+ * may not be copied or distributed in any isomorphic form without the prior
+ * written consent of Axera Semiconductor (Shanghai) Co., Ltd.
+ *
+ **************************************************************************************************/
+
+#pragma once
+
+#include <mutex>
+#include <memory>
+#include <vector>
+#include "ax_global_type.h"
+
+namespace skel {
+    namespace tracker {
+        #define DEFAULT_SNAPSHOT_POOL_SIZE  64
+
+        // self-contained copy of one output track, never refers to tracker internal state
+        struct TrackSnapshot {
+            AX_U64 track_id;
+            AX_U64 real_frame_id;
+            AX_U32 class_id;
+            AX_U32 state;       // TrackState
+            float score;
+            float tlwh[4];      // x1y1wh
+        };
+
+        typedef std::vector<TrackSnapshot> TrackSnapshotBuffer;
+
+        // buffers go back to the pool when the last reference is dropped
+        typedef std::shared_ptr<TrackSnapshotBuffer> TrackSnapshotPtr;
+
+        class CTrackSnapshotPool {
+        public:
+            explicit CTrackSnapshotPool(AX_U32 max_free = DEFAULT_SNAPSHOT_POOL_SIZE);
+            ~CTrackSnapshotPool() = default;
+
+            // empty buffer, capacity of the recycled one is kept
+            TrackSnapshotPtr Acquire();
+
+        private:
+            struct Store {
+                std::mutex mtx;
+                AX_U32 max_free;
+                std::vector<TrackSnapshotBuffer*> free_list;
+
+                ~Store();
+            };
+
+            // shared with the deleters, so buffers still in flight can outlive the pool
+            std::shared_ptr<Store> m_store;
+        };
+    }
+}
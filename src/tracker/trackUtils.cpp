@@ -12,6 +12,7 @@
 #include "tracker/lapjv.hpp"
 
 #include <map>
+#include <algorithm>
 
 using namespace std;
 using namespace skel::tracker;
@@ -124,8 +125,11 @@ void CBYTETracker::linearAssignment(vector<vector<float>>& cost_matrix, AX_U32 c
 
     vector<AX_S32> rowsol;
     vector<AX_S32> colsol;
-    //float c = (float)lapjv(cost_matrix, rowsol, colsol, true, thresh);
-    lapjv(cost_matrix, rowsol, colsol, true, thresh);
+    if (m_match_mode != TRACK_MATCH_MODE_GREEDY
+        || !greedyAssignment(cost_matrix, thresh, rowsol, colsol)) {
+        //float c = (float)lapjv(cost_matrix, rowsol, colsol, true, thresh);
+        lapjv(cost_matrix, rowsol, colsol, true, thresh);
+    }
     for (AX_U32 i = 0; i < rowsol.size(); i++) {
         if (rowsol[i] >= 0) {
             vector<AX_S32> match;
@@ -144,6 +148,96 @@ void CBYTETracker::linearAssignment(vector<vector<float>>& cost_matrix, AX_U32 c
     }
 }
 
+namespace {
+    struct MatchCandidate {
+        float cost;
+        AX_S32 row;
+        AX_S32 col;
+    };
+
+    // min-heap on cost
+    inline bool matchCandidateGreater(const MatchCandidate& a, const MatchCandidate& b) {
+        return a.cost > b.cost;
+    }
+}
+
+bool CBYTETracker::greedyAssignment(const vector<vector<float>>& cost, float thresh, vector<AX_S32>& rowsol, vector<AX_S32>& colsol) {
+    AX_U32 n_rows = (AX_U32)cost.size();
+    AX_U32 n_cols = (AX_U32)cost[0].size();
+
+    // pairs lapjv would never take are dropped first, so the heap only holds gated candidates
+    vector<MatchCandidate> candidates;
+    vector<AX_S32> row_best(n_rows, -1), col_best(n_cols, -1);
+    vector<AX_U32> row_cands(n_rows, 0), col_cands(n_cols, 0);
+    for (AX_U32 i = 0; i < n_rows; i++) {
+        for (AX_U32 j = 0; j < n_cols; j++) {
+            float c = cost[i][j];
+            if (c >= thresh) {
+                continue;
+            }
+
+            candidates.push_back({c, (AX_S32)i, (AX_S32)j});
+            row_cands[i]++;
+            col_cands[j]++;
+            if (row_best[i] < 0 || c < cost[i][row_best[i]]) {
+                row_best[i] = j;
+            }
+            if (col_best[j] < 0 || c < cost[col_best[j]][j]) {
+                col_best[j] = i;
+            }
+        }
+    }
+
+    // too many competing candidates, greedy may differ from the optimal assignment
+    AX_U32 n_gated = 0, n_conflicts = 0;
+    for (AX_U32 i = 0; i < n_rows; i++) {
+        n_gated += row_cands[i] > 0 ? 1 : 0;
+        n_conflicts += row_cands[i] > 1 ? 1 : 0;
+    }
+    for (AX_U32 j = 0; j < n_cols; j++) {
+        n_gated += col_cands[j] > 0 ? 1 : 0;
+        n_conflicts += col_cands[j] > 1 ? 1 : 0;
+    }
+    if (n_conflicts > m_match_conflict_ratio * n_gated) {
+        return false;
+    }
+
+    rowsol.assign(n_rows, -1);
+    colsol.assign(n_cols, -1);
+
+    // mutual best pairs are taken by any assignment that is optimal locally
+    AX_U32 n_unresolved = n_rows;
+    for (AX_U32 i = 0; i < n_rows; i++) {
+        AX_S32 j = row_best[i];
+        if (j < 0) {
+            n_unresolved--;
+        }
+        else if (col_best[j] == (AX_S32)i) {
+            rowsol[i] = j;
+            colsol[j] = i;
+            n_unresolved--;
+        }
+    }
+
+    // the rest, lowest cost first
+    if (n_unresolved > 0) {
+        make_heap(candidates.begin(), candidates.end(), matchCandidateGreater);
+        while (!candidates.empty() && n_unresolved > 0) {
+            pop_heap(candidates.begin(), candidates.end(), matchCandidateGreater);
+            MatchCandidate cand = candidates.back();
+            candidates.pop_back();
+
+            if (rowsol[cand.row] < 0 && colsol[cand.col] < 0) {
+                rowsol[cand.row] = cand.col;
+                colsol[cand.col] = cand.row;
+                n_unresolved--;
+            }
+        }
+    }
+
+    return true;
+}
+
 vector<vector<float>> CBYTETracker::ious(vector<vector<float>>& atlbrs, vector<vector<float>>& btlbrs) {
     vector<vector<float>> ious;
     if (atlbrs.size() * btlbrs.size() == 0) return ious;
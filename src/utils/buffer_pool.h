@@ -0,0 +1,96 @@
+/**************************************************************************************************
+ *
+ * Copyright (c) 2019-2023 Axera Semiconductor (Ningbo) Co., Ltd. All Rights Reserved.
+ *
+ * This source file is the property of Axera Semiconductor (Ningbo) Co., Ltd. and
+ * may not be copied or distributed in any isomorphic form without the prior
+ * written consent of Axera Semiconductor (Ningbo) Co., Ltd.
+ *
+ **************************************************************************************************/
+
+#ifndef SKEL_BUFFER_POOL_H
+#define SKEL_BUFFER_POOL_H
+
+#include <atomic>
+
+#include "api/ax_skel_def.h"
+#include "utils/size_class_pool.h"
+
+namespace skel {
+    namespace utils {
+        // Size classed pool of reference counted byte buffers. Alloc hands out the payload of a buffer
+        // holding one reference, Ref adds one and the last Rel gives the buffer back to the free list of
+        // its class. Classes double from nMinSize, at most nClassCache free buffers are kept per class
+        // and sizes beyond the last class come from the heap. Thread safe.
+        class BufferPool {
+        public:
+            explicit BufferPool(AX_U32 nMinSize = 4096, AX_U32 nClassNum = 12, AX_U32 nClassCache = 16) :
+                    m_Blocks(nMinSize, nClassNum, nClassCache) {
+
+            }
+
+            // buffers still referenced are leaked
+            ~BufferPool() = default;
+
+            // un-copyable or moveable
+            BufferPool(const BufferPool&) = delete;
+            BufferPool& operator = (const BufferPool&) = delete;
+
+            AX_U8* Alloc(AX_U32 nSize) {
+                Blocks::Block *pBlock = m_Blocks.Get(nSize);
+                if (!pBlock) {
+                    return nullptr;
+                }
+
+                pBlock->stExt.nRef = 1;
+                m_nUsed ++;
+
+                return Blocks::Payload(pBlock);
+            }
+
+            AX_VOID Ref(AX_VOID *p) {
+                if (p) {
+                    Blocks::Of(p)->stExt.nRef ++;
+                }
+            }
+
+            // AX_TRUE if it was the last reference
+            AX_BOOL Rel(AX_VOID *p) {
+                if (!p) {
+                    return AX_FALSE;
+                }
+
+                Blocks::Block *pBlock = Blocks::Of(p);
+                if (pBlock->stExt.nRef.fetch_sub(1) != 1) {
+                    return AX_FALSE;
+                }
+
+                m_nUsed --;
+                m_Blocks.Put(pBlock);
+
+                return AX_TRUE;
+            }
+
+            inline AX_U32 Used() const {
+                return m_nUsed;
+            }
+
+            AX_U32 Cached() {
+                return m_Blocks.Cached();
+            }
+
+        private:
+            struct Ext {
+                std::atomic<AX_U32> nRef;
+            };
+
+            using Blocks = SizeClassPool<Ext>;
+
+        private:
+            Blocks m_Blocks;
+            std::atomic<AX_U32> m_nUsed{0};
+        };
+    }
+}
+
+#endif //SKEL_BUFFER_POOL_H
@@ -62,6 +62,17 @@ namespace skel {
             }
         }
 
+        static inline bool ParseConfig(const AX_SKEL_CONFIG_ITEM_T& stConfigItem, const char* key, AX_U32& value) {
+            if (strcmp(stConfigItem.pstrType, key) == 0 &&
+                stConfigItem.nValueSize == sizeof(AX_SKEL_COMMON_THRESHOLD_CONFIG_T)) {
+                auto* pstValue = (AX_SKEL_COMMON_THRESHOLD_CONFIG_T*)stConfigItem.pstrValue;
+                value = (pstValue->fValue > 0) ? (AX_U32)pstValue->fValue : 0;
+                return true;
+            } else {
+                return false;
+            }
+        }
+
         static inline bool ParseConfig(const AX_SKEL_CONFIG_ITEM_T& stConfigItem, const char* key, std::vector<std::string>& value) {
             if (strcmp(stConfigItem.pstrType, key) == 0 &&
                 stConfigItem.nValueSize == sizeof(AX_SKEL_TARGET_CONFIG_T)) {
@@ -102,7 +113,7 @@ namespace skel {
             return -1;
         }
 
-        void MakeConfig(AX_SKEL_CONFIG_T *pstConfig, const char* key, bool value) {
+        void MakeConfig(AX_SKEL_CONFIG_T *pstConfig, const char* key, float value) {
             bool bNewItem = true;
             AX_SKEL_CONFIG_ITEM_T *pstNewItem;
             if (!pstConfig->pstItems) {
@@ -136,10 +147,14 @@ namespace skel {
                 pstValue = (AX_SKEL_COMMON_THRESHOLD_CONFIG_T*)pstNewItem->pstrValue;
             }
 
-            pstValue->fValue = value ? 1 : 0;
+            pstValue->fValue = value;
             pstNewItem->pstrValue = (void*)pstValue;
         }
 
+        void MakeConfig(AX_SKEL_CONFIG_T *pstConfig, const char* key, bool value) {
+            MakeConfig(pstConfig, key, value ? 1.0f : 0.0f);
+        }
+
         void FreeConfig(AX_SKEL_CONFIG_T *pstConfig) {
             if (!pstConfig)
                 return;
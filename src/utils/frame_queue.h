@@ -23,7 +23,7 @@ namespace skel {
             ~FrameQueue() {
                 while (!m_queue.empty()) {
                     AX_SKEL_FRAME_T* frame = m_queue.front();
-                    m_queue.pop();
+                    m_queue.pop_front();
                     if (frame) {
 //                        FreeFrame(frame->stFrame);
                         free(frame);
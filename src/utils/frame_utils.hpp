@@ -163,16 +163,9 @@ namespace skel {
             return t;
         }
 
-        static inline int CropResizeFrame(const AX_VIDEO_FRAME_T& src, AX_VIDEO_FRAME_T& dst, int nWidth, int nHeight, const skel::infer::Rect& crop_rect)
+        // dst is allocated by the caller, crop_rect of zero area for the whole src
+        static inline int CropResizeFrameTo(const AX_VIDEO_FRAME_T& src, AX_VIDEO_FRAME_T& dst, const skel::infer::Rect& crop_rect)
         {
-            int ret = 0;
-            ret = AllocFrame(dst, "crop_resize", nWidth, nHeight, src.enImgFormat);
-            if (ret != 0)
-            {
-                ALOGE("Alloc crop_resize frame failed!\n");
-                return ret;
-            }
-
             AX_IVPS_ASPECT_RATIO_T tAspectRatio;
 
             memset(&tAspectRatio, 0x00, sizeof(tAspectRatio));
@@ -198,10 +191,9 @@ namespace skel {
                 tAspectRatio.tRect.nH = cropSrc.u32Height;
             }
 
-            ret = AX_IVPS_CropResizeTdp(&cropSrc, &dst, &tAspectRatio);
+            int ret = AX_IVPS_CropResizeTdp(&cropSrc, &dst, &tAspectRatio);
             if (ret != 0)
             {
-                FreeFrame(dst);
                 fprintf(stderr, "AX_IVPS_CropResizeTdp error, ret=0x%8x\n", ret);
                 return ret;
             }
@@ -209,6 +201,26 @@ namespace skel {
             return ret;
         }
 
+        static inline int CropResizeFrame(const AX_VIDEO_FRAME_T& src, AX_VIDEO_FRAME_T& dst, int nWidth, int nHeight, const skel::infer::Rect& crop_rect)
+        {
+            int ret = 0;
+            ret = AllocFrame(dst, "crop_resize", nWidth, nHeight, src.enImgFormat);
+            if (ret != 0)
+            {
+                ALOGE("Alloc crop_resize frame failed!\n");
+                return ret;
+            }
+
+            ret = CropResizeFrameTo(src, dst, crop_rect);
+            if (ret != 0)
+            {
+                FreeFrame(dst);
+                return ret;
+            }
+
+            return ret;
+        }
+
         static inline void IncFrameRefCnt(AX_SKEL_FRAME_T& frame)
         {
             utils::inc_io_ref_cnt(frame.stFrame);
@@ -9,270 +9,254 @@
  **************************************************************************************************/
 
 #include <string.h>
-#include <dirent.h>
-#include <errno.h>
-#include <sys/types.h>
-#include <unistd.h>
+#include <strings.h>
 
 #include "utils/jenc.h"
 #include "utils/logger.h"
+#include "ax_sys_api.h"
 
-AX_S32 CreateJenc(VENC_CHN nJencChn, AX_U32 nWidth, AX_U32 nHeight, AX_U32 nQpLevel) {
-    AX_VENC_CHN_ATTR_T stVencChnAttr;
-    memset(&stVencChnAttr, 0, sizeof(AX_VENC_CHN_ATTR_T));
+// the cpu backend reads the planes through the virtual address, a frame given by its pool block only is
+// mapped here so that the backend makes no BSP call
+static const AX_VIDEO_FRAME_T& MapFrame(const AX_VIDEO_FRAME_T &stFrame, AX_VIDEO_FRAME_T &stMapped) {
+    if (stFrame.u64VirAddr[0] || stFrame.u32BlkId[0] == 0) {
+        return stFrame;
+    }
 
-    stVencChnAttr.stVencAttr.enMemSource = AX_MEMORY_SOURCE_CMM;
+    stMapped = stFrame;
+    stMapped.u64VirAddr[0] = (AX_U64)(uintptr_t)AX_POOL_GetBlockVirAddr(stFrame.u32BlkId[0]);
+    // the uv plane follows the y plane
+    stMapped.u64VirAddr[1] = 0;
 
-    stVencChnAttr.stVencAttr.u32MaxPicWidth = MAX_JENC_PIC_WIDTH;
-    stVencChnAttr.stVencAttr.u32MaxPicHeight = MAX_JENC_PIC_HEIGHT;
+    return stMapped;
+}
 
-    stVencChnAttr.stVencAttr.u32PicWidthSrc = nWidth;
-    stVencChnAttr.stVencAttr.u32PicHeightSrc = nHeight;
+namespace skel {
+    namespace utils {
+        CJEnc::CJEnc(AX_VOID) {
+        }
 
-    stVencChnAttr.stVencAttr.u32BufSize = nWidth * nHeight * 3 / 4; /*stream buffer size*/
+        AX_S32 CJEnc::Create(AX_U32 nWidth, AX_U32 nHeight) {
+            std::lock_guard<std::mutex> lck(m_mtx);
 
-    stVencChnAttr.stVencAttr.u8InFifoDepth = 1;  /* depth of input fifo */
-    stVencChnAttr.stVencAttr.u8OutFifoDepth = 1; /* depth of output fifo */
+            if (m_bPushValid) {
+                if (m_bVencOpened && nWidth * nHeight > m_nWidth * m_nHeight) {
+                    ALOGW("SKEL jenc created for (%dx%d), larger frames (%dx%d) will %s",
+                          m_nWidth, m_nHeight, nWidth, nHeight,
+                          (m_eBackend == SKEL_JENC_BACKEND_VENC) ? "not be encoded" : "be encoded on the cpu");
+                }
 
-    stVencChnAttr.stVencAttr.enLinkMode = AX_VENC_UNLINK_MODE;
+                m_nRefCount ++;
 
-    stVencChnAttr.stVencAttr.enType = PT_JPEG;
+                return AX_SKEL_SUCC;
+            }
 
-    auto nRet = AX_VENC_CreateChn(nJencChn, &stVencChnAttr);
+            m_eBackend = SKEL_JENC_BACKEND_AUTO;
+            const char *strSkelBackendEnvStr = getenv(SKEL_JENC_BACKEND_ENV_STR);
+            if (strSkelBackendEnvStr) {
+                if (strcasecmp(strSkelBackendEnvStr, "venc") == 0) {
+                    m_eBackend = SKEL_JENC_BACKEND_VENC;
+                }
+                else if (strcasecmp(strSkelBackendEnvStr, "cpu") == 0) {
+                    m_eBackend = SKEL_JENC_BACKEND_CPU;
+                }
+            }
 
-    if (nRet != 0) {
-        ALOGE("SKEL AX_VENC_CreateChn[%d](%d X %d, size=%d) fail, ret=0x%x", nJencChn, nWidth, nHeight, stVencChnAttr.stVencAttr.u32BufSize, nRet);
-        return -1;
-    }
+            if (!m_pVenc) {
+                m_pVenc.reset(new VencJenc(m_BufPool));
+            }
 
-    AX_VENC_JPEG_PARAM_T stJpegParam;
-    memset(&stJpegParam, 0, sizeof(AX_VENC_JPEG_PARAM_T));
-    nRet = AX_VENC_GetJpegParam(nJencChn, &stJpegParam);
-    if (nRet != 0) {
-        ALOGE("SKEL AX_VENC_GetJpegParam[%d] fail", nJencChn, nRet);
-        return AX_ERR_SKEL_ILLEGAL_PARAM;
-    }
+            if (!m_pCpu) {
+                m_pCpu.reset(new CpuJenc(m_BufPool));
+            }
 
-    stJpegParam.u32Qfactor = nQpLevel;
+            m_bVencOpened = AX_FALSE;
+            if (m_eBackend != SKEL_JENC_BACKEND_CPU) {
+                AX_S32 nRet = m_pVenc->Open(nWidth, nHeight);
 
-    nRet = AX_VENC_SetJpegParam(nJencChn, &stJpegParam);
-    if (nRet != 0){
-        ALOGE("AX_VENC_SetJpegParam[%d] fail", nJencChn, nRet);
-        return AX_ERR_SKEL_ILLEGAL_PARAM;
-    }
+                if (nRet != AX_SKEL_SUCC) {
+                    if (m_eBackend == SKEL_JENC_BACKEND_VENC) {
+                        return nRet;
+                    }
 
-    AX_VENC_RECV_PIC_PARAM_T tRecvParam;
-    memset(&tRecvParam, 0x00, sizeof(tRecvParam));
-    nRet = AX_VENC_StartRecvFrame(nJencChn, &tRecvParam);
+                    // no VENC channel to be had (taken, or no VENC at all), everything goes to the cpu
+                    ALOGW("SKEL jenc venc unavailable, ret=0x%x, encoding on the cpu", nRet);
+                }
+                else {
+                    m_bVencOpened = AX_TRUE;
+                }
+            }
 
-    if (nRet != 0) {
-        ALOGE("SKEL AX_VENC_StartRecvFrame[%d] fail, nRet=0x%x", nJencChn, nRet);
-        return AX_ERR_SKEL_ILLEGAL_PARAM;
-    }
+            m_pCpu->Open(nWidth, nHeight);
 
-    return AX_SKEL_SUCC;
-}
+            m_nWidth = nWidth;
+            m_nHeight = nHeight;
+            m_nRefCount = 1;
+            m_bPushValid = AX_TRUE;
 
-namespace skel {
-    namespace utils {
-        CJEnc::CJEnc(AX_VOID) {
+            return AX_SKEL_SUCC;
         }
 
-        AX_S32 CJEnc::Create(AX_U32 nWidth, AX_U32 nHeight) {
-            if (!m_bPushValid) {
-                AX_VENC_MOD_ATTR_T stVencModAttr;
-                memset(&stVencModAttr, 0x00, sizeof(stVencModAttr));
-                stVencModAttr.enVencType = AX_VENC_MULTI_ENCODER;
-                stVencModAttr.stModThdAttr.u32TotalThreadNum = 1;
-                stVencModAttr.stModThdAttr.bExplicitSched = AX_FALSE;
-                AX_VENC_Init(&stVencModAttr);
-
-                const char *strSkelVencEnvStr = getenv(SKEL_VENC_CHN_ENV_STR);
-                if (strSkelVencEnvStr) {
-                    m_nPushJencChn = (VENC_CHN)atoi(strSkelVencEnvStr);
-                }
+        AX_S32 CJEnc::Destroy(AX_VOID) {
+            std::lock_guard<std::mutex> lck(m_mtx);
 
-                m_nWidth = nWidth;
-                m_nHeight = nHeight;
+            if (!m_bPushValid || -- m_nRefCount > 0) {
+                return AX_SKEL_SUCC;
+            }
 
-                AX_S32 nRet = CreateJenc(m_nPushJencChn, nWidth, nHeight, m_nQpLevel);
+            if (m_bVencOpened) {
+                m_pVenc->Close();
+                m_bVencOpened = AX_FALSE;
+            }
 
-                if (nRet != 0) {
-                    return AX_ERR_SKEL_ILLEGAL_PARAM;
-                }
+            m_pCpu->Close();
 
-                m_bPushValid = AX_TRUE;
+            m_bPushValid = AX_FALSE;
+
+            return AX_SKEL_SUCC;
+        }
+
+        AX_S32 CJEnc::Check(AX_VOID) {
+            std::lock_guard<std::mutex> lck(m_mtx);
+
+            if (!m_bPushValid) {
+                ALOGE("SKEL jenc is not created");
+                return AX_ERR_SKEL_NOT_INIT;
             }
 
             return AX_SKEL_SUCC;
         }
 
-        AX_S32 CJEnc::Destroy(AX_VOID) {
-            if (m_bPushValid) {
-                AX_VENC_StopRecvFrame(m_nPushJencChn);
-                AX_VENC_DestroyChn(m_nPushJencChn);
+        AX_BOOL CJEnc::ToCpu(const AX_VIDEO_FRAME_T &stFrame, const AX_SKEL_JENC_REGION_T &stRegion, AX_BOOL bVencSaturated) {
+            if (!m_bVencOpened || m_eBackend == SKEL_JENC_BACKEND_CPU) {
+                return AX_TRUE;
+            }
+
+            if (m_eBackend == SKEL_JENC_BACKEND_VENC) {
+                return AX_FALSE;
+            }
 
-                AX_VENC_Deinit();
+            const AX_VIDEO_FRAME_T &stSrc = stRegion.pFrame ? *stRegion.pFrame : stFrame;
 
-                m_bPushValid = AX_FALSE;
+            // the venc channels are created for the frame size of the first Create
+            if (stSrc.u32Width * stSrc.u32Height > m_nWidth * m_nHeight) {
+                return AX_TRUE;
             }
 
-            return AX_SKEL_SUCC;
+            AX_S32 nW = (AX_S32)stSrc.u32Width;
+            AX_S32 nH = (AX_S32)stSrc.u32Height;
+            const AX_SKEL_RECT_T &stRect = stRegion.stRect;
+            if ((AX_U32)stRect.fW != 0 || (AX_U32)stRect.fH != 0) {
+                nW = AX_MIN((AX_S32)(stRect.fX + stRect.fW), (AX_S32)stSrc.u32Width) - AX_MAX((AX_S32)stRect.fX, 0);
+                nH = AX_MIN((AX_S32)(stRect.fY + stRect.fH), (AX_S32)stSrc.u32Height) - AX_MAX((AX_S32)stRect.fY, 0);
+            }
+
+            // the venc would encode a larger crop than asked for
+            if (nW < SKEL_VENC_MIN_WIDTH || nH < SKEL_VENC_MIN_HEIGHT) {
+                return AX_TRUE;
+            }
+
+            // small crops overflow to the cpu rather than wait behind the channels, large ones stay on the venc
+            if (bVencSaturated && nW * nH <= SKEL_JENC_CPU_OVERFLOW_PIXELS) {
+                return AX_TRUE;
+            }
+
+            return AX_FALSE;
         }
 
         AX_S32 CJEnc::Get(const AX_VIDEO_FRAME_T &stFrame, AX_SKEL_RECT_T &stRect, AX_U32 &nDstWidth, AX_U32 &nDstHeight,
                           AX_VOID **ppBuf, AX_U32 *pBufSize, AX_U32 nQpLevel) {
-            std::lock_guard<std::mutex> lck(m_mtx);
-
             if (!ppBuf || !pBufSize) {
                 ALOGE("nil pointer");
                 return AX_ERR_SKEL_NULL_PTR;
             }
 
-            AX_S32 nRet = AX_SKEL_SUCC;
-            AX_BOOL bJencStreamGet = AX_FALSE;
-            AX_VIDEO_FRAME_INFO_T tFrame;
-            AX_VENC_STREAM_T stVencStream;
-            memset(&stVencStream, 0x00, sizeof(stVencStream));
+            std::vector<AX_SKEL_JENC_REGION_T> vecRegions(1);
+            vecRegions[0].stRect = stRect;
 
-            if (stFrame.u32Width * stFrame.u32Height > m_nWidth * m_nHeight) {
-                ALOGE("not match for input size(%dx%d), init(%dx%d)",
-                      stFrame.u32Width, stFrame.u32Height, m_nWidth, m_nHeight);
-                return AX_ERR_SKEL_ILLEGAL_PARAM;
+            AX_S32 nRet = GetBatch(stFrame, vecRegions, nQpLevel);
+            if (nRet != AX_SKEL_SUCC) {
+                return nRet;
             }
 
-            if (m_nQpLevel != nQpLevel) {
-                AX_VENC_JPEG_PARAM_T stJpegParam;
-                memset(&stJpegParam, 0, sizeof(AX_VENC_JPEG_PARAM_T));
-                nRet = AX_VENC_GetJpegParam(m_nPushJencChn, &stJpegParam);
-                if (nRet != 0) {
-                    ALOGE("SKEL AX_VENC_GetJpegParam[%d] fail", m_nPushJencChn, nRet);
-                    return AX_ERR_SKEL_ILLEGAL_PARAM;
-                }
+            const AX_SKEL_JENC_REGION_T &stRegion = vecRegions[0];
+            stRect = stRegion.stRect;
+            nDstWidth = stRegion.nDstWidth;
+            nDstHeight = stRegion.nDstHeight;
+            *ppBuf = stRegion.pBuf;
+            *pBufSize = stRegion.nBufSize;
 
-                stJpegParam.u32Qfactor = nQpLevel;
+            return stRegion.nRet;
+        }
 
-                nRet = AX_VENC_SetJpegParam(m_nPushJencChn, &stJpegParam);
-                if (nRet != 0){
-                    ALOGE("AX_VENC_SetJpegParam[%d] fail", m_nPushJencChn, nRet);
-                    return AX_ERR_SKEL_ILLEGAL_PARAM;
-                }
+        AX_S32 CJEnc::GetBatch(const AX_VIDEO_FRAME_T &stFrame, std::vector<AX_SKEL_JENC_REGION_T> &vecRegions, AX_U32 nQpLevel) {
+            AX_S32 nRet = Check();
+            if (nRet != AX_SKEL_SUCC) {
+                return nRet;
             }
 
-            memset(&tFrame, 0x00, sizeof(tFrame));
-            tFrame.stVFrame = stFrame;
-            tFrame.stVFrame.u64PhyAddr[1] = tFrame.stVFrame.u64PhyAddr[0] + tFrame.stVFrame.u32PicStride[0] * tFrame.stVFrame.u32Height;
-            tFrame.stVFrame.u32PicStride[1] = tFrame.stVFrame.u32PicStride[0];
-            tFrame.stVFrame.u32PicStride[2] = 0;
-
-            // crop
-            if ((AX_U32)stRect.fX != 0
-                || (AX_U32)stRect.fY != 0
-                || (AX_U32)stRect.fW != 0
-                || (AX_U32)stRect.fH != 0) {
-                if (stRect.fX < 0) {
-                    stRect.fX = 0;
-                }
+            AX_BOOL bVencSaturated = (m_bVencOpened && m_eBackend == SKEL_JENC_BACKEND_AUTO) ? m_pVenc->Saturated() : AX_FALSE;
 
-                if (stRect.fY < 0) {
-                    stRect.fY = 0;
-                }
-
-                tFrame.stVFrame.s16CropX = ALIGN_DOWN((AX_S16)stRect.fX, 2);
-                tFrame.stVFrame.s16CropY = ALIGN_DOWN((AX_S16)stRect.fY, 2);
-                tFrame.stVFrame.s16CropWidth = ALIGN_DOWN((AX_S16)stRect.fW, 2);
-                tFrame.stVFrame.s16CropHeight = ALIGN_DOWN((AX_S16)stRect.fH, 2);
+            std::vector<size_t> vecVenc;
+            std::vector<size_t> vecCpu;
+            for (size_t i = 0; i < vecRegions.size(); i++) {
+                AX_SKEL_JENC_REGION_T &stRegion = vecRegions[i];
+                stRegion.pBuf = nullptr;
+                stRegion.nBufSize = 0;
+                stRegion.nRet = AX_SKEL_SUCC;
 
-                if (tFrame.stVFrame.s16CropX + tFrame.stVFrame.s16CropWidth > (AX_S32)tFrame.stVFrame.u32Width) {
-                    tFrame.stVFrame.s16CropWidth = ALIGN_DOWN(tFrame.stVFrame.u32Width - tFrame.stVFrame.s16CropX, 2);
+                if (ToCpu(stFrame, stRegion, bVencSaturated)) {
+                    vecCpu.push_back(i);
                 }
-
-                if (tFrame.stVFrame.s16CropY + tFrame.stVFrame.s16CropHeight > (AX_S32)tFrame.stVFrame.u32Height) {
-                    tFrame.stVFrame.s16CropHeight = ALIGN_DOWN(tFrame.stVFrame.u32Height - tFrame.stVFrame.s16CropY, 2);
+                else {
+                    vecVenc.push_back(i);
                 }
+            }
 
-                nDstWidth = tFrame.stVFrame.s16CropWidth;
-                nDstHeight = tFrame.stVFrame.s16CropHeight;
-
-                // FIXME.
-                if (nDstWidth < SKEL_VENC_MIN_WIDTH) {
-                    nDstWidth = SKEL_VENC_MIN_WIDTH;
-                    tFrame.stVFrame.s16CropWidth = SKEL_VENC_MIN_WIDTH;
-                    if (tFrame.stVFrame.s16CropX + tFrame.stVFrame.s16CropWidth > (AX_S32)tFrame.stVFrame.u32Width) {
-                        tFrame.stVFrame.s16CropX = tFrame.stVFrame.u32Width - tFrame.stVFrame.s16CropWidth - 2;
-                    }
-                }
-                if (nDstHeight < SKEL_VENC_MIN_HEIGHT) {
-                    nDstHeight = SKEL_VENC_MIN_HEIGHT;
-                    tFrame.stVFrame.s16CropHeight = SKEL_VENC_MIN_HEIGHT;
-                    if (tFrame.stVFrame.s16CropY + tFrame.stVFrame.s16CropHeight > (AX_S32)tFrame.stVFrame.u32Height) {
-                        tFrame.stVFrame.s16CropY = tFrame.stVFrame.u32Height - tFrame.stVFrame.s16CropHeight - 2;
+            // a backend failing as a whole fails its own regions only, the result of each is in its nRet
+            if (!vecVenc.empty()) {
+                nRet = m_pVenc->Encode(stFrame, vecRegions, vecVenc, nQpLevel);
+                if (nRet != AX_SKEL_SUCC) {
+                    for (size_t i : vecVenc) {
+                        vecRegions[i].nRet = nRet;
                     }
                 }
+            }
 
-                if (tFrame.stVFrame.s16CropX + tFrame.stVFrame.s16CropWidth > (AX_S32)tFrame.stVFrame.u32Width
-                    || tFrame.stVFrame.s16CropY + tFrame.stVFrame.s16CropHeight > (AX_S32)tFrame.stVFrame.u32Height) {
-                    ALOGE("SKEL ignore the region[%d,%d,%d,%d]",
-                          tFrame.stVFrame.s16CropX,
-                          tFrame.stVFrame.s16CropY,
-                          tFrame.stVFrame.s16CropWidth,
-                          tFrame.stVFrame.s16CropHeight);
-                    nRet = AX_ERR_SKEL_ILLEGAL_PARAM;
-                    goto JENC_EXIT;
+            if (!vecCpu.empty()) {
+                AX_VIDEO_FRAME_T stMapped;
+                nRet = m_pCpu->Encode(MapFrame(stFrame, stMapped), vecRegions, vecCpu, nQpLevel);
+                if (nRet != AX_SKEL_SUCC) {
+                    for (size_t i : vecCpu) {
+                        vecRegions[i].nRet = nRet;
+                    }
                 }
             }
-            else {
-                nDstWidth = tFrame.stVFrame.u32Width;
-                nDstHeight = tFrame.stVFrame.u32Height;
-            }
-
-            nRet = AX_VENC_SendFrame(m_nPushJencChn, &tFrame, 2000);
 
-            if (nRet != 0) {
-                ALOGE("SKEL AX_VENC_SendFrame[%d] fail, nRet=0x%x", m_nPushJencChn, nRet);
-                nRet = AX_ERR_SKEL_ILLEGAL_PARAM;
-                goto JENC_EXIT;
+            for (auto &stRegion : vecRegions) {
+                if (stRegion.pBuf) {
+                    ++m_nGetTimes;
+                }
             }
 
-            nRet = AX_VENC_GetStream(m_nPushJencChn, &stVencStream, 2000);
-
-            bJencStreamGet = AX_TRUE;
+            return AX_SKEL_SUCC;
+        }
 
-            if (nRet != 0
-                || !stVencStream.stPack.pu8Addr
-                || stVencStream.stPack.u32Len == 0) {
-                ALOGE("SKEL AX_VENC_GetStream[%d] fail, ret=0x%x", m_nPushJencChn, nRet);
-                nRet = AX_ERR_SKEL_ILLEGAL_PARAM;
-                goto JENC_EXIT;
+        AX_S32 CJEnc::Ref(AX_VOID *pBuf) {
+            if (!pBuf) {
+                ALOGE("nil pointer");
+                return AX_ERR_SKEL_NULL_PTR;
             }
 
-            *ppBuf = new AX_U8[stVencStream.stPack.u32Len];
-
-            if (!(*ppBuf)) {
-                *pBufSize = 0;
-
-                ALOGE("SKEL alloc push buffer fail");
-                nRet = AX_ERR_SKEL_NOMEM;
-                goto JENC_EXIT;
-            }
+            m_BufPool.Ref(pBuf);
 
             ++m_nGetTimes;
 
-            *pBufSize = stVencStream.stPack.u32Len;
-            memcpy(*ppBuf, stVencStream.stPack.pu8Addr, stVencStream.stPack.u32Len);
-
-            JENC_EXIT:
-            if (bJencStreamGet) {
-                AX_VENC_ReleaseStream(m_nPushJencChn, &stVencStream);
-            }
-
-            return nRet;
+            return AX_SKEL_SUCC;
         }
 
         AX_S32 CJEnc::Rel(AX_VOID *pBuf) {
             if (pBuf) {
-                AX_U8 *p = (AX_U8 *)pBuf;
-                delete[] p;
+                m_BufPool.Rel(pBuf);
 
                 ++m_nRelTimes;
             }
@@ -280,13 +264,33 @@ namespace skel {
             return AX_SKEL_SUCC;
         }
 
+        AX_VOID CJEnc::RelItems(const AX_SKEL_OBJECT_ITEM_T *pstItems, AX_U32 nSize) {
+            for (AX_U32 i = 0; i < nSize; i++) {
+                Rel(pstItems[i].stCropFrame.pFrameData);
+                Rel(pstItems[i].stPanoraFrame.pFrameData);
+            }
+        }
+
         AX_S32 CJEnc::Statistics(AX_VOID) {
+            static const AX_CHAR *s_strBackend[] = {"auto", "venc", "cpu"};
+
             ALOGN("Jenc Statistics:");
 
-            ALOGN("\tGet times: %lld, Rel times: %lld", m_nGetTimes, m_nRelTimes);
+            ALOGN("\tGet times: %llu, Rel times: %llu", (unsigned long long)m_nGetTimes, (unsigned long long)m_nRelTimes);
+            ALOGN("\tBuffers: used %d, cached %d", m_BufPool.Used(), m_BufPool.Cached());
+
+            std::lock_guard<std::mutex> lck(m_mtx);
+            ALOGN("\tHandles: %d, Size: %dx%d, Backend: %s", m_nRefCount, m_nWidth, m_nHeight, s_strBackend[m_eBackend]);
+
+            if (m_bVencOpened) {
+                m_pVenc->Statistics();
+            }
+
+            if (m_pCpu) {
+                m_pCpu->Statistics();
+            }
 
             return AX_SKEL_SUCC;
         }
     }
-}
-
+}
\ No newline at end of file
@@ -11,23 +11,29 @@
 #ifndef SKEL_JENC_H
 #define SKEL_JENC_H
 
-#include <map>
 #include <mutex>
+#include <memory>
+#include <vector>
+#include <atomic>
 
 #include "utils/singleton.h"
+#include "utils/buffer_pool.h"
+#include "utils/jenc_venc.h"
+#include "utils/jenc_cpu.h"
 #include "api/ax_skel_def.h"
 #include "ax_skel_type.h"
-#include "ax_venc_api.h"
 
 #define JENCOBJ skel::utils::CJEnc::GetInstance()
 
 namespace skel {
     namespace utils {
-        #define SKEL_VENC_CHN_ENV_STR "SKEL_VENC_CHN_SET"
-        #define SKEL_VENC_CHN_DEFAULT 9
-        #define SKEL_VENC_QPLEVEL_DEFAULT 75
-        #define SKEL_VENC_MIN_WIDTH 32
-        #define SKEL_VENC_MIN_HEIGHT 32
+        #define SKEL_JENC_BACKEND_ENV_STR "SKEL_JENC_BACKEND_SET"      // auto, venc or cpu
+
+        typedef enum {
+            SKEL_JENC_BACKEND_AUTO = 0,     // venc, cpu for what the venc cannot take or is too busy for
+            SKEL_JENC_BACKEND_VENC,
+            SKEL_JENC_BACKEND_CPU,
+        } SKEL_JENC_BACKEND_E;
 
         ///
         class CJEnc   : public CSingleton<CJEnc> {
@@ -38,22 +44,37 @@ namespace skel {
             virtual ~CJEnc(AX_VOID) = default;
 
         public:
+            // shared by the handles, the backends are opened by the first Create and closed by the last Destroy
             virtual AX_S32 Create(AX_U32 nWidth, AX_U32 nHeight);
             virtual AX_S32 Destroy(AX_VOID);
             virtual AX_S32 Get(const AX_VIDEO_FRAME_T &stFrame, AX_SKEL_RECT_T &stRect, AX_U32 &nDstWidth, AX_U32 &nDstHeight,
                                AX_VOID **ppBuf, AX_U32 *pBufSize, AX_U32 nQpLevel);
+            // all regions of one frame, each on the backend it is routed to, the result of each region is in its nRet
+            virtual AX_S32 GetBatch(const AX_VIDEO_FRAME_T &stFrame, std::vector<AX_SKEL_JENC_REGION_T> &vecRegions, AX_U32 nQpLevel);
+            // jpeg buffers are pooled and reference counted, Ref shares one and each reference is Rel-ed
+            virtual AX_S32 Ref(AX_VOID *pBuf);
             virtual AX_S32 Rel(AX_VOID *ppBuf);
+            // the crop and panora jpegs pushed in nSize object items
+            AX_VOID RelItems(const AX_SKEL_OBJECT_ITEM_T *pstItems, AX_U32 nSize);
             virtual AX_S32 Statistics(AX_VOID);
 
+        private:
+            AX_S32 Check(AX_VOID);
+            AX_BOOL ToCpu(const AX_VIDEO_FRAME_T &stFrame, const AX_SKEL_JENC_REGION_T &stRegion, AX_BOOL bVencSaturated);
+
         private:
             std::mutex m_mtx;
+            AX_U32 m_nRefCount{0};
             AX_U32 m_nWidth{0};
             AX_U32 m_nHeight{0};
             AX_BOOL m_bPushValid{AX_FALSE};
-            VENC_CHN m_nPushJencChn{SKEL_VENC_CHN_DEFAULT};
-            AX_U32 m_nQpLevel{SKEL_VENC_QPLEVEL_DEFAULT};
-            AX_U64 m_nGetTimes{0};
-            AX_U64 m_nRelTimes{0};
+            SKEL_JENC_BACKEND_E m_eBackend{SKEL_JENC_BACKEND_AUTO};
+            AX_BOOL m_bVencOpened{AX_FALSE};
+            BufferPool m_BufPool;
+            std::unique_ptr<JencBackend> m_pVenc;
+            std::unique_ptr<JencBackend> m_pCpu;
+            std::atomic<AX_U64> m_nGetTimes{0};
+            std::atomic<AX_U64> m_nRelTimes{0};
         };
     }
 }
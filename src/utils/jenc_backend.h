@@ -0,0 +1,75 @@
+/**************************************************************************************************
+ *
+ * Copyright (c) 2019-2023 Axera Semiconductor (Ningbo) Co., Ltd. All Rights Reserved.
+ *
+ * This source file is the property of Axera Semiconductor (Ningbo) Co., Ltd. and
+ * may not be copied or distributed in any isomorphic form without the prior
+ * written consent of Axera Semiconductor (Ningbo) Co., Ltd.
+ *
+ **************************************************************************************************/
+
+#ifndef SKEL_JENC_BACKEND_H
+#define SKEL_JENC_BACKEND_H
+
+#include <vector>
+
+#include "utils/buffer_pool.h"
+#include "api/ax_skel_def.h"
+#include "ax_skel_type.h"
+
+namespace skel {
+    namespace utils {
+        // one jpeg of a frame, stRect zero for the whole frame
+        typedef struct axSKEL_JENC_REGION_T {
+            const AX_VIDEO_FRAME_T *pFrame;     // source of the region, nullptr for the frame of the batch
+            AX_SKEL_RECT_T stRect;
+            AX_U32 nDstWidth;
+            AX_U32 nDstHeight;
+            AX_VOID *pBuf;
+            AX_U32 nBufSize;
+            AX_S32 nRet;
+
+            axSKEL_JENC_REGION_T() {
+                pFrame = nullptr;
+                memset(&stRect, 0x00, sizeof(stRect));
+                nDstWidth = 0;
+                nDstHeight = 0;
+                pBuf = nullptr;
+                nBufSize = 0;
+                nRet = AX_SKEL_SUCC;
+            }
+        } AX_SKEL_JENC_REGION_T;
+
+        // a jpeg encoder behind CJEnc. the jpegs are handed out in buffers of the pool of CJEnc
+        class JencBackend {
+        public:
+            explicit JencBackend(BufferPool &stBufPool) : m_BufPool(stBufPool) {
+
+            }
+
+            virtual ~JencBackend(AX_VOID) = default;
+
+            // un-copyable or moveable
+            JencBackend(const JencBackend&) = delete;
+            JencBackend& operator = (const JencBackend&) = delete;
+
+        public:
+            virtual const AX_CHAR* Name(AX_VOID) const = 0;
+            // frames up to nWidth x nHeight
+            virtual AX_S32 Open(AX_U32 nWidth, AX_U32 nHeight) = 0;
+            virtual AX_VOID Close(AX_VOID) = 0;
+            // the regions of vecRegions listed in vecIndex, all of stFrame unless a region has its own.
+            // the result of each region is in its nRet
+            virtual AX_S32 Encode(const AX_VIDEO_FRAME_T &stFrame, std::vector<AX_SKEL_JENC_REGION_T> &vecRegions,
+                                  const std::vector<size_t> &vecIndex, AX_U32 nQpLevel) = 0;
+            // a batch encoded now would wait for the ones before it
+            virtual AX_BOOL Saturated(AX_VOID) = 0;
+            virtual AX_VOID Statistics(AX_VOID) = 0;
+
+        protected:
+            BufferPool &m_BufPool;
+        };
+    }
+}
+
+#endif //SKEL_JENC_BACKEND_H
@@ -0,0 +1,596 @@
+/**************************************************************************************************
+ *
+ * Copyright (c) 2019-2023 Axera Semiconductor (Ningbo) Co., Ltd. All Rights Reserved.
+ *
+ * This source file is the property of Axera Semiconductor (Ningbo) Co., Ltd. and
+ * may not be copied or distributed in any isomorphic form without the prior
+ * written consent of Axera Semiconductor (Ningbo) Co., Ltd.
+ *
+ **************************************************************************************************/
+
+#include <string.h>
+#include <chrono>
+#include <algorithm>
+
+#include "utils/jenc_cpu.h"
+#include "utils/logger.h"
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+// ITU T.81 annex K, natural order
+static const AX_U8 s_nQuantLuma[64] = {
+        16, 11, 10, 16, 24, 40, 51, 61,
+        12, 12, 14, 19, 26, 58, 60, 55,
+        14, 13, 16, 24, 40, 57, 69, 56,
+        14, 17, 22, 29, 51, 87, 80, 62,
+        18, 22, 37, 56, 68, 109, 103, 77,
+        24, 35, 55, 64, 81, 104, 113, 92,
+        49, 64, 78, 87, 103, 121, 120, 101,
+        72, 92, 95, 98, 112, 100, 103, 99
+};
+
+static const AX_U8 s_nQuantChroma[64] = {
+        17, 18, 24, 47, 99, 99, 99, 99,
+        18, 21, 26, 66, 99, 99, 99, 99,
+        24, 26, 56, 99, 99, 99, 99, 99,
+        47, 66, 99, 99, 99, 99, 99, 99,
+        99, 99, 99, 99, 99, 99, 99, 99,
+        99, 99, 99, 99, 99, 99, 99, 99,
+        99, 99, 99, 99, 99, 99, 99, 99,
+        99, 99, 99, 99, 99, 99, 99, 99
+};
+
+// natural index of each zigzag position
+static const AX_U8 s_nZigzag[64] = {
+        0, 1, 8, 16, 9, 2, 3, 10,
+        17, 24, 32, 25, 18, 11, 4, 5,
+        12, 19, 26, 33, 40, 48, 41, 34,
+        27, 20, 13, 6, 7, 14, 21, 28,
+        35, 42, 49, 56, 57, 50, 43, 36,
+        29, 22, 15, 23, 30, 37, 44, 51,
+        58, 59, 52, 45, 38, 31, 39, 46,
+        53, 60, 61, 54, 47, 55, 62, 63
+};
+
+static const AX_U8 s_nDcLumaBits[16] = {0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0};
+static const AX_U8 s_nDcChromaBits[16] = {0, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0};
+static const AX_U8 s_nDcVals[12] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+
+static const AX_U8 s_nAcLumaBits[16] = {0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7d};
+static const AX_U8 s_nAcLumaVals[162] = {
+        0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07,
+        0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xa1, 0x08, 0x23, 0x42, 0xb1, 0xc1, 0x15, 0x52, 0xd1, 0xf0,
+        0x24, 0x33, 0x62, 0x72, 0x82, 0x09, 0x0a, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x25, 0x26, 0x27, 0x28,
+        0x29, 0x2a, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49,
+        0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69,
+        0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89,
+        0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7,
+        0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5,
+        0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xe1, 0xe2,
+        0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8,
+        0xf9, 0xfa
+};
+
+static const AX_U8 s_nAcChromaBits[16] = {0, 2, 1, 2, 4, 4, 3, 4, 7, 5, 4, 4, 0, 1, 2, 0x77};
+static const AX_U8 s_nAcChromaVals[162] = {
+        0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31, 0x06, 0x12, 0x41, 0x51, 0x07, 0x61, 0x71,
+        0x13, 0x22, 0x32, 0x81, 0x08, 0x14, 0x42, 0x91, 0xa1, 0xb1, 0xc1, 0x09, 0x23, 0x33, 0x52, 0xf0,
+        0x15, 0x62, 0x72, 0xd1, 0x0a, 0x16, 0x24, 0x34, 0xe1, 0x25, 0xf1, 0x17, 0x18, 0x19, 0x1a, 0x26,
+        0x27, 0x28, 0x29, 0x2a, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48,
+        0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68,
+        0x69, 0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87,
+        0x88, 0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5,
+        0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3,
+        0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda,
+        0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8,
+        0xf9, 0xfa
+};
+
+// scale of the AAN dct outputs, folded into the quantization
+static const AX_F32 s_fAanScale[8] = {
+        1.0f, 1.387039845f, 1.306562965f, 1.175875602f,
+        1.0f, 0.785694958f, 0.541196100f, 0.275899379f
+};
+
+typedef struct {
+    AX_U16 nCode[256];
+    AX_U8 nSize[256];
+} JENC_HUFF_T;
+
+typedef struct {
+    JENC_HUFF_T stDcLuma;
+    JENC_HUFF_T stAcLuma;
+    JENC_HUFF_T stDcChroma;
+    JENC_HUFF_T stAcChroma;
+} JENC_HUFF_SET_T;
+
+// quantization of one component at one quality
+typedef struct {
+    AX_U8 nQuant[64];                   // zigzag order, as in DQT
+    AX_F32 fDivisor[64];                // transposed natural order, as the dct leaves the block
+} JENC_QUANT_T;
+
+typedef struct {
+    std::vector<AX_U8> *pOut;
+    AX_U64 nAcc;
+    AX_U32 nBits;
+} JENC_BITS_T;
+
+// canonical codes of annex C
+static AX_VOID BuildHuff(const AX_U8 *pBits, const AX_U8 *pVals, JENC_HUFF_T &stHuff) {
+    memset(&stHuff, 0x00, sizeof(stHuff));
+
+    AX_U32 nCode = 0;
+    AX_U32 k = 0;
+    for (AX_U32 nLen = 1; nLen <= 16; nLen++) {
+        for (AX_U32 i = 0; i < pBits[nLen - 1]; i++, k++) {
+            stHuff.nCode[pVals[k]] = (AX_U16)nCode++;
+            stHuff.nSize[pVals[k]] = (AX_U8)nLen;
+        }
+        nCode <<= 1;
+    }
+}
+
+static const JENC_HUFF_SET_T &HuffSet(AX_VOID) {
+    static const JENC_HUFF_SET_T s_stHuffSet = [] {
+        JENC_HUFF_SET_T stSet;
+        BuildHuff(s_nDcLumaBits, s_nDcVals, stSet.stDcLuma);
+        BuildHuff(s_nAcLumaBits, s_nAcLumaVals, stSet.stAcLuma);
+        BuildHuff(s_nDcChromaBits, s_nDcVals, stSet.stDcChroma);
+        BuildHuff(s_nAcChromaBits, s_nAcChromaVals, stSet.stAcChroma);
+        return stSet;
+    }();
+
+    return s_stHuffSet;
+}
+
+// the libjpeg quality scaling, so a Qfactor reads as it does for venc
+static AX_VOID BuildQuant(const AX_U8 *pBase, AX_U32 nQuality, JENC_QUANT_T &stQuant) {
+    nQuality = AX_MIN(AX_MAX(nQuality, 1u), 100u);
+    AX_U32 nScale = (nQuality < 50) ? 5000 / nQuality : 200 - nQuality * 2;
+
+    AX_U8 nNatural[64];
+    for (AX_U32 i = 0; i < 64; i++) {
+        AX_U32 nQ = (pBase[i] * nScale + 50) / 100;
+        nNatural[i] = (AX_U8)AX_MIN(AX_MAX(nQ, 1u), 255u);
+    }
+
+    for (AX_U32 k = 0; k < 64; k++) {
+        stQuant.nQuant[k] = nNatural[s_nZigzag[k]];
+    }
+
+    for (AX_U32 u = 0; u < 8; u++) {
+        for (AX_U32 v = 0; v < 8; v++) {
+            stQuant.fDivisor[v * 8 + u] = 1.0f / (nNatural[u * 8 + v] * s_fAanScale[u] * s_fAanScale[v] * 8.0f);
+        }
+    }
+}
+
+static inline AX_VOID PutBits(JENC_BITS_T &stBits, AX_U32 nCode, AX_U32 nSize) {
+    stBits.nAcc = (stBits.nAcc << nSize) | (nCode & ((1u << nSize) - 1));
+    stBits.nBits += nSize;
+
+    while (stBits.nBits >= 8) {
+        AX_U8 nByte = (AX_U8)(stBits.nAcc >> (stBits.nBits - 8));
+        stBits.nBits -= 8;
+        stBits.pOut->push_back(nByte);
+        if (nByte == 0xFF) {
+            stBits.pOut->push_back(0x00);
+        }
+    }
+}
+
+static inline AX_VOID PutHuff(JENC_BITS_T &stBits, const JENC_HUFF_T &stHuff, AX_U32 nSymbol) {
+    PutBits(stBits, stHuff.nCode[nSymbol], stHuff.nSize[nSymbol]);
+}
+
+static inline AX_U32 Category(AX_S32 nValue) {
+    AX_U32 nAbs = (AX_U32)(nValue < 0 ? -nValue : nValue);
+    return nAbs ? 32 - __builtin_clz(nAbs) : 0;
+}
+
+static AX_VOID PutMarker(std::vector<AX_U8> &vecOut, AX_U8 nMarker, AX_U16 nLength) {
+    vecOut.push_back(0xFF);
+    vecOut.push_back(nMarker);
+    if (nLength > 0) {
+        vecOut.push_back((AX_U8)(nLength >> 8));
+        vecOut.push_back((AX_U8)(nLength & 0xFF));
+    }
+}
+
+static AX_VOID PutHuffTable(std::vector<AX_U8> &vecOut, AX_U8 nClassId, const AX_U8 *pBits, const AX_U8 *pVals) {
+    AX_U32 nCount = 0;
+    vecOut.push_back(nClassId);
+    for (AX_U32 i = 0; i < 16; i++) {
+        vecOut.push_back(pBits[i]);
+        nCount += pBits[i];
+    }
+    vecOut.insert(vecOut.end(), pVals, pVals + nCount);
+}
+
+static AX_VOID PutHeaders(std::vector<AX_U8> &vecOut, AX_U32 nWidth, AX_U32 nHeight, const JENC_QUANT_T &stLuma, const JENC_QUANT_T &stChroma) {
+    static const AX_U8 s_nJfif[14] = {'J', 'F', 'I', 'F', 0, 1, 1, 0, 0, 1, 0, 1, 0, 0};
+
+    PutMarker(vecOut, 0xD8, 0);
+
+    PutMarker(vecOut, 0xE0, 2 + sizeof(s_nJfif));
+    vecOut.insert(vecOut.end(), s_nJfif, s_nJfif + sizeof(s_nJfif));
+
+    PutMarker(vecOut, 0xDB, 2 + 2 * 65);
+    vecOut.push_back(0x00);
+    vecOut.insert(vecOut.end(), stLuma.nQuant, stLuma.nQuant + 64);
+    vecOut.push_back(0x01);
+    vecOut.insert(vecOut.end(), stChroma.nQuant, stChroma.nQuant + 64);
+
+    // baseline, Y 2x2 with table 0, Cb and Cr 1x1 with table 1
+    const AX_U8 nSof[15] = {
+            8, (AX_U8)(nHeight >> 8), (AX_U8)(nHeight & 0xFF), (AX_U8)(nWidth >> 8), (AX_U8)(nWidth & 0xFF),
+            3, 1, 0x22, 0, 2, 0x11, 1, 3, 0x11, 1
+    };
+    PutMarker(vecOut, 0xC0, 2 + sizeof(nSof));
+    vecOut.insert(vecOut.end(), nSof, nSof + sizeof(nSof));
+
+    PutMarker(vecOut, 0xC4, 2 + (17 + 12) * 2 + (17 + 162) * 2);
+    PutHuffTable(vecOut, 0x00, s_nDcLumaBits, s_nDcVals);
+    PutHuffTable(vecOut, 0x10, s_nAcLumaBits, s_nAcLumaVals);
+    PutHuffTable(vecOut, 0x01, s_nDcChromaBits, s_nDcVals);
+    PutHuffTable(vecOut, 0x11, s_nAcChromaBits, s_nAcChromaVals);
+
+    const AX_U8 nSos[10] = {3, 1, 0x00, 2, 0x11, 3, 0x11, 0, 63, 0};
+    PutMarker(vecOut, 0xDA, 2 + sizeof(nSos));
+    vecOut.insert(vecOut.end(), nSos, nSos + sizeof(nSos));
+}
+
+// the float AAN forward dct of 8 values, each T a value or a vector of them
+static inline AX_F32 DctAdd(AX_F32 a, AX_F32 b) { return a + b; }
+static inline AX_F32 DctSub(AX_F32 a, AX_F32 b) { return a - b; }
+static inline AX_F32 DctMul(AX_F32 a, AX_F32 k) { return a * k; }
+
+#if defined(__aarch64__)
+static inline float32x4_t DctAdd(float32x4_t a, float32x4_t b) { return vaddq_f32(a, b); }
+static inline float32x4_t DctSub(float32x4_t a, float32x4_t b) { return vsubq_f32(a, b); }
+static inline float32x4_t DctMul(float32x4_t a, AX_F32 k) { return vmulq_n_f32(a, k); }
+#endif
+
+template <typename T>
+static inline AX_VOID Fdct8(T *d) {
+    T tmp0 = DctAdd(d[0], d[7]);
+    T tmp7 = DctSub(d[0], d[7]);
+    T tmp1 = DctAdd(d[1], d[6]);
+    T tmp6 = DctSub(d[1], d[6]);
+    T tmp2 = DctAdd(d[2], d[5]);
+    T tmp5 = DctSub(d[2], d[5]);
+    T tmp3 = DctAdd(d[3], d[4]);
+    T tmp4 = DctSub(d[3], d[4]);
+
+    // even part
+    T tmp10 = DctAdd(tmp0, tmp3);
+    T tmp13 = DctSub(tmp0, tmp3);
+    T tmp11 = DctAdd(tmp1, tmp2);
+    T tmp12 = DctSub(tmp1, tmp2);
+
+    d[0] = DctAdd(tmp10, tmp11);
+    d[4] = DctSub(tmp10, tmp11);
+
+    T z1 = DctMul(DctAdd(tmp12, tmp13), 0.707106781f);
+    d[2] = DctAdd(tmp13, z1);
+    d[6] = DctSub(tmp13, z1);
+
+    // odd part
+    tmp10 = DctAdd(tmp4, tmp5);
+    tmp11 = DctAdd(tmp5, tmp6);
+    tmp12 = DctAdd(tmp6, tmp7);
+
+    T z5 = DctMul(DctSub(tmp10, tmp12), 0.382683433f);
+    T z2 = DctAdd(DctMul(tmp10, 0.541196100f), z5);
+    T z4 = DctAdd(DctMul(tmp12, 1.306562965f), z5);
+    T z3 = DctMul(tmp11, 0.707106781f);
+
+    T z11 = DctAdd(tmp7, z3);
+    T z13 = DctSub(tmp7, z3);
+
+    d[5] = DctAdd(z13, z2);
+    d[3] = DctSub(z13, z2);
+    d[1] = DctAdd(z11, z4);
+    d[7] = DctSub(z11, z4);
+}
+
+// level shift, dct and quantization of the 8x8 block at pSrc, pCoef in zigzag order
+static AX_VOID ForwardBlock(const AX_U8 *pSrc, AX_U32 nStride, const JENC_QUANT_T &stQuant, AX_S16 *pCoef) {
+    // coefficient (u, v) at [v * 8 + u], vertical frequency u
+    AX_S16 nCoefT[64];
+
+#if defined(__aarch64__)
+    // lanes are 4 columns, v[h][r] holds row r of columns 4h..4h+3
+    float32x4_t v[2][8];
+    for (AX_U32 r = 0; r < 8; r++) {
+        int16x8_t s = vreinterpretq_s16_u16(vsubl_u8(vld1_u8(pSrc + r * nStride), vdup_n_u8(128)));
+        v[0][r] = vcvtq_f32_s32(vmovl_s16(vget_low_s16(s)));
+        v[1][r] = vcvtq_f32_s32(vmovl_s16(vget_high_s16(s)));
+    }
+
+    // columns
+    Fdct8(v[0]);
+    Fdct8(v[1]);
+
+    // transpose the 4x4 tiles, x[hu][c] holds column c of rows 4hu..4hu+3
+    float32x4_t x[2][8];
+    for (AX_U32 hu = 0; hu < 2; hu++) {
+        for (AX_U32 h = 0; h < 2; h++) {
+            float32x4x2_t t01 = vtrnq_f32(v[h][4 * hu + 0], v[h][4 * hu + 1]);
+            float32x4x2_t t23 = vtrnq_f32(v[h][4 * hu + 2], v[h][4 * hu + 3]);
+            x[hu][4 * h + 0] = vcombine_f32(vget_low_f32(t01.val[0]), vget_low_f32(t23.val[0]));
+            x[hu][4 * h + 1] = vcombine_f32(vget_low_f32(t01.val[1]), vget_low_f32(t23.val[1]));
+            x[hu][4 * h + 2] = vcombine_f32(vget_high_f32(t01.val[0]), vget_high_f32(t23.val[0]));
+            x[hu][4 * h + 3] = vcombine_f32(vget_high_f32(t01.val[1]), vget_high_f32(t23.val[1]));
+        }
+    }
+
+    // rows
+    Fdct8(x[0]);
+    Fdct8(x[1]);
+
+    for (AX_U32 hu = 0; hu < 2; hu++) {
+        for (AX_U32 c = 0; c < 8; c++) {
+            float32x4_t q = vmulq_f32(x[hu][c], vld1q_f32(stQuant.fDivisor + c * 8 + 4 * hu));
+            vst1_s16(nCoefT + c * 8 + 4 * hu, vmovn_s32(vcvtnq_s32_f32(q)));
+        }
+    }
+#else
+    AX_F32 fBlock[64];
+    for (AX_U32 r = 0; r < 8; r++) {
+        for (AX_U32 c = 0; c < 8; c++) {
+            fBlock[r * 8 + c] = (AX_F32)pSrc[r * nStride + c] - 128.0f;
+        }
+    }
+
+    // rows, then columns
+    for (AX_U32 r = 0; r < 8; r++) {
+        Fdct8(fBlock + r * 8);
+    }
+
+    for (AX_U32 c = 0; c < 8; c++) {
+        AX_F32 fColumn[8];
+        for (AX_U32 r = 0; r < 8; r++) {
+            fColumn[r] = fBlock[r * 8 + c];
+        }
+        Fdct8(fColumn);
+        for (AX_U32 r = 0; r < 8; r++) {
+            fBlock[r * 8 + c] = fColumn[r];
+        }
+    }
+
+    for (AX_U32 u = 0; u < 8; u++) {
+        for (AX_U32 v = 0; v < 8; v++) {
+            AX_F32 fQ = fBlock[u * 8 + v] * stQuant.fDivisor[v * 8 + u];
+            nCoefT[v * 8 + u] = (AX_S16)(fQ < 0 ? fQ - 0.5f : fQ + 0.5f);
+        }
+    }
+#endif
+
+    for (AX_U32 k = 0; k < 64; k++) {
+        AX_U32 n = s_nZigzag[k];
+        pCoef[k] = nCoefT[(n & 7) * 8 + (n >> 3)];
+    }
+}
+
+static AX_VOID EncodeBlock(JENC_BITS_T &stBits, const AX_U8 *pSrc, AX_U32 nStride, const JENC_QUANT_T &stQuant,
+                           const JENC_HUFF_T &stDc, const JENC_HUFF_T &stAc, AX_S32 &nDcPrev) {
+    AX_S16 nCoef[64];
+    ForwardBlock(pSrc, nStride, stQuant, nCoef);
+
+    AX_S32 nDiff = nCoef[0] - nDcPrev;
+    nDcPrev = nCoef[0];
+
+    AX_U32 nCat = Category(nDiff);
+    PutHuff(stBits, stDc, nCat);
+    PutBits(stBits, (AX_U32)(nDiff < 0 ? nDiff - 1 : nDiff), nCat);
+
+    AX_U32 nRun = 0;
+    for (AX_U32 k = 1; k < 64; k++) {
+        AX_S32 nValue = nCoef[k];
+        if (nValue == 0) {
+            nRun++;
+            continue;
+        }
+
+        while (nRun > 15) {
+            PutHuff(stBits, stAc, 0xF0);
+            nRun -= 16;
+        }
+
+        nCat = Category(nValue);
+        PutHuff(stBits, stAc, (nRun << 4) | nCat);
+        PutBits(stBits, (AX_U32)(nValue < 0 ? nValue - 1 : nValue), nCat);
+        nRun = 0;
+    }
+
+    if (nRun > 0) {
+        PutHuff(stBits, stAc, 0x00);
+    }
+}
+
+// splits n interleaved uv pairs
+static AX_VOID Deinterleave(const AX_U8 *pUV, AX_U8 *pU, AX_U8 *pV, AX_U32 n) {
+    AX_U32 i = 0;
+
+#if defined(__aarch64__)
+    for (; i + 16 <= n; i += 16) {
+        uint8x16x2_t uv = vld2q_u8(pUV + 2 * i);
+        vst1q_u8(pU + i, uv.val[0]);
+        vst1q_u8(pV + i, uv.val[1]);
+    }
+#endif
+
+    for (; i < n; i++) {
+        pU[i] = pUV[2 * i];
+        pV[i] = pUV[2 * i + 1];
+    }
+}
+
+namespace skel {
+    namespace utils {
+        CpuJenc::CpuJenc(BufferPool &stBufPool) : JencBackend(stBufPool) {
+            HuffSet();
+        }
+
+        AX_S32 CpuJenc::Open(AX_U32, AX_U32) {
+            return AX_SKEL_SUCC;
+        }
+
+        AX_VOID CpuJenc::Close(AX_VOID) {
+        }
+
+        AX_S32 CpuJenc::EncodeNV12(const AX_U8 *pY, AX_U32 nStrideY, const AX_U8 *pUV, AX_U32 nStrideUV,
+                                   AX_U32 nWidth, AX_U32 nHeight, AX_U32 nQuality, std::vector<AX_U8> &vecOut) {
+            if (!pY || !pUV || nWidth == 0 || nHeight == 0 || nWidth > 0xFFFF || nHeight > 0xFFFF) {
+                return AX_ERR_SKEL_ILLEGAL_PARAM;
+            }
+
+            const JENC_HUFF_SET_T &stHuff = HuffSet();
+            JENC_QUANT_T stLuma;
+            JENC_QUANT_T stChroma;
+            BuildQuant(s_nQuantLuma, nQuality, stLuma);
+            BuildQuant(s_nQuantChroma, nQuality, stChroma);
+
+            PutHeaders(vecOut, nWidth, nHeight, stLuma, stChroma);
+
+            // one mcu row staged with the right and bottom edges replicated
+            AX_U32 nPadWidth = ALIGN_UP(nWidth, 16);
+            AX_U32 nChromaWidth = (nWidth + 1) / 2;
+            AX_U32 nChromaHeight = (nHeight + 1) / 2;
+            std::vector<AX_U8> vecRow(nPadWidth * 16 + nPadWidth / 2 * 8 * 2);
+            AX_U8 *pRowY = vecRow.data();
+            AX_U8 *pRowU = pRowY + nPadWidth * 16;
+            AX_U8 *pRowV = pRowU + nPadWidth / 2 * 8;
+
+            JENC_BITS_T stBits = {&vecOut, 0, 0};
+            AX_S32 nDcY = 0;
+            AX_S32 nDcU = 0;
+            AX_S32 nDcV = 0;
+
+            for (AX_U32 nMcuY = 0; nMcuY < nHeight; nMcuY += 16) {
+                for (AX_U32 r = 0; r < 16; r++) {
+                    AX_U8 *pDst = pRowY + r * nPadWidth;
+                    memcpy(pDst, pY + (AX_U64)AX_MIN(nMcuY + r, nHeight - 1) * nStrideY, nWidth);
+                    memset(pDst + nWidth, pDst[nWidth - 1], nPadWidth - nWidth);
+                }
+
+                for (AX_U32 r = 0; r < 8; r++) {
+                    AX_U8 *pDstU = pRowU + r * nPadWidth / 2;
+                    AX_U8 *pDstV = pRowV + r * nPadWidth / 2;
+                    Deinterleave(pUV + (AX_U64)AX_MIN(nMcuY / 2 + r, nChromaHeight - 1) * nStrideUV, pDstU, pDstV, nChromaWidth);
+                    memset(pDstU + nChromaWidth, pDstU[nChromaWidth - 1], nPadWidth / 2 - nChromaWidth);
+                    memset(pDstV + nChromaWidth, pDstV[nChromaWidth - 1], nPadWidth / 2 - nChromaWidth);
+                }
+
+                for (AX_U32 nMcuX = 0; nMcuX < nPadWidth; nMcuX += 16) {
+                    const AX_U8 *pBlockY = pRowY + nMcuX;
+                    EncodeBlock(stBits, pBlockY, nPadWidth, stLuma, stHuff.stDcLuma, stHuff.stAcLuma, nDcY);
+                    EncodeBlock(stBits, pBlockY + 8, nPadWidth, stLuma, stHuff.stDcLuma, stHuff.stAcLuma, nDcY);
+                    EncodeBlock(stBits, pBlockY + 8 * nPadWidth, nPadWidth, stLuma, stHuff.stDcLuma, stHuff.stAcLuma, nDcY);
+                    EncodeBlock(stBits, pBlockY + 8 * nPadWidth + 8, nPadWidth, stLuma, stHuff.stDcLuma, stHuff.stAcLuma, nDcY);
+                    EncodeBlock(stBits, pRowU + nMcuX / 2, nPadWidth / 2, stChroma, stHuff.stDcChroma, stHuff.stAcChroma, nDcU);
+                    EncodeBlock(stBits, pRowV + nMcuX / 2, nPadWidth / 2, stChroma, stHuff.stDcChroma, stHuff.stAcChroma, nDcV);
+                }
+            }
+
+            // pad the last byte with ones
+            PutBits(stBits, 0x7F, 7);
+            PutMarker(vecOut, 0xD9, 0);
+
+            return AX_SKEL_SUCC;
+        }
+
+        AX_S32 CpuJenc::Encode(const AX_VIDEO_FRAME_T &stFrame, std::vector<AX_SKEL_JENC_REGION_T> &vecRegions,
+                               const std::vector<size_t> &vecIndex, AX_U32 nQpLevel) {
+            std::vector<AX_U8> vecOut;
+
+            for (size_t nIndex : vecIndex) {
+                AX_SKEL_JENC_REGION_T &stRegion = vecRegions[nIndex];
+                const AX_VIDEO_FRAME_T &stSrc = stRegion.pFrame ? *stRegion.pFrame : stFrame;
+                auto startTime = std::chrono::steady_clock::now();
+
+                if (stSrc.enImgFormat != AX_FORMAT_YUV420_SEMIPLANAR) {
+                    ALOGE("SKEL cpu jenc takes nv12 only, format %d", stSrc.enImgFormat);
+                    stRegion.nRet = AX_ERR_SKEL_NOT_SUPPORT;
+                    continue;
+                }
+
+                // mapped by the caller
+                const AX_U8 *pY = (const AX_U8 *)stSrc.u64VirAddr[0];
+                AX_U32 nStrideY = stSrc.u32PicStride[0];
+                AX_U32 nStrideUV = stSrc.u32PicStride[1] ? stSrc.u32PicStride[1] : nStrideY;
+                if (!pY || nStrideY == 0) {
+                    ALOGE("SKEL cpu jenc: frame is not mapped");
+                    stRegion.nRet = AX_ERR_SKEL_ILLEGAL_PARAM;
+                    continue;
+                }
+
+                // the uv plane follows the y plane unless it is mapped on its own
+                const AX_U8 *pUV = stSrc.u64VirAddr[0] && stSrc.u64VirAddr[1]
+                                   ? (const AX_U8 *)stSrc.u64VirAddr[1]
+                                   : pY + (AX_U64)nStrideY * stSrc.u32Height;
+
+                // the crop clipped to the frame, even origin for the chroma
+                AX_S32 nX = 0;
+                AX_S32 nY = 0;
+                AX_S32 nW = (AX_S32)stSrc.u32Width;
+                AX_S32 nH = (AX_S32)stSrc.u32Height;
+                if ((AX_U32)stRegion.stRect.fW != 0 || (AX_U32)stRegion.stRect.fH != 0) {
+                    nX = ALIGN_DOWN(AX_MAX((AX_S32)stRegion.stRect.fX, 0), 2);
+                    nY = ALIGN_DOWN(AX_MAX((AX_S32)stRegion.stRect.fY, 0), 2);
+                    nW = AX_MIN((AX_S32)(stRegion.stRect.fX + stRegion.stRect.fW), (AX_S32)stSrc.u32Width) - nX;
+                    nH = AX_MIN((AX_S32)(stRegion.stRect.fY + stRegion.stRect.fH), (AX_S32)stSrc.u32Height) - nY;
+                }
+
+                if (nW <= 0 || nH <= 0) {
+                    ALOGE("SKEL ignore the region[%d,%d,%d,%d]", nX, nY, nW, nH);
+                    stRegion.nRet = AX_ERR_SKEL_ILLEGAL_PARAM;
+                    continue;
+                }
+
+                stRegion.stRect.fX = nX;
+                stRegion.stRect.fY = nY;
+                stRegion.stRect.fW = nW;
+                stRegion.stRect.fH = nH;
+                stRegion.nDstWidth = nW;
+                stRegion.nDstHeight = nH;
+
+                vecOut.clear();
+                vecOut.reserve(nW * nH / 2 + 1024);
+                stRegion.nRet = EncodeNV12(pY + (AX_U64)nY * nStrideY + nX, nStrideY,
+                                           pUV + (AX_U64)(nY / 2) * nStrideUV + nX, nStrideUV,
+                                           nW, nH, nQpLevel, vecOut);
+                if (stRegion.nRet != AX_SKEL_SUCC) {
+                    continue;
+                }
+
+                stRegion.pBuf = m_BufPool.Alloc(vecOut.size());
+                if (!stRegion.pBuf) {
+                    ALOGE("SKEL alloc push buffer fail");
+                    stRegion.nRet = AX_ERR_SKEL_NOMEM;
+                    continue;
+                }
+
+                memcpy(stRegion.pBuf, vecOut.data(), vecOut.size());
+                stRegion.nBufSize = vecOut.size();
+
+                m_nEncodes ++;
+                m_nBytes += vecOut.size();
+                m_nCostUs += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startTime).count();
+            }
+
+            return AX_SKEL_SUCC;
+        }
+
+        AX_VOID CpuJenc::Statistics(AX_VOID) {
+            AX_U64 nEncodes = m_nEncodes;
+            ALOGN("\tCpu: encodes %llu, bytes %llu, avg cost %llu us",
+                  (unsigned long long)nEncodes, (unsigned long long)m_nBytes,
+                  (unsigned long long)(nEncodes > 0 ? (AX_U64)m_nCostUs / nEncodes : 0));
+        }
+    }
+}
@@ -0,0 +1,57 @@
+/**************************************************************************************************
+ *
+ * Copyright (c) 2019-2023 Axera Semiconductor (Ningbo) Co., Ltd. All Rights Reserved.
+ *
+ * This source file is the property of Axera Semiconductor (Ningbo) Co., Ltd. and
+ * may not be copied or distributed in any isomorphic form without the prior
+ * written consent of Axera Semiconductor (Ningbo) Co., Ltd.
+ *
+ **************************************************************************************************/
+
+#ifndef SKEL_JENC_CPU_H
+#define SKEL_JENC_CPU_H
+
+#include <atomic>
+
+#include "utils/jenc_backend.h"
+
+namespace skel {
+    namespace utils {
+        #define SKEL_JENC_CPU_OVERFLOW_PIXELS (256 * 256)   // largest region the cpu takes over from a saturated venc
+
+        // baseline 4:2:0 jpeg on the cpu, straight from the nv12 planes of the crop. one mcu row of
+        // the crop is staged at a time, the dct and quantization are neon on aarch64. runs on the
+        // calling thread, any region size, no VENC needed
+        class CpuJenc : public JencBackend {
+        public:
+            explicit CpuJenc(BufferPool &stBufPool);
+            virtual ~CpuJenc(AX_VOID) = default;
+
+        public:
+            virtual const AX_CHAR* Name(AX_VOID) const override {
+                return "cpu";
+            }
+
+            virtual AX_S32 Open(AX_U32 nWidth, AX_U32 nHeight) override;
+            virtual AX_VOID Close(AX_VOID) override;
+            virtual AX_S32 Encode(const AX_VIDEO_FRAME_T &stFrame, std::vector<AX_SKEL_JENC_REGION_T> &vecRegions,
+                                  const std::vector<size_t> &vecIndex, AX_U32 nQpLevel) override;
+            virtual AX_BOOL Saturated(AX_VOID) override {
+                return AX_FALSE;
+            }
+
+            virtual AX_VOID Statistics(AX_VOID) override;
+
+            // jpeg of a nWidth x nHeight nv12 image appended to vecOut, pY / pUV at its top left (even x and y)
+            static AX_S32 EncodeNV12(const AX_U8 *pY, AX_U32 nStrideY, const AX_U8 *pUV, AX_U32 nStrideUV,
+                                     AX_U32 nWidth, AX_U32 nHeight, AX_U32 nQuality, std::vector<AX_U8> &vecOut);
+
+        private:
+            std::atomic<AX_U64> m_nEncodes{0};
+            std::atomic<AX_U64> m_nBytes{0};
+            std::atomic<AX_U64> m_nCostUs{0};
+        };
+    }
+}
+
+#endif //SKEL_JENC_CPU_H
@@ -0,0 +1,177 @@
+/**************************************************************************************************
+ *
+ * Copyright (c) 2019-2023 Axera Semiconductor (Ningbo) Co., Ltd. All Rights Reserved.
+ *
+ * This source file is the property of Axera Semiconductor (Ningbo) Co., Ltd. and
+ * may not be copied or distributed in any isomorphic form without the prior
+ * written consent of Axera Semiconductor (Ningbo) Co., Ltd.
+ *
+ **************************************************************************************************/
+
+#include <string.h>
+
+#include "utils/jenc_rate.h"
+#include "utils/logger.h"
+
+// upper pixel count of each size class, the last one takes the rest (panoramas)
+static const AX_U32 s_nClassPixels[SKEL_JENC_SIZE_CLASS_NUM - 1] = {
+        128 * 128,
+        256 * 256,
+        512 * 512
+};
+
+// how much of the level drop a size class takes, small crops keep their quality the longest
+static const AX_F32 s_fClassWeight[SKEL_JENC_SIZE_CLASS_NUM] = {
+        0.5f,
+        1.0f,
+        1.5f,
+        2.0f
+};
+
+#define JENC_RATE_LEVEL_DOWN_GAIN 0.5f      // per slot, times the excess ratio
+#define JENC_RATE_LEVEL_DOWN_MAX 0.25f
+#define JENC_RATE_LEVEL_UP 0.05f            // per slot under JENC_RATE_LEVEL_UP_RATIO of the target
+#define JENC_RATE_LEVEL_UP_RATIO 0.8f
+#define JENC_RATE_BACKLOG_PENALTY 0.15f     // per batch waiting beyond SKEL_JENC_BACKLOG_FREE
+
+namespace skel {
+    namespace utils {
+        JencRate::JencRate(AX_VOID) {
+            m_slotTime = std::chrono::steady_clock::now();
+            memset(m_nSlotBytes, 0x00, sizeof(m_nSlotBytes));
+            memset(m_nEncodes, 0x00, sizeof(m_nEncodes));
+            memset(m_nBytes, 0x00, sizeof(m_nBytes));
+            memset(m_nQfactorHist, 0x00, sizeof(m_nQfactorHist));
+        }
+
+        AX_VOID JencRate::Configure(AX_U32 nByteRate, AX_U32 nQfactor) {
+            std::lock_guard<std::mutex> lck(m_mtx);
+
+            if (nByteRate != m_nByteRate) {
+                m_fLevel = 1.0f;
+            }
+
+            m_nByteRate = nByteRate;
+            m_nQfactor = AX_MIN(AX_MAX(nQfactor, DEFAULT_QPLEVEL_MIN), DEFAULT_QPLEVEL_MAX);
+        }
+
+        AX_U32 JencRate::Qfactor(AX_U32 nPixels, AX_U32 nBacklog) {
+            std::lock_guard<std::mutex> lck(m_mtx);
+
+            Roll();
+
+            if (m_nByteRate == 0 || m_nQfactor <= SKEL_JENC_QFACTOR_MIN) {
+                return m_nQfactor;
+            }
+
+            AX_F32 fLevel = 1.0f - (1.0f - m_fLevel) * s_fClassWeight[SizeClass(nPixels)];
+            if (nBacklog > SKEL_JENC_BACKLOG_FREE) {
+                fLevel -= JENC_RATE_BACKLOG_PENALTY * (nBacklog - SKEL_JENC_BACKLOG_FREE);
+            }
+            fLevel = AX_MIN(AX_MAX(fLevel, 0.0f), 1.0f);
+
+            AX_U32 nQfactor = SKEL_JENC_QFACTOR_MIN + (AX_U32)((m_nQfactor - SKEL_JENC_QFACTOR_MIN) * fLevel);
+            if (nQfactor < m_nQfactor) {
+                nQfactor = AX_MAX(nQfactor / SKEL_JENC_QFACTOR_STEP * SKEL_JENC_QFACTOR_STEP, SKEL_JENC_QFACTOR_MIN);
+            }
+
+            return nQfactor;
+        }
+
+        AX_VOID JencRate::Account(AX_U32 nPixels, AX_U32 nQfactor, AX_U32 nBytes) {
+            std::lock_guard<std::mutex> lck(m_mtx);
+
+            Roll();
+
+            AX_U32 nClass = SizeClass(nPixels);
+            m_nSlotBytes[m_nSlot] += nBytes;
+            m_nEncodes[nClass] ++;
+            m_nBytes[nClass] += nBytes;
+            m_nQfactorHist[AX_MIN(nQfactor / 10, SKEL_JENC_QFACTOR_HIST_NUM - 1)] ++;
+        }
+
+        AX_VOID JencRate::Stat(AX_SKEL_JENC_RATE_STAT_T &stStat) {
+            std::lock_guard<std::mutex> lck(m_mtx);
+
+            Roll();
+
+            stStat.nByteRate = m_nByteRate;
+            stStat.nBytesPerSec = BytesPerSec();
+            stStat.fLevel = m_fLevel;
+            memcpy(stStat.nEncodes, m_nEncodes, sizeof(m_nEncodes));
+            memcpy(stStat.nBytes, m_nBytes, sizeof(m_nBytes));
+            memcpy(stStat.nQfactorHist, m_nQfactorHist, sizeof(m_nQfactorHist));
+        }
+
+        AX_S32 JencRate::Statistics(AX_VOID) {
+            AX_SKEL_JENC_RATE_STAT_T stStat;
+            Stat(stStat);
+
+            ALOGN("Jenc Rate Statistics:");
+            ALOGN("\tTarget: %d B/s, Rate: %llu B/s, Level: %.2f", stStat.nByteRate, (unsigned long long)stStat.nBytesPerSec, stStat.fLevel);
+
+            for (AX_U32 i = 0; i < SKEL_JENC_SIZE_CLASS_NUM; i++) {
+                ALOGN("\t\tClass[%d]: (N: %llu, B: %llu, A: %llu)", i, (unsigned long long)stStat.nEncodes[i],
+                      (unsigned long long)stStat.nBytes[i],
+                      (unsigned long long)(stStat.nEncodes[i] > 0 ? stStat.nBytes[i] / stStat.nEncodes[i] : 0));
+            }
+
+            for (AX_U32 i = 0; i < SKEL_JENC_QFACTOR_HIST_NUM; i++) {
+                if (stStat.nQfactorHist[i] > 0) {
+                    ALOGN("\t\tQfactor[%d, %d]: %llu", i * 10, i * 10 + 9, (unsigned long long)stStat.nQfactorHist[i]);
+                }
+            }
+
+            return AX_SKEL_SUCC;
+        }
+
+        AX_U32 JencRate::SizeClass(AX_U32 nPixels) {
+            for (AX_U32 i = 0; i < SKEL_JENC_SIZE_CLASS_NUM - 1; i++) {
+                if (nPixels <= s_nClassPixels[i]) {
+                    return i;
+                }
+            }
+
+            return SKEL_JENC_SIZE_CLASS_NUM - 1;
+        }
+
+        AX_VOID JencRate::Roll(AX_VOID) {
+            auto now = std::chrono::steady_clock::now();
+            AX_U64 nElapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - m_slotTime).count() / SKEL_JENC_RATE_SLOT_MS;
+
+            if (nElapsed == 0) {
+                return;
+            }
+
+            m_slotTime += std::chrono::milliseconds(nElapsed * SKEL_JENC_RATE_SLOT_MS);
+
+            // one level step per finished slot, an idle gap recovers at most a window worth
+            for (AX_U64 i = 0; i < AX_MIN(nElapsed, (AX_U64)SKEL_JENC_RATE_SLOT_NUM); i++) {
+                if (m_nByteRate > 0) {
+                    AX_F32 fRatio = (AX_F32)BytesPerSec() / m_nByteRate;
+
+                    if (fRatio > 1.0f) {
+                        m_fLevel -= AX_MIN((fRatio - 1.0f) * JENC_RATE_LEVEL_DOWN_GAIN, JENC_RATE_LEVEL_DOWN_MAX);
+                    }
+                    else if (fRatio < JENC_RATE_LEVEL_UP_RATIO) {
+                        m_fLevel += JENC_RATE_LEVEL_UP;
+                    }
+
+                    m_fLevel = AX_MIN(AX_MAX(m_fLevel, 0.0f), 1.0f);
+                }
+
+                m_nSlot = (m_nSlot + 1) % SKEL_JENC_RATE_SLOT_NUM;
+                m_nSlotBytes[m_nSlot] = 0;
+            }
+        }
+
+        AX_U64 JencRate::BytesPerSec(AX_VOID) const {
+            AX_U64 nBytes = 0;
+            for (AX_U32 i = 0; i < SKEL_JENC_RATE_SLOT_NUM; i++) {
+                nBytes += m_nSlotBytes[i];
+            }
+
+            return nBytes * 1000 / (SKEL_JENC_RATE_SLOT_MS * SKEL_JENC_RATE_SLOT_NUM);
+        }
+    }
+}
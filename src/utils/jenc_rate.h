@@ -0,0 +1,80 @@
+/**************************************************************************************************
+ *
+ * Copyright (c) 2019-2023 Axera Semiconductor (Ningbo) Co., Ltd. All Rights Reserved.
+ *
+ * This source file is the property of Axera Semiconductor (Ningbo) Co., Ltd. and
+ * may not be copied or distributed in any isomorphic form without the prior
+ * written consent of Axera Semiconductor (Ningbo) Co., Ltd.
+ *
+ **************************************************************************************************/
+
+#ifndef SKEL_JENC_RATE_H
+#define SKEL_JENC_RATE_H
+
+#include <mutex>
+#include <chrono>
+
+#include "api/ax_skel_def.h"
+#include "ax_skel_type.h"
+
+namespace skel {
+    namespace utils {
+        #define SKEL_JENC_RATE_SLOT_MS 250
+        #define SKEL_JENC_RATE_SLOT_NUM 4           // the rate is measured over the last second
+        #define SKEL_JENC_QFACTOR_MIN 20
+        #define SKEL_JENC_QFACTOR_STEP 5            // Qfactor is a channel param, coarse steps switch the channels less
+        #define SKEL_JENC_BACKLOG_FREE 1            // batches a stream may have waiting before its quality drops
+        #define SKEL_JENC_SIZE_CLASS_NUM 4
+        #define SKEL_JENC_QFACTOR_HIST_NUM 10
+
+        typedef struct axSKEL_JENC_RATE_STAT_T {
+            AX_U32 nByteRate;                       // target bytes/s, 0: the configured Qfactor always
+            AX_U64 nBytesPerSec;                    // measured over the last second
+            AX_F32 fLevel;                          // 1: the configured Qfactor, 0: SKEL_JENC_QFACTOR_MIN
+            AX_U64 nEncodes[SKEL_JENC_SIZE_CLASS_NUM];
+            AX_U64 nBytes[SKEL_JENC_SIZE_CLASS_NUM];
+            AX_U64 nQfactorHist[SKEL_JENC_QFACTOR_HIST_NUM];   // encodes by Qfactor / 10
+        } AX_SKEL_JENC_RATE_STAT_T;
+
+        // jpeg output rate control of one handle. the quality level falls fast while the bytes of the
+        // last second are over the target and climbs back slowly. large images give up quality first,
+        // and a stream with encodes backed up gives it up on top, so a burst costs quality, not latency
+        class JencRate {
+        public:
+            JencRate(AX_VOID);
+
+            // un-copyable or moveable
+            JencRate(const JencRate&) = delete;
+            JencRate& operator = (const JencRate&) = delete;
+
+        public:
+            AX_VOID Configure(AX_U32 nByteRate, AX_U32 nQfactor);
+            // Qfactor for an encode of nPixels, nBacklog batches of the stream wait for the encoder
+            AX_U32 Qfactor(AX_U32 nPixels, AX_U32 nBacklog);
+            AX_VOID Account(AX_U32 nPixels, AX_U32 nQfactor, AX_U32 nBytes);
+            AX_VOID Stat(AX_SKEL_JENC_RATE_STAT_T &stStat);
+            AX_S32 Statistics(AX_VOID);
+
+        private:
+            static AX_U32 SizeClass(AX_U32 nPixels);
+            AX_VOID Roll(AX_VOID);
+            AX_U64 BytesPerSec(AX_VOID) const;
+
+        private:
+            std::mutex m_mtx;
+            AX_U32 m_nByteRate{0};
+            AX_U32 m_nQfactor{DEFAULT_QPLEVEL};
+            AX_F32 m_fLevel{1.0f};
+
+            std::chrono::steady_clock::time_point m_slotTime;
+            AX_U32 m_nSlot{0};
+            AX_U64 m_nSlotBytes[SKEL_JENC_RATE_SLOT_NUM];
+
+            AX_U64 m_nEncodes[SKEL_JENC_SIZE_CLASS_NUM];
+            AX_U64 m_nBytes[SKEL_JENC_SIZE_CLASS_NUM];
+            AX_U64 m_nQfactorHist[SKEL_JENC_QFACTOR_HIST_NUM];
+        };
+    }
+}
+
+#endif //SKEL_JENC_RATE_H
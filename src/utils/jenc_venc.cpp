@@ -0,0 +1,486 @@
+/**************************************************************************************************
+ *
+ * Copyright (c) 2019-2023 Axera Semiconductor (Ningbo) Co., Ltd. All Rights Reserved.
+ *
+ * This source file is the property of Axera Semiconductor (Ningbo) Co., Ltd. and
+ * may not be copied or distributed in any isomorphic form without the prior
+ * written consent of Axera Semiconductor (Ningbo) Co., Ltd.
+ *
+ **************************************************************************************************/
+
+#include <string.h>
+#include <deque>
+
+#include "utils/jenc_venc.h"
+#include "utils/logger.h"
+
+static AX_S32 CreateJenc(VENC_CHN nJencChn, AX_U32 nWidth, AX_U32 nHeight, AX_U32 nQpLevel) {
+    AX_VENC_CHN_ATTR_T stVencChnAttr;
+    memset(&stVencChnAttr, 0, sizeof(AX_VENC_CHN_ATTR_T));
+
+    stVencChnAttr.stVencAttr.enMemSource = AX_MEMORY_SOURCE_CMM;
+
+    stVencChnAttr.stVencAttr.u32MaxPicWidth = MAX_JENC_PIC_WIDTH;
+    stVencChnAttr.stVencAttr.u32MaxPicHeight = MAX_JENC_PIC_HEIGHT;
+
+    stVencChnAttr.stVencAttr.u32PicWidthSrc = nWidth;
+    stVencChnAttr.stVencAttr.u32PicHeightSrc = nHeight;
+
+    stVencChnAttr.stVencAttr.u32BufSize = nWidth * nHeight * 3 / 4; /*stream buffer size*/
+
+    stVencChnAttr.stVencAttr.u8InFifoDepth = SKEL_VENC_FIFO_DEPTH;  /* depth of input fifo */
+    stVencChnAttr.stVencAttr.u8OutFifoDepth = SKEL_VENC_FIFO_DEPTH; /* depth of output fifo */
+
+    stVencChnAttr.stVencAttr.enLinkMode = AX_VENC_UNLINK_MODE;
+
+    stVencChnAttr.stVencAttr.enType = PT_JPEG;
+
+    auto nRet = AX_VENC_CreateChn(nJencChn, &stVencChnAttr);
+
+    if (nRet != 0) {
+        ALOGE("SKEL AX_VENC_CreateChn[%d](%d X %d, size=%d) fail, ret=0x%x", nJencChn, nWidth, nHeight, stVencChnAttr.stVencAttr.u32BufSize, nRet);
+        return -1;
+    }
+
+    AX_VENC_JPEG_PARAM_T stJpegParam;
+    memset(&stJpegParam, 0, sizeof(AX_VENC_JPEG_PARAM_T));
+    nRet = AX_VENC_GetJpegParam(nJencChn, &stJpegParam);
+    if (nRet != 0) {
+        ALOGE("SKEL AX_VENC_GetJpegParam[%d] fail", nJencChn, nRet);
+        return AX_ERR_SKEL_ILLEGAL_PARAM;
+    }
+
+    stJpegParam.u32Qfactor = nQpLevel;
+
+    nRet = AX_VENC_SetJpegParam(nJencChn, &stJpegParam);
+    if (nRet != 0){
+        ALOGE("AX_VENC_SetJpegParam[%d] fail", nJencChn, nRet);
+        return AX_ERR_SKEL_ILLEGAL_PARAM;
+    }
+
+    AX_VENC_RECV_PIC_PARAM_T tRecvParam;
+    memset(&tRecvParam, 0x00, sizeof(tRecvParam));
+    nRet = AX_VENC_StartRecvFrame(nJencChn, &tRecvParam);
+
+    if (nRet != 0) {
+        ALOGE("SKEL AX_VENC_StartRecvFrame[%d] fail, nRet=0x%x", nJencChn, nRet);
+        return AX_ERR_SKEL_ILLEGAL_PARAM;
+    }
+
+    return AX_SKEL_SUCC;
+}
+
+namespace skel {
+    namespace utils {
+        VencJenc::VencJenc(BufferPool &stBufPool) : JencBackend(stBufPool) {
+        }
+
+        VencJenc::~VencJenc(AX_VOID) {
+            Close();
+        }
+
+        AX_S32 VencJenc::Open(AX_U32 nWidth, AX_U32 nHeight) {
+            std::lock_guard<std::mutex> lck(m_mtx);
+
+            if (!m_vecChns.empty()) {
+                return AX_SKEL_SUCC;
+            }
+
+            AX_U32 nChnNum = SKEL_VENC_CHN_NUM_DEFAULT;
+            const char *strSkelVencNumEnvStr = getenv(SKEL_VENC_CHN_NUM_ENV_STR);
+            if (strSkelVencNumEnvStr) {
+                nChnNum = (AX_U32)atoi(strSkelVencNumEnvStr);
+            }
+
+            if (nChnNum == 0) {
+                nChnNum = 1;
+            }
+            else if (nChnNum > SKEL_VENC_CHN_NUM_MAX) {
+                nChnNum = SKEL_VENC_CHN_NUM_MAX;
+            }
+
+            const char *strSkelVencEnvStr = getenv(SKEL_VENC_CHN_ENV_STR);
+            if (strSkelVencEnvStr) {
+                m_nPushJencChn = (VENC_CHN)atoi(strSkelVencEnvStr);
+            }
+
+            // the application may have the venc module initialized already, then it deinits it too
+            AX_VENC_MOD_ATTR_T stVencModAttr;
+            memset(&stVencModAttr, 0x00, sizeof(stVencModAttr));
+            stVencModAttr.enVencType = AX_VENC_MULTI_ENCODER;
+            stVencModAttr.stModThdAttr.u32TotalThreadNum = nChnNum;
+            stVencModAttr.stModThdAttr.bExplicitSched = AX_FALSE;
+            m_bVencInited = (AX_VENC_Init(&stVencModAttr) == 0) ? AX_TRUE : AX_FALSE;
+
+            for (AX_U32 i = 0; i < nChnNum; i++) {
+                VENC_CHN nChn = m_nPushJencChn + (VENC_CHN)i;
+
+                if (CreateJenc(nChn, nWidth, nHeight, SKEL_VENC_QPLEVEL_DEFAULT) != 0) {
+                    // the channel is taken, go on with the ones created
+                    ALOGW("SKEL jenc channel[%d] unavailable, %d channels created", nChn, i);
+                    break;
+                }
+
+                std::unique_ptr<AX_SKEL_JENC_CHN_T> pChn(new AX_SKEL_JENC_CHN_T());
+                pChn->nChn = nChn;
+                m_vecChns.emplace_back(std::move(pChn));
+            }
+
+            if (m_vecChns.empty()) {
+                if (m_bVencInited) {
+                    AX_VENC_Deinit();
+                    m_bVencInited = AX_FALSE;
+                }
+
+                return AX_ERR_SKEL_ILLEGAL_PARAM;
+            }
+
+            m_nWidth = nWidth;
+            m_nHeight = nHeight;
+            m_nNextChn = 0;
+
+            return AX_SKEL_SUCC;
+        }
+
+        AX_VOID VencJenc::Close(AX_VOID) {
+            std::lock_guard<std::mutex> lck(m_mtx);
+
+            for (auto &pChn : m_vecChns) {
+                AX_VENC_StopRecvFrame(pChn->nChn);
+                AX_VENC_DestroyChn(pChn->nChn);
+            }
+
+            m_vecChns.clear();
+
+            if (m_bVencInited) {
+                AX_VENC_Deinit();
+                m_bVencInited = AX_FALSE;
+            }
+        }
+
+        AX_S32 VencJenc::Encode(const AX_VIDEO_FRAME_T &stFrame, std::vector<AX_SKEL_JENC_REGION_T> &vecRegions,
+                                const std::vector<size_t> &vecIndex, AX_U32 nQpLevel) {
+            std::vector<AX_VIDEO_FRAME_INFO_T> vecFrames(vecIndex.size());
+            std::vector<AX_U64> vecSeqs(vecIndex.size(), 0);
+
+            for (size_t i = 0; i < vecIndex.size(); i++) {
+                AX_SKEL_JENC_REGION_T &stRegion = vecRegions[vecIndex[i]];
+                const AX_VIDEO_FRAME_T &stSrc = stRegion.pFrame ? *stRegion.pFrame : stFrame;
+
+                // the channels are created for this size, the stream buffer is no larger
+                if (stSrc.u32Width * stSrc.u32Height > m_nWidth * m_nHeight) {
+                    ALOGE("not match for input size(%dx%d), init(%dx%d)",
+                          stSrc.u32Width, stSrc.u32Height, m_nWidth, m_nHeight);
+                    stRegion.nRet = AX_ERR_SKEL_ILLEGAL_PARAM;
+                    continue;
+                }
+
+                stRegion.nRet = Prepare(stSrc, stRegion.stRect, stRegion.nDstWidth, stRegion.nDstHeight, vecFrames[i]);
+            }
+
+            AX_SKEL_JENC_CHN_T *pChn = nullptr;
+            {
+                std::lock_guard<std::mutex> lck(m_mtx);
+
+                if (m_vecChns.empty()) {
+                    return AX_ERR_SKEL_NOT_INIT;
+                }
+
+                pChn = Dispatch(nQpLevel);
+            }
+
+            // the regions go to one channel back to back, fetched while the fifo is full.
+            // only block on a full fifo with nothing of ours in it, or we wait for ourselves
+            std::deque<size_t> queSent;
+            for (size_t i = 0; i < vecIndex.size(); i++) {
+                AX_SKEL_JENC_REGION_T &stRegion = vecRegions[vecIndex[i]];
+                if (stRegion.nRet != AX_SKEL_SUCC) {
+                    continue;
+                }
+
+                while (1) {
+                    stRegion.nRet = Send(pChn, vecFrames[i], nQpLevel, queSent.empty() ? AX_TRUE : AX_FALSE, vecSeqs[i]);
+
+                    if (stRegion.nRet != AX_ERR_SKEL_QUEUE_FULL) {
+                        break;
+                    }
+
+                    AX_SKEL_JENC_REGION_T &stSent = vecRegions[vecIndex[queSent.front()]];
+                    stSent.nRet = Fetch(pChn, vecSeqs[queSent.front()], &stSent.pBuf, &stSent.nBufSize);
+                    queSent.pop_front();
+                }
+
+                if (stRegion.nRet == AX_SKEL_SUCC) {
+                    queSent.push_back(i);
+                }
+            }
+
+            while (!queSent.empty()) {
+                AX_SKEL_JENC_REGION_T &stSent = vecRegions[vecIndex[queSent.front()]];
+                stSent.nRet = Fetch(pChn, vecSeqs[queSent.front()], &stSent.pBuf, &stSent.nBufSize);
+                queSent.pop_front();
+            }
+
+            {
+                std::lock_guard<std::mutex> lck(m_mtx);
+                pChn->nLoad --;
+            }
+
+            return AX_SKEL_SUCC;
+        }
+
+        AX_BOOL VencJenc::Saturated(AX_VOID) {
+            std::lock_guard<std::mutex> lck(m_mtx);
+
+            for (auto &pChn : m_vecChns) {
+                if (pChn->nLoad < SKEL_VENC_SATURATED_LOAD) {
+                    return AX_FALSE;
+                }
+            }
+
+            return AX_TRUE;
+        }
+
+        AX_VOID VencJenc::Statistics(AX_VOID) {
+            std::lock_guard<std::mutex> lck(m_mtx);
+
+            ALOGN("\tVenc: %d channels, Size: %dx%d", (AX_U32)m_vecChns.size(), m_nWidth, m_nHeight);
+            for (auto &pChn : m_vecChns) {
+                ALOGN("\t\tChn[%d]: (Q: %d, L: %d, F: %d, G: %llu, S: %llu, R: %llu)",
+                      pChn->nChn, (AX_U32)pChn->nQpLevel, pChn->nLoad, pChn->nInFlight,
+                      (unsigned long long)pChn->nGetTimes, (unsigned long long)pChn->nQpSwitchTimes,
+                      (unsigned long long)pChn->nResetTimes);
+            }
+        }
+
+        AX_SKEL_JENC_CHN_T* VencJenc::Dispatch(AX_U32 nQpLevel) {
+            // least loaded, a channel set to nQpLevel already wins a tie, round robin otherwise
+            AX_U32 nChnNum = (AX_U32)m_vecChns.size();
+            AX_SKEL_JENC_CHN_T *pBest = nullptr;
+
+            for (AX_U32 i = 0; i < nChnNum; i++) {
+                AX_SKEL_JENC_CHN_T *pChn = m_vecChns[(m_nNextChn + i) % nChnNum].get();
+
+                if (!pBest
+                    || pChn->nLoad < pBest->nLoad
+                    || (pChn->nLoad == pBest->nLoad && pChn->nQpLevel == nQpLevel && pBest->nQpLevel != nQpLevel)) {
+                    pBest = pChn;
+                }
+            }
+
+            m_nNextChn = (m_nNextChn + 1) % nChnNum;
+            pBest->nLoad ++;
+
+            return pBest;
+        }
+
+        AX_S32 VencJenc::Send(AX_SKEL_JENC_CHN_T *pChn, const AX_VIDEO_FRAME_INFO_T &tFrame, AX_U32 nQpLevel, AX_BOOL bWait, AX_U64 &nSeq) {
+            std::unique_lock<std::mutex> lck(pChn->mtx);
+
+            // Qfactor is a channel param, it is switched once the frames sent with the old one are got back
+            auto ready = [pChn, nQpLevel] {
+                return pChn->nInFlight < SKEL_VENC_FIFO_DEPTH
+                       && (pChn->nQpLevel == nQpLevel || pChn->nInFlight == 0);
+            };
+
+            if (!bWait && !ready()) {
+                return AX_ERR_SKEL_QUEUE_FULL;
+            }
+
+            pChn->cv.wait(lck, ready);
+
+            AX_S32 nRet = AX_SKEL_SUCC;
+            if (pChn->nQpLevel != nQpLevel) {
+                AX_VENC_JPEG_PARAM_T stJpegParam;
+                memset(&stJpegParam, 0, sizeof(AX_VENC_JPEG_PARAM_T));
+                nRet = AX_VENC_GetJpegParam(pChn->nChn, &stJpegParam);
+                if (nRet != 0) {
+                    ALOGE("SKEL AX_VENC_GetJpegParam[%d] fail, nRet=0x%x", pChn->nChn, nRet);
+                    return AX_ERR_SKEL_ILLEGAL_PARAM;
+                }
+
+                stJpegParam.u32Qfactor = nQpLevel;
+
+                nRet = AX_VENC_SetJpegParam(pChn->nChn, &stJpegParam);
+                if (nRet != 0) {
+                    ALOGE("SKEL AX_VENC_SetJpegParam[%d] fail, nRet=0x%x", pChn->nChn, nRet);
+                    return AX_ERR_SKEL_ILLEGAL_PARAM;
+                }
+
+                pChn->nQpLevel = nQpLevel;
+                pChn->nQpSwitchTimes ++;
+            }
+
+            nRet = AX_VENC_SendFrame(pChn->nChn, &tFrame, 2000);
+
+            if (nRet != 0) {
+                ALOGE("SKEL AX_VENC_SendFrame[%d] fail, nRet=0x%x", pChn->nChn, nRet);
+                return AX_ERR_SKEL_ILLEGAL_PARAM;
+            }
+
+            nSeq = pChn->nSendSeq ++;
+            pChn->nInFlight ++;
+
+            return AX_SKEL_SUCC;
+        }
+
+        AX_S32 VencJenc::Fetch(AX_SKEL_JENC_CHN_T *pChn, AX_U64 nSeq, AX_VOID **ppBuf, AX_U32 *pBufSize) {
+            AX_S32 nRet = AX_SKEL_SUCC;
+            AX_BOOL bDropped = AX_FALSE;
+
+            // streams come out in send order
+            {
+                std::unique_lock<std::mutex> lck(pChn->mtx);
+                pChn->cv.wait(lck, [pChn, nSeq] {
+                    return pChn->nGetSeq == nSeq;
+                });
+
+                bDropped = (nSeq < pChn->nResetSeq) ? AX_TRUE : AX_FALSE;
+            }
+
+            AX_VENC_STREAM_T stVencStream;
+            memset(&stVencStream, 0x00, sizeof(stVencStream));
+
+            AX_S32 nGetRet = bDropped ? AX_ERR_SKEL_ILLEGAL_PARAM : AX_VENC_GetStream(pChn->nChn, &stVencStream, 2000);
+
+            if (bDropped) {
+                // its stream went with the resync, no GetStream for it
+                nRet = AX_ERR_SKEL_ILLEGAL_PARAM;
+            }
+            else if (nGetRet != 0) {
+                // the stream of nSeq may still come and be taken for the next one, start over
+                ALOGE("SKEL AX_VENC_GetStream[%d] fail, ret=0x%x", pChn->nChn, nGetRet);
+                Resync(pChn);
+                nRet = AX_ERR_SKEL_ILLEGAL_PARAM;
+            }
+            else if (!stVencStream.stPack.pu8Addr
+                     || stVencStream.stPack.u32Len == 0) {
+                ALOGE("SKEL AX_VENC_GetStream[%d] empty stream", pChn->nChn);
+                nRet = AX_ERR_SKEL_ILLEGAL_PARAM;
+            }
+            else {
+                // straight into a pooled buffer, the stream is given back to the channel at once
+                *ppBuf = m_BufPool.Alloc(stVencStream.stPack.u32Len);
+
+                if (!(*ppBuf)) {
+                    *pBufSize = 0;
+
+                    ALOGE("SKEL alloc push buffer fail");
+                    nRet = AX_ERR_SKEL_NOMEM;
+                }
+                else {
+                    *pBufSize = stVencStream.stPack.u32Len;
+                    memcpy(*ppBuf, stVencStream.stPack.pu8Addr, stVencStream.stPack.u32Len);
+                }
+            }
+
+            if (nGetRet == 0) {
+                AX_VENC_ReleaseStream(pChn->nChn, &stVencStream);
+            }
+
+            {
+                std::lock_guard<std::mutex> lck(pChn->mtx);
+                pChn->nGetSeq ++;
+                pChn->nInFlight --;
+                if (nRet == AX_SKEL_SUCC) {
+                    pChn->nGetTimes ++;
+                }
+            }
+            pChn->cv.notify_all();
+
+            return nRet;
+        }
+
+        AX_VOID VencJenc::Resync(AX_SKEL_JENC_CHN_T *pChn) {
+            // no frame is sent meanwhile, every one sent so far is given up and fails on its Fetch
+            std::lock_guard<std::mutex> lck(pChn->mtx);
+
+            AX_VENC_StopRecvFrame(pChn->nChn);
+
+            AX_S32 nRet = AX_VENC_ResetChn(pChn->nChn);
+            if (nRet != 0) {
+                ALOGE("SKEL AX_VENC_ResetChn[%d] fail, nRet=0x%x", pChn->nChn, nRet);
+            }
+
+            AX_VENC_RECV_PIC_PARAM_T tRecvParam;
+            memset(&tRecvParam, 0x00, sizeof(tRecvParam));
+            nRet = AX_VENC_StartRecvFrame(pChn->nChn, &tRecvParam);
+            if (nRet != 0) {
+                ALOGE("SKEL AX_VENC_StartRecvFrame[%d] fail, nRet=0x%x", pChn->nChn, nRet);
+            }
+
+            pChn->nResetSeq = pChn->nSendSeq;
+            pChn->nResetTimes ++;
+        }
+
+        AX_S32 VencJenc::Prepare(const AX_VIDEO_FRAME_T &stFrame, AX_SKEL_RECT_T &stRect, AX_U32 &nDstWidth, AX_U32 &nDstHeight, AX_VIDEO_FRAME_INFO_T &tFrame) {
+            memset(&tFrame, 0x00, sizeof(tFrame));
+            tFrame.stVFrame = stFrame;
+            tFrame.stVFrame.u64PhyAddr[1] = tFrame.stVFrame.u64PhyAddr[0] + tFrame.stVFrame.u32PicStride[0] * tFrame.stVFrame.u32Height;
+            tFrame.stVFrame.u32PicStride[1] = tFrame.stVFrame.u32PicStride[0];
+            tFrame.stVFrame.u32PicStride[2] = 0;
+
+            // crop
+            if ((AX_U32)stRect.fX != 0
+                || (AX_U32)stRect.fY != 0
+                || (AX_U32)stRect.fW != 0
+                || (AX_U32)stRect.fH != 0) {
+                if (stRect.fX < 0) {
+                    stRect.fX = 0;
+                }
+
+                if (stRect.fY < 0) {
+                    stRect.fY = 0;
+                }
+
+                tFrame.stVFrame.s16CropX = ALIGN_DOWN((AX_S16)stRect.fX, 2);
+                tFrame.stVFrame.s16CropY = ALIGN_DOWN((AX_S16)stRect.fY, 2);
+                tFrame.stVFrame.s16CropWidth = ALIGN_DOWN((AX_S16)stRect.fW, 2);
+                tFrame.stVFrame.s16CropHeight = ALIGN_DOWN((AX_S16)stRect.fH, 2);
+
+                if (tFrame.stVFrame.s16CropX + tFrame.stVFrame.s16CropWidth > (AX_S32)tFrame.stVFrame.u32Width) {
+                    tFrame.stVFrame.s16CropWidth = ALIGN_DOWN(tFrame.stVFrame.u32Width - tFrame.stVFrame.s16CropX, 2);
+                }
+
+                if (tFrame.stVFrame.s16CropY + tFrame.stVFrame.s16CropHeight > (AX_S32)tFrame.stVFrame.u32Height) {
+                    tFrame.stVFrame.s16CropHeight = ALIGN_DOWN(tFrame.stVFrame.u32Height - tFrame.stVFrame.s16CropY, 2);
+                }
+
+                nDstWidth = tFrame.stVFrame.s16CropWidth;
+                nDstHeight = tFrame.stVFrame.s16CropHeight;
+
+                // FIXME.
+                if (nDstWidth < SKEL_VENC_MIN_WIDTH) {
+                    nDstWidth = SKEL_VENC_MIN_WIDTH;
+                    tFrame.stVFrame.s16CropWidth = SKEL_VENC_MIN_WIDTH;
+                    if (tFrame.stVFrame.s16CropX + tFrame.stVFrame.s16CropWidth > (AX_S32)tFrame.stVFrame.u32Width) {
+                        tFrame.stVFrame.s16CropX = tFrame.stVFrame.u32Width - tFrame.stVFrame.s16CropWidth - 2;
+                    }
+                }
+                if (nDstHeight < SKEL_VENC_MIN_HEIGHT) {
+                    nDstHeight = SKEL_VENC_MIN_HEIGHT;
+                    tFrame.stVFrame.s16CropHeight = SKEL_VENC_MIN_HEIGHT;
+                    if (tFrame.stVFrame.s16CropY + tFrame.stVFrame.s16CropHeight > (AX_S32)tFrame.stVFrame.u32Height) {
+                        tFrame.stVFrame.s16CropY = tFrame.stVFrame.u32Height - tFrame.stVFrame.s16CropHeight - 2;
+                    }
+                }
+
+                if (tFrame.stVFrame.s16CropX + tFrame.stVFrame.s16CropWidth > (AX_S32)tFrame.stVFrame.u32Width
+                    || tFrame.stVFrame.s16CropY + tFrame.stVFrame.s16CropHeight > (AX_S32)tFrame.stVFrame.u32Height) {
+                    ALOGE("SKEL ignore the region[%d,%d,%d,%d]",
+                          tFrame.stVFrame.s16CropX,
+                          tFrame.stVFrame.s16CropY,
+                          tFrame.stVFrame.s16CropWidth,
+                          tFrame.stVFrame.s16CropHeight);
+                    return AX_ERR_SKEL_ILLEGAL_PARAM;
+                }
+            }
+            else {
+                nDstWidth = tFrame.stVFrame.u32Width;
+                nDstHeight = tFrame.stVFrame.u32Height;
+            }
+
+            return AX_SKEL_SUCC;
+        }
+    }
+}
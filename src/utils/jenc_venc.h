@@ -0,0 +1,104 @@
+/**************************************************************************************************
+ *
+ * Copyright (c) 2019-2023 Axera Semiconductor (Ningbo) Co., Ltd. All Rights Reserved.
+ *
+ * This source file is the property of Axera Semiconductor (Ningbo) Co., Ltd. and
+ * may not be copied or distributed in any isomorphic form without the prior
+ * written consent of Axera Semiconductor (Ningbo) Co., Ltd.
+ *
+ **************************************************************************************************/
+
+#ifndef SKEL_JENC_VENC_H
+#define SKEL_JENC_VENC_H
+
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <condition_variable>
+#include <atomic>
+
+#include "utils/jenc_backend.h"
+#include "ax_venc_api.h"
+
+namespace skel {
+    namespace utils {
+        #define SKEL_VENC_CHN_ENV_STR "SKEL_VENC_CHN_SET"
+        #define SKEL_VENC_CHN_DEFAULT 9
+        #define SKEL_VENC_CHN_NUM_ENV_STR "SKEL_VENC_CHN_NUM_SET"
+        #define SKEL_VENC_CHN_NUM_DEFAULT 2
+        #define SKEL_VENC_CHN_NUM_MAX 16
+        #define SKEL_VENC_FIFO_DEPTH 4
+        #define SKEL_VENC_QPLEVEL_DEFAULT 75
+        #define SKEL_VENC_MIN_WIDTH 32
+        #define SKEL_VENC_MIN_HEIGHT 32
+        #define SKEL_VENC_SATURATED_LOAD 2      // batches on every channel from which the venc is saturated
+
+        // one VENC jpeg channel of the pool. frames are sent up to SKEL_VENC_FIFO_DEPTH deep and
+        // their streams are got back in send order
+        typedef struct axSKEL_JENC_CHN_T {
+            VENC_CHN nChn;
+            std::atomic<AX_U32> nQpLevel;       // Qfactor the channel is set to, read by the dispatch
+            AX_U32 nInFlight;                   // sent, stream not got yet
+            AX_U32 nLoad;                       // jobs dispatched to the channel and not done
+            AX_U64 nSendSeq;
+            AX_U64 nGetSeq;
+            AX_U64 nResetSeq;                   // frames sent before it were dropped by a resync
+            AX_U64 nGetTimes;
+            AX_U64 nQpSwitchTimes;
+            AX_U64 nResetTimes;
+            std::mutex mtx;
+            std::condition_variable cv;
+
+            axSKEL_JENC_CHN_T() {
+                nChn = 0;
+                nQpLevel = SKEL_VENC_QPLEVEL_DEFAULT;
+                nInFlight = 0;
+                nLoad = 0;
+                nSendSeq = 0;
+                nGetSeq = 0;
+                nResetSeq = 0;
+                nGetTimes = 0;
+                nQpSwitchTimes = 0;
+                nResetTimes = 0;
+            }
+        } AX_SKEL_JENC_CHN_T;
+
+        // the hardware jpeg encoder, a pool of VENC channels. regions under
+        // SKEL_VENC_MIN_WIDTH x SKEL_VENC_MIN_HEIGHT are enlarged to it
+        class VencJenc : public JencBackend {
+        public:
+            explicit VencJenc(BufferPool &stBufPool);
+            virtual ~VencJenc(AX_VOID);
+
+        public:
+            virtual const AX_CHAR* Name(AX_VOID) const override {
+                return "venc";
+            }
+
+            virtual AX_S32 Open(AX_U32 nWidth, AX_U32 nHeight) override;
+            virtual AX_VOID Close(AX_VOID) override;
+            virtual AX_S32 Encode(const AX_VIDEO_FRAME_T &stFrame, std::vector<AX_SKEL_JENC_REGION_T> &vecRegions,
+                                  const std::vector<size_t> &vecIndex, AX_U32 nQpLevel) override;
+            virtual AX_BOOL Saturated(AX_VOID) override;
+            virtual AX_VOID Statistics(AX_VOID) override;
+
+        private:
+            AX_S32 Prepare(const AX_VIDEO_FRAME_T &stFrame, AX_SKEL_RECT_T &stRect, AX_U32 &nDstWidth, AX_U32 &nDstHeight, AX_VIDEO_FRAME_INFO_T &tFrame);
+            AX_SKEL_JENC_CHN_T* Dispatch(AX_U32 nQpLevel);
+            AX_S32 Send(AX_SKEL_JENC_CHN_T *pChn, const AX_VIDEO_FRAME_INFO_T &tFrame, AX_U32 nQpLevel, AX_BOOL bWait, AX_U64 &nSeq);
+            AX_S32 Fetch(AX_SKEL_JENC_CHN_T *pChn, AX_U64 nSeq, AX_VOID **ppBuf, AX_U32 *pBufSize);
+            AX_VOID Resync(AX_SKEL_JENC_CHN_T *pChn);
+
+        private:
+            std::mutex m_mtx;
+            AX_U32 m_nWidth{0};
+            AX_U32 m_nHeight{0};
+            AX_BOOL m_bVencInited{AX_FALSE};  // AX_VENC_Init done here, not by the application
+            VENC_CHN m_nPushJencChn{SKEL_VENC_CHN_DEFAULT};
+            AX_U32 m_nNextChn{0};
+            std::vector<std::unique_ptr<AX_SKEL_JENC_CHN_T>> m_vecChns;
+        };
+    }
+}
+
+#endif //SKEL_JENC_VENC_H
@@ -0,0 +1,142 @@
+/**************************************************************************************************
+ *
+ * Copyright (c) 2019-2023 Axera Semiconductor (Ningbo) Co., Ltd. All Rights Reserved.
+ *
+ * This source file is the property of Axera Semiconductor (Ningbo) Co., Ltd. and
+ * may not be copied or distributed in any isomorphic form without the prior
+ * written consent of Axera Semiconductor (Ningbo) Co., Ltd.
+ *
+ **************************************************************************************************/
+
+#ifndef SKEL_PARAM_SNAPSHOT_H
+#define SKEL_PARAM_SNAPSHOT_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "api/ax_skel_def.h"
+
+namespace skel {
+    namespace utils {
+        typedef enum {
+            SKEL_LABEL_BODY = 0,
+            SKEL_LABEL_VEHICLE,
+            SKEL_LABEL_CYCLE,
+            SKEL_LABEL_FACE,
+            SKEL_LABEL_PLATE,
+            SKEL_LABEL_MAX
+        } SKEL_LABEL_E;
+
+        static const AX_CHAR *const SKEL_LABEL_NAMES[SKEL_LABEL_MAX] = {
+                "body", "vehicle", "cycle", "face", "plate"
+        };
+
+        // -1 if the label is unknown
+        inline AX_S32 LabelIndex(const AX_CHAR *pstrLabel) {
+            if (!pstrLabel) {
+                return -1;
+            }
+
+            for (AX_S32 i = 0; i < SKEL_LABEL_MAX; i++) {
+                if (strcmp(pstrLabel, SKEL_LABEL_NAMES[i]) == 0) {
+                    return i;
+                }
+            }
+
+            return -1;
+        }
+
+        inline std::vector<AX_S32> LabelIndex(const std::vector<std::string> &vecLabels) {
+            std::vector<AX_S32> vecIndex;
+            for (auto &strLabel : vecLabels) {
+                vecIndex.push_back(LabelIndex(strLabel.c_str()));
+            }
+
+            return vecIndex;
+        }
+
+        typedef struct axSKEL_LABEL_CONFIG_T {
+            AX_BOOL bWant;
+            AX_U32 nMaxTargetCount;             // 0: no limit
+            AX_SKEL_FILTER_CONFIG_T stFilter;
+            AX_SKEL_ATTR_FILTER_CONFIG_T stAttrFilter;
+        } AX_SKEL_LABEL_CONFIG_T;
+
+        // AX_SKEL_PARAM_T compiled once per SetConfig into per label arrays, never modified afterwards,
+        // so readers need no lock and no string lookups
+        class ParamSnapshot {
+        public:
+            explicit ParamSnapshot(const AX_SKEL_PARAM_T &stParam) : m_stParam(stParam), m_stLabels(), m_stUnknownLabel() {
+                for (AX_S32 i = 0; i < SKEL_LABEL_MAX; i++) {
+                    std::string strLabel = SKEL_LABEL_NAMES[i];
+                    auto &stLabel = m_stLabels[i];
+
+                    stLabel.bWant = (stParam.stWantClasses.empty()
+                                     || std::find(stParam.stWantClasses.begin(), stParam.stWantClasses.end(), strLabel) != stParam.stWantClasses.end())
+                                    ? AX_TRUE : AX_FALSE;
+
+                    auto iterFilter = stParam.stFilterMaps.find(strLabel);
+                    if (iterFilter != stParam.stFilterMaps.end()) {
+                        stLabel.stFilter = iterFilter->second;
+                    }
+
+                    auto iterAttr = stParam.stAttrFliterMaps.find(strLabel);
+                    if (iterAttr != stParam.stAttrFliterMaps.end()) {
+                        stLabel.stAttrFilter = iterAttr->second;
+                    }
+                }
+
+                m_stLabels[SKEL_LABEL_BODY].nMaxTargetCount = stParam.stMaxTargetCount.nBodyTargetCount;
+                m_stLabels[SKEL_LABEL_VEHICLE].nMaxTargetCount = stParam.stMaxTargetCount.nVehicleTargetCount;
+                m_stLabels[SKEL_LABEL_CYCLE].nMaxTargetCount = stParam.stMaxTargetCount.nCycleTargetCount;
+
+                m_stUnknownLabel.bWant = stParam.stWantClasses.empty() ? AX_TRUE : AX_FALSE;
+            }
+
+            inline const AX_SKEL_PARAM_T& Param() const {
+                return m_stParam;
+            }
+
+            inline const AX_SKEL_LABEL_CONFIG_T& Label(AX_S32 nLabel) const {
+                return (nLabel >= 0 && nLabel < SKEL_LABEL_MAX) ? m_stLabels[nLabel] : m_stUnknownLabel;
+            }
+
+        private:
+            AX_SKEL_PARAM_T m_stParam;
+            AX_SKEL_LABEL_CONFIG_T m_stLabels[SKEL_LABEL_MAX];
+            AX_SKEL_LABEL_CONFIG_T m_stUnknownLabel;
+        };
+
+        typedef std::shared_ptr<const ParamSnapshot> ParamSnapshotPtr;
+
+        // Publishes ParamSnapshot RCU style: writers build a new snapshot and swap the pointer,
+        // readers keep the one they loaded until they drop the reference
+        class ParamPublisher {
+        public:
+            ParamPublisher() = default;
+
+            explicit ParamPublisher(const AX_SKEL_PARAM_T &stParam) {
+                Store(stParam);
+            }
+
+            // un-copyable or moveable
+            ParamPublisher(const ParamPublisher&) = delete;
+            ParamPublisher& operator = (const ParamPublisher&) = delete;
+
+            inline ParamSnapshotPtr Load() const {
+                return std::atomic_load(&m_pSnapshot);
+            }
+
+            inline AX_VOID Store(const AX_SKEL_PARAM_T &stParam) {
+                std::atomic_store(&m_pSnapshot, ParamSnapshotPtr(std::make_shared<ParamSnapshot>(stParam)));
+            }
+
+        private:
+            ParamSnapshotPtr m_pSnapshot;
+        };
+    }
+}
+
+#endif //SKEL_PARAM_SNAPSHOT_H
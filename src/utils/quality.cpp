@@ -0,0 +1,168 @@
+/**************************************************************************************************
+ *
+ * Copyright (c) 2019-2023 Axera Semiconductor (Ningbo) Co., Ltd. All Rights Reserved.
+ *
+ * This source file is the property of Axera Semiconductor (Ningbo) Co., Ltd. and
+ * may not be copied or distributed in any isomorphic form without the prior
+ * written consent of Axera Semiconductor (Ningbo) Co., Ltd.
+ *
+ **************************************************************************************************/
+
+#include <math.h>
+#include <algorithm>
+
+#include "utils/quality.h"
+#include "utils/param_snapshot.h"
+#include "ax_sys_api.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+// w / h usually seen for SKEL_LABEL_E
+static const AX_F32 s_fAspectDefault[skel::utils::SKEL_LABEL_MAX] = {
+        0.4f, // body
+        1.3f, // vehicle
+        0.6f, // cycle
+        0.8f, // face
+        3.0f  // plate
+};
+
+#define QUALITY_FULL_SIZE 128           // sqrt(area) from which size no longer counts
+#define QUALITY_BORDER_MARGIN 2         // a box this close to the border is truncated
+#define QUALITY_BORDER_PENALTY 0.15f    // per truncated edge
+#define QUALITY_SHARP_KNEE 100.0f       // laplacian variance scored 0.5
+
+// sum and sum of squares of the 4-neighbour laplacian over the inner pixels of a nWidth x nHeight plane
+static AX_VOID LaplacianMoments(const AX_U8 *pPlane, AX_U32 nWidth, AX_U32 nHeight, AX_F64 &fSum, AX_F64 &fSqSum) {
+    fSum = 0;
+    fSqSum = 0;
+
+    for (AX_U32 y = 1; y + 1 < nHeight; y++) {
+        const AX_U8 *pUp = pPlane + (y - 1) * nWidth;
+        const AX_U8 *pRow = pPlane + y * nWidth;
+        const AX_U8 *pDown = pPlane + (y + 1) * nWidth;
+        AX_U32 x = 1;
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+        int32x4_t vSum = vdupq_n_s32(0);
+        uint32x4_t vSqSum = vdupq_n_u32(0);
+
+        for (; x + 8 < nWidth; x += 8) {
+            int16x8_t vCenter = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(pRow + x)));
+            uint16x8_t vNear = vaddl_u8(vld1_u8(pRow + x - 1), vld1_u8(pRow + x + 1));
+            vNear = vaddq_u16(vNear, vaddl_u8(vld1_u8(pUp + x), vld1_u8(pDown + x)));
+
+            // |lap| <= 1020 fits s16, lap^2 fits u32
+            int16x8_t vLap = vsubq_s16(vshlq_n_s16(vCenter, 2), vreinterpretq_s16_u16(vNear));
+            vSum = vpadalq_s16(vSum, vLap);
+
+            uint16x8_t vAbs = vreinterpretq_u16_s16(vabsq_s16(vLap));
+            vSqSum = vmlal_u16(vSqSum, vget_low_u16(vAbs), vget_low_u16(vAbs));
+            vSqSum = vmlal_u16(vSqSum, vget_high_u16(vAbs), vget_high_u16(vAbs));
+        }
+
+        fSum += (AX_F64)(vgetq_lane_s32(vSum, 0) + vgetq_lane_s32(vSum, 1) + vgetq_lane_s32(vSum, 2) + vgetq_lane_s32(vSum, 3));
+        fSqSum += (AX_F64)vgetq_lane_u32(vSqSum, 0) + (AX_F64)vgetq_lane_u32(vSqSum, 1)
+                  + (AX_F64)vgetq_lane_u32(vSqSum, 2) + (AX_F64)vgetq_lane_u32(vSqSum, 3);
+#endif
+
+        for (; x + 1 < nWidth; x++) {
+            AX_S32 nLap = 4 * (AX_S32)pRow[x] - pRow[x - 1] - pRow[x + 1] - pUp[x] - pDown[x];
+            fSum += nLap;
+            fSqSum += (AX_F64)(nLap * nLap);
+        }
+    }
+}
+
+namespace skel {
+    namespace utils {
+        AX_F32 QualityBound(const AX_VIDEO_FRAME_T &stFrame, const AX_SKEL_RECT_T &stRect, AX_S32 nLabel, AX_F32 fConfidence) {
+            if (stRect.fW <= 0 || stRect.fH <= 0) {
+                return 0;
+            }
+
+            // size
+            AX_F32 fSize = std::min(1.0f, sqrtf(stRect.fW * stRect.fH) / QUALITY_FULL_SIZE);
+
+            // truncation
+            AX_U32 nEdges = 0;
+            if (stRect.fX <= QUALITY_BORDER_MARGIN) {
+                nEdges ++;
+            }
+            if (stRect.fY <= QUALITY_BORDER_MARGIN) {
+                nEdges ++;
+            }
+            if (stFrame.u32Width > 0 && stRect.fX + stRect.fW >= (AX_F32)stFrame.u32Width - QUALITY_BORDER_MARGIN) {
+                nEdges ++;
+            }
+            if (stFrame.u32Height > 0 && stRect.fY + stRect.fH >= (AX_F32)stFrame.u32Height - QUALITY_BORDER_MARGIN) {
+                nEdges ++;
+            }
+            AX_F32 fTruncation = 1 - QUALITY_BORDER_PENALTY * nEdges;
+
+            // aspect
+            AX_F32 fAspect = 1;
+            if (nLabel >= 0 && nLabel < SKEL_LABEL_MAX) {
+                AX_F32 fRatio = (stRect.fW / stRect.fH) / s_fAspectDefault[nLabel];
+                fAspect = std::min(fRatio, 1 / fRatio);
+            }
+
+            return fConfidence * fSize * fTruncation * fAspect;
+        }
+
+        AX_F32 Sharpness(const AX_VIDEO_FRAME_T &stFrame, const AX_SKEL_RECT_T &stRect) {
+            const AX_U8 *pY = (const AX_U8 *)stFrame.u64VirAddr[0];
+            if (!pY && stFrame.u32BlkId[0] > 0) {
+                pY = (const AX_U8 *)AX_POOL_GetBlockVirAddr(stFrame.u32BlkId[0]);
+            }
+
+            if (!pY || stFrame.u32PicStride[0] == 0) {
+                return -1;
+            }
+
+            AX_S32 x0 = std::max(0, (AX_S32)stRect.fX);
+            AX_S32 y0 = std::max(0, (AX_S32)stRect.fY);
+            AX_S32 x1 = std::min((AX_S32)stFrame.u32Width, (AX_S32)(stRect.fX + stRect.fW));
+            AX_S32 y1 = std::min((AX_S32)stFrame.u32Height, (AX_S32)(stRect.fY + stRect.fH));
+
+            if (x1 - x0 < 3 || y1 - y0 < 3) {
+                return 0;
+            }
+
+            // point sample down to SKEL_QUALITY_SAMPLE_SIZE, keeping the aspect
+            AX_U32 nStep = (AX_U32)std::max(x1 - x0, y1 - y0) / SKEL_QUALITY_SAMPLE_SIZE + 1;
+            AX_U32 nWidth = (AX_U32)(x1 - x0) / nStep;
+            AX_U32 nHeight = (AX_U32)(y1 - y0) / nStep;
+
+            if (nWidth < 3 || nHeight < 3) {
+                return 0;
+            }
+
+            AX_U8 aSample[SKEL_QUALITY_SAMPLE_SIZE * SKEL_QUALITY_SAMPLE_SIZE];
+            for (AX_U32 y = 0; y < nHeight; y++) {
+                const AX_U8 *pSrc = pY + (AX_U64)(y0 + y * nStep) * stFrame.u32PicStride[0] + x0;
+                AX_U8 *pDst = aSample + y * nWidth;
+
+                if (nStep == 1) {
+                    memcpy(pDst, pSrc, nWidth);
+                }
+                else {
+                    for (AX_U32 x = 0; x < nWidth; x++) {
+                        pDst[x] = pSrc[x * nStep];
+                    }
+                }
+            }
+
+            AX_F64 fSum = 0;
+            AX_F64 fSqSum = 0;
+            LaplacianMoments(aSample, nWidth, nHeight, fSum, fSqSum);
+
+            AX_F64 fCount = (AX_F64)(nWidth - 2) * (nHeight - 2);
+            AX_F64 fMean = fSum / fCount;
+            AX_F64 fVariance = fSqSum / fCount - fMean * fMean;
+
+            return (AX_F32)(fVariance / (fVariance + QUALITY_SHARP_KNEE));
+        }
+    }
+}
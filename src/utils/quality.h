@@ -0,0 +1,40 @@
+/**************************************************************************************************
+ *
+ * Copyright (c) 2019-2023 Axera Semiconductor (Ningbo) Co., Ltd. All Rights Reserved.
+ *
+ * This source file is the property of Axera Semiconductor (Ningbo) Co., Ltd. and
+ * may not be copied or distributed in any isomorphic form without the prior
+ * written consent of Axera Semiconductor (Ningbo) Co., Ltd.
+ *
+ **************************************************************************************************/
+
+#ifndef SKEL_QUALITY_H
+#define SKEL_QUALITY_H
+
+#include "api/ax_skel_def.h"
+#include "ax_skel_type.h"
+
+namespace skel {
+    namespace utils {
+        #define SKEL_QUALITY_SAMPLE_SIZE 64     // the crop is point sampled down to at most this square
+        #define SKEL_QUALITY_SHARP_FLOOR 0.3f   // weight of a totally blurred crop
+
+        // best shot score without the pixels: confidence scaled by size, truncation at the frame border
+        // and aspect against what is usual for the label. an upper bound of QualityScore
+        AX_F32 QualityBound(const AX_VIDEO_FRAME_T &stFrame, const AX_SKEL_RECT_T &stRect, AX_S32 nLabel, AX_F32 fConfidence);
+
+        // laplacian variance of the Y plane in stRect on a downsampled crop, mapped to [0, 1).
+        // -1 if the frame is not mapped for the cpu
+        AX_F32 Sharpness(const AX_VIDEO_FRAME_T &stFrame, const AX_SKEL_RECT_T &stRect);
+
+        inline AX_F32 QualityScore(AX_F32 fBound, AX_F32 fSharpness) {
+            if (fSharpness < 0) {
+                return fBound;
+            }
+
+            return fBound * (SKEL_QUALITY_SHARP_FLOOR + (1 - SKEL_QUALITY_SHARP_FLOOR) * fSharpness);
+        }
+    }
+}
+
+#endif //SKEL_QUALITY_H
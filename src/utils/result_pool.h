@@ -0,0 +1,196 @@
+/**************************************************************************************************
+ *
+ * Copyright (c) 2019-2023 Axera Semiconductor (Ningbo) Co., Ltd. All Rights Reserved.
+ *
+ * This source file is the property of Axera Semiconductor (Ningbo) Co., Ltd. and
+ * may not be copied or distributed in any isomorphic form without the prior
+ * written consent of Axera Semiconductor (Ningbo) Co., Ltd.
+ *
+ **************************************************************************************************/
+
+#ifndef SKEL_RESULT_POOL_H
+#define SKEL_RESULT_POOL_H
+
+#include <atomic>
+#include <string.h>
+
+#include "api/ax_skel_def.h"
+#include "ax_skel_type.h"
+#include "utils/size_class_pool.h"
+
+enum SKEL_MEM_TYPE {
+    AX_SKEL_MEM_RESULT = 0,
+    AX_SKEL_MEM_MAX
+};
+
+namespace skel {
+    namespace utils {
+        #define SKEL_RESULT_MAGIC_INNER 0x534B4C49      // "SKLI", held by the library
+        #define SKEL_RESULT_MAGIC_USER 0x534B4C55       // "SKLU", handed out to be AX_SKEL_Release-d
+        #define SKEL_RESULT_MAGIC_FREE 0x00000000
+
+        // Size classed pool of results. A result is one block: the AX_SKEL_RESULT_T, then its object
+        // items, point sets and cache list, so it is walked in one sweep and freed in one call. Freed
+        // blocks go back to the free list of their class, at most nClassCache per class, larger ones
+        // come from the heap. A block knows its pool, the owner Detach-es the pool instead of deleting
+        // it and the pool goes with the last block outstanding: the owner holds one count of m_nUsed
+        // and each block one, whoever drops the last deletes the pool. The header of a block also
+        // carries a magic telling who owns the result, a best effort check of the pointers from the
+        // user: releasing a result twice is undefined. Thread safe.
+        class ResultPool {
+        public:
+            explicit ResultPool(AX_U32 nMinSize = 2048, AX_U32 nClassNum = 8, AX_U32 nClassCache = 16) :
+                    m_Blocks(nMinSize, nClassNum, nClassCache) {
+
+            }
+
+            // un-copyable or moveable
+            ResultPool(const ResultPool&) = delete;
+            ResultPool& operator = (const ResultPool&) = delete;
+
+            // a zeroed result with nObjectSize items and room for nCacheListSize cache entries,
+            // nCacheListSize is left 0 to be counted up. nullptr if out of memory
+            AX_SKEL_RESULT_T* Alloc(AX_U32 nObjectSize, AX_U32 nPointSetSize = 0, AX_U32 nCacheListSize = 0) {
+                AX_U32 nPointSetOffset = ObjectOffset() + ALIGN_UP(nObjectSize * (AX_U32)sizeof(AX_SKEL_OBJECT_ITEM_T), BLOCK_ALIGN);
+                AX_U32 nCacheListOffset = nPointSetOffset + ALIGN_UP(nPointSetSize * (AX_U32)sizeof(AX_SKEL_POINT_SET_S), BLOCK_ALIGN);
+                AX_U32 nSize = nCacheListOffset + nCacheListSize * (AX_U32)sizeof(AX_SKEL_FRAME_CACHE_LIST_T);
+
+                // the owner's count keeps the pool alive, Alloc is never called after Detach
+                m_nUsed.fetch_add(1, std::memory_order_relaxed);
+
+                Blocks::Block *pEntry = m_Blocks.Get(nSize);
+                if (!pEntry) {
+                    Free(nullptr);
+                    return nullptr;
+                }
+
+                Header *pHeader = &pEntry->stExt;
+                pHeader->nType = AX_SKEL_MEM_RESULT;
+                pHeader->pPool = this;
+                pHeader->nPointSetSize = nPointSetSize;
+                pHeader->nMagic = SKEL_RESULT_MAGIC_INNER;
+
+                AX_U8 *pBlock = Blocks::Payload(pEntry);
+                memset(pBlock, 0x00, nSize);
+
+                auto *pstResult = reinterpret_cast<AX_SKEL_RESULT_T*>(pBlock);
+                pstResult->nObjectSize = nObjectSize;
+                if (nObjectSize > 0) {
+                    pstResult->pstObjectItems = reinterpret_cast<AX_SKEL_OBJECT_ITEM_T*>(pBlock + ObjectOffset());
+                }
+                if (nPointSetSize > 0) {
+                    pHeader->pstPointSet = reinterpret_cast<AX_SKEL_POINT_SET_S*>(pBlock + nPointSetOffset);
+                }
+                else {
+                    pHeader->pstPointSet = nullptr;
+                }
+                if (nCacheListSize > 0) {
+                    pstResult->pstCacheList = reinterpret_cast<AX_SKEL_FRAME_CACHE_LIST_T*>(pBlock + nCacheListOffset);
+                }
+
+                return pstResult;
+            }
+
+            // the nPointSetSize point sets of the block, handed to the items by the caller
+            static AX_SKEL_POINT_SET_S* PointSets(AX_SKEL_RESULT_T *pstResult) {
+                return Of(pstResult)->pstPointSet;
+            }
+
+            // the user owns the result from now on, TakeFromUser gets it back
+            static AX_VOID GiveToUser(AX_SKEL_RESULT_T *pstResult) {
+                if (pstResult) {
+                    Of(pstResult)->nMagic = SKEL_RESULT_MAGIC_USER;
+                }
+            }
+
+            // p back from the user, nullptr if its header says it is not held by the user.
+            // only a result given to the user and not taken back yet is defined: the header in front of p
+            // is read, a block freed to the heap may be gone and a block cached by the pool may have been
+            // given to the user again, so a second release of the same result may release another one
+            static AX_SKEL_RESULT_T* TakeFromUser(AX_VOID *p) {
+                if (!p) {
+                    return nullptr;
+                }
+
+                auto *pstResult = static_cast<AX_SKEL_RESULT_T*>(p);
+                Header *pHeader = Of(pstResult);
+
+                // a result given to a callback is never taken back
+                AX_U32 nMagic = SKEL_RESULT_MAGIC_USER;
+                if (!pHeader->nMagic.compare_exchange_strong(nMagic, SKEL_RESULT_MAGIC_INNER)
+                    || pHeader->nType != AX_SKEL_MEM_RESULT) {
+                    return nullptr;
+                }
+
+                return pstResult;
+            }
+
+            // back to the pool the result came from
+            static AX_VOID Release(AX_SKEL_RESULT_T *pstResult) {
+                if (pstResult) {
+                    Of(pstResult)->nMagic = SKEL_RESULT_MAGIC_FREE;
+                    Of(pstResult)->pPool->Free(Blocks::Of(pstResult));
+                }
+            }
+
+            // the owner is done with the pool, results still outstanding keep it until released
+            AX_VOID Detach(AX_VOID) {
+                Drop();
+            }
+
+            // results outstanding, the owner's count aside
+            AX_U32 Used(AX_VOID) {
+                return m_nUsed.load(std::memory_order_relaxed) - 1;
+            }
+
+            AX_U32 Cached(AX_VOID) {
+                return m_Blocks.Cached();
+            }
+
+        private:
+            struct Header {
+                std::atomic<AX_U32> nMagic;     // SKEL_RESULT_MAGIC_*
+                AX_U32 nType;                   // SKEL_MEM_TYPE
+                ResultPool *pPool;
+                AX_U32 nPointSetSize;
+                AX_SKEL_POINT_SET_S *pstPointSet;
+            };
+
+            using Blocks = SizeClassPool<Header>;
+
+            // the payload of a block is 16 bytes aligned, so is every part of the result
+            static constexpr AX_U32 BLOCK_ALIGN = 16;
+
+            ~ResultPool() = default;
+
+            static inline AX_U32 ObjectOffset(AX_VOID) {
+                return ALIGN_UP((AX_U32)sizeof(AX_SKEL_RESULT_T), BLOCK_ALIGN);
+            }
+
+            // pEntry nullptr only drops the count of a failed Alloc. the block goes back before the count
+            // drops, a Detach-ed pool may be deleted as soon as it does
+            AX_VOID Free(Blocks::Block *pEntry) {
+                m_Blocks.Put(pEntry);
+                Drop();
+            }
+
+            // the last count dropped, by the owner or a block, deletes the pool. acq_rel so that every
+            // Put of the other droppers is seen by the delete
+            AX_VOID Drop(AX_VOID) {
+                if (m_nUsed.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    delete this;
+                }
+            }
+
+            static inline Header* Of(AX_SKEL_RESULT_T *pstResult) {
+                return &Blocks::Of(pstResult)->stExt;
+            }
+
+        private:
+            Blocks m_Blocks;
+            std::atomic<AX_U32> m_nUsed{1};     // blocks outstanding and the owner
+        };
+    }
+}
+
+#endif //SKEL_RESULT_POOL_H
@@ -0,0 +1,159 @@
+/**************************************************************************************************
+ *
+ * Copyright (c) 2019-2023 Axera Semiconductor (Ningbo) Co., Ltd. All Rights Reserved.
+ *
+ * This source file is the property of Axera Semiconductor (Ningbo) Co., Ltd. and
+ * may not be copied or distributed in any isomorphic form without the prior
+ * written consent of Axera Semiconductor (Ningbo) Co., Ltd.
+ *
+ **************************************************************************************************/
+
+#ifndef SKEL_SIZE_CLASS_POOL_H
+#define SKEL_SIZE_CLASS_POOL_H
+
+#include <new>
+#include <mutex>
+#include <vector>
+
+#include "api/ax_skel_def.h"
+
+namespace skel {
+    namespace utils {
+        // Size classed block allocator. A block is a header holding an Ext, then a 16 bytes aligned
+        // payload. Classes double from nMinSize, a freed block goes back to the free list of its class,
+        // at most nClassCache free blocks are kept per class, and sizes beyond the last class come from
+        // the heap. Ext is value-initialized when a block is taken from the heap and left as it was when
+        // the block is reused. Thread safe.
+        template <typename Ext>
+        class SizeClassPool {
+        public:
+            struct Block {
+                Ext stExt;
+                AX_S32 nClass;                  // -1 for heap sizes
+                AX_U32 nCapacity;
+                Block *pNext;
+            };
+
+            SizeClassPool(AX_U32 nMinSize, AX_U32 nClassNum, AX_U32 nClassCache) :
+                    m_nMinSize(nMinSize),
+                    m_nClassCache(nClassCache),
+                    m_vecFree(nClassNum, nullptr),
+                    m_vecFreeCount(nClassNum, 0) {
+
+            }
+
+            // blocks still out are leaked
+            ~SizeClassPool() {
+                for (auto *pBlock : m_vecFree) {
+                    while (pBlock) {
+                        Block *pNext = pBlock->pNext;
+                        Destroy(pBlock);
+                        pBlock = pNext;
+                    }
+                }
+            }
+
+            // un-copyable or moveable
+            SizeClassPool(const SizeClassPool&) = delete;
+            SizeClassPool& operator = (const SizeClassPool&) = delete;
+
+            // a block with at least nSize bytes of payload, nullptr if out of memory
+            Block* Get(AX_U32 nSize) {
+                AX_S32 nClass = Class(nSize);
+                Block *pBlock = nullptr;
+
+                if (nClass >= 0) {
+                    std::lock_guard<std::mutex> lck(m_mtx);
+                    pBlock = m_vecFree[nClass];
+                    if (pBlock) {
+                        m_vecFree[nClass] = pBlock->pNext;
+                        m_vecFreeCount[nClass] --;
+                    }
+                }
+
+                if (!pBlock) {
+                    AX_U32 nCapacity = (nClass >= 0) ? (m_nMinSize << nClass) : nSize;
+                    AX_VOID *pMem = ::operator new(HEADER_SIZE + nCapacity, std::nothrow);
+                    if (!pMem) {
+                        return nullptr;
+                    }
+
+                    pBlock = new (pMem) Block();
+                    pBlock->nClass = nClass;
+                    pBlock->nCapacity = nCapacity;
+                }
+
+                pBlock->pNext = nullptr;
+
+                return pBlock;
+            }
+
+            // back to the free list of its class, or to the heap if that is full
+            AX_VOID Put(Block *pBlock) {
+                if (!pBlock) {
+                    return;
+                }
+
+                if (pBlock->nClass >= 0) {
+                    std::lock_guard<std::mutex> lck(m_mtx);
+                    if (m_vecFreeCount[pBlock->nClass] < m_nClassCache) {
+                        pBlock->pNext = m_vecFree[pBlock->nClass];
+                        m_vecFree[pBlock->nClass] = pBlock;
+                        m_vecFreeCount[pBlock->nClass] ++;
+                        return;
+                    }
+                }
+
+                Destroy(pBlock);
+            }
+
+            AX_U32 Cached() {
+                std::lock_guard<std::mutex> lck(m_mtx);
+                AX_U32 nCached = 0;
+                for (auto nCount : m_vecFreeCount) {
+                    nCached += nCount;
+                }
+
+                return nCached;
+            }
+
+            static inline AX_U8* Payload(Block *pBlock) {
+                return reinterpret_cast<AX_U8*>(pBlock) + HEADER_SIZE;
+            }
+
+            static inline Block* Of(AX_VOID *p) {
+                return reinterpret_cast<Block*>(static_cast<AX_U8*>(p) - HEADER_SIZE);
+            }
+
+        private:
+            // payload stays 16 bytes aligned
+            static constexpr AX_U32 HEADER_SIZE = (sizeof(Block) + 15) & ~15;
+
+            AX_S32 Class(AX_U32 nSize) const {
+                AX_U32 nCapacity = m_nMinSize;
+                for (AX_S32 i = 0; i < (AX_S32)m_vecFree.size(); i++) {
+                    if (nSize <= nCapacity) {
+                        return i;
+                    }
+                    nCapacity <<= 1;
+                }
+
+                return -1;
+            }
+
+            static AX_VOID Destroy(Block *pBlock) {
+                pBlock->~Block();
+                ::operator delete(pBlock);
+            }
+
+        private:
+            AX_U32 m_nMinSize;
+            AX_U32 m_nClassCache;
+            std::mutex m_mtx;
+            std::vector<Block*> m_vecFree;
+            std::vector<AX_U32> m_vecFreeCount;
+        };
+    }
+}
+
+#endif //SKEL_SIZE_CLASS_POOL_H
@@ -0,0 +1,223 @@
+/**************************************************************************************************
+ *
+ * Copyright (c) 2019-2023 Axera Semiconductor (Ningbo) Co., Ltd. All Rights Reserved.
+ *
+ * This source file is the property of Axera Semiconductor (Ningbo) Co., Ltd. and
+ * may not be copied or distributed in any isomorphic form without the prior
+ * written consent of Axera Semiconductor (Ningbo) Co., Ltd.
+ *
+ **************************************************************************************************/
+
+#ifndef SKEL_SLAB_POOL_H
+#define SKEL_SLAB_POOL_H
+
+#include <new>
+#include <cstddef>
+#include <vector>
+#include <utility>
+#include <type_traits>
+
+#include "api/ax_skel_def.h"
+
+namespace skel {
+    namespace utils {
+        // Fixed size object pool. Memory is taken from the heap in chunks of nChunkSize objects
+        // and only given back when the pool is destroyed, so Alloc/Free are O(1) and
+        // allocation-free once the pool has grown to the working set. Not thread safe.
+        template <typename T, AX_U32 nChunkSize = 64>
+        class SlabPool {
+        public:
+            SlabPool() = default;
+
+            // objects still allocated are not destructed
+            ~SlabPool() {
+                for (auto *pChunk : m_vecChunks) {
+                    ::operator delete(pChunk);
+                }
+            }
+
+            // un-copyable or moveable
+            SlabPool(const SlabPool&) = delete;
+            SlabPool& operator = (const SlabPool&) = delete;
+
+            template <typename... Args>
+            T* Alloc(Args&&... args) {
+                if (!m_pFree) {
+                    Grow();
+                }
+
+                Slot *pSlot = m_pFree;
+                m_pFree = pSlot->pNext;
+                m_nUsed++;
+
+                return new (&pSlot->storage) T(std::forward<Args>(args)...);
+            }
+
+            AX_VOID Free(T *p) {
+                if (!p) {
+                    return;
+                }
+
+                p->~T();
+
+                Slot *pSlot = reinterpret_cast<Slot*>(p);
+                pSlot->pNext = m_pFree;
+                m_pFree = pSlot;
+                m_nUsed--;
+            }
+
+            inline AX_U32 Used() const {
+                return m_nUsed;
+            }
+
+            inline AX_U32 Capacity() const {
+                return (AX_U32)m_vecChunks.size() * nChunkSize;
+            }
+
+        private:
+            union Slot {
+                Slot *pNext;
+                typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+            };
+
+            AX_VOID Grow(AX_VOID) {
+                Slot *pChunk = static_cast<Slot*>(::operator new(sizeof(Slot) * nChunkSize));
+                m_vecChunks.push_back(pChunk);
+
+                for (AX_U32 i = 0; i < nChunkSize; i++) {
+                    pChunk[i].pNext = m_pFree;
+                    m_pFree = &pChunk[i];
+                }
+            }
+
+        private:
+            Slot *m_pFree{nullptr};
+            AX_U32 m_nUsed{0};
+            std::vector<Slot*> m_vecChunks;
+        };
+
+        // Untyped slab of small blocks, one free list per 16 bytes size class, for the nodes of a
+        // node based container, see SlabAllocator. Blocks beyond SLAB_ARENA_MAX_SIZE come from the heap.
+        // Chunks are only given back when the arena is destroyed. Not thread safe.
+        class SlabArena {
+        public:
+            SlabArena() {
+                for (auto &pFree : m_arrFree) {
+                    pFree = nullptr;
+                }
+            }
+
+            // outlives the containers using it
+            ~SlabArena() {
+                for (auto *pChunk : m_vecChunks) {
+                    ::operator delete(pChunk);
+                }
+            }
+
+            // un-copyable or moveable
+            SlabArena(const SlabArena&) = delete;
+            SlabArena& operator = (const SlabArena&) = delete;
+
+            AX_VOID* Alloc(std::size_t nSize) {
+                if (nSize == 0 || nSize > SLAB_ARENA_MAX_SIZE) {
+                    return ::operator new(nSize);
+                }
+
+                AX_U32 nClass = (AX_U32)((nSize - 1) / SLAB_ARENA_ALIGN);
+                if (!m_arrFree[nClass]) {
+                    Grow(nClass);
+                }
+
+                Slot *pSlot = m_arrFree[nClass];
+                m_arrFree[nClass] = pSlot->pNext;
+
+                return pSlot;
+            }
+
+            AX_VOID Free(AX_VOID *p, std::size_t nSize) {
+                if (!p) {
+                    return;
+                }
+
+                if (nSize == 0 || nSize > SLAB_ARENA_MAX_SIZE) {
+                    ::operator delete(p);
+                    return;
+                }
+
+                AX_U32 nClass = (AX_U32)((nSize - 1) / SLAB_ARENA_ALIGN);
+                Slot *pSlot = static_cast<Slot*>(p);
+                pSlot->pNext = m_arrFree[nClass];
+                m_arrFree[nClass] = pSlot;
+            }
+
+        private:
+            static constexpr std::size_t SLAB_ARENA_ALIGN = 16;
+            static constexpr std::size_t SLAB_ARENA_MAX_SIZE = 128;
+            static constexpr AX_U32 SLAB_ARENA_CLASS_NUM = SLAB_ARENA_MAX_SIZE / SLAB_ARENA_ALIGN;
+            static constexpr AX_U32 SLAB_ARENA_CHUNK_SIZE = 64;
+
+            struct Slot {
+                Slot *pNext;
+            };
+
+            AX_VOID Grow(AX_U32 nClass) {
+                std::size_t nSlotSize = (nClass + 1) * SLAB_ARENA_ALIGN;
+                AX_U8 *pChunk = static_cast<AX_U8*>(::operator new(nSlotSize * SLAB_ARENA_CHUNK_SIZE));
+                m_vecChunks.push_back(pChunk);
+
+                for (AX_U32 i = 0; i < SLAB_ARENA_CHUNK_SIZE; i++) {
+                    Slot *pSlot = reinterpret_cast<Slot*>(pChunk + i * nSlotSize);
+                    pSlot->pNext = m_arrFree[nClass];
+                    m_arrFree[nClass] = pSlot;
+                }
+            }
+
+        private:
+            Slot *m_arrFree[SLAB_ARENA_CLASS_NUM];
+            std::vector<AX_U8*> m_vecChunks;
+        };
+
+        // std allocator over a SlabArena, the rebound allocators of a container share its arena
+        template <typename T>
+        class SlabAllocator {
+        public:
+            typedef T value_type;
+
+            explicit SlabAllocator(SlabArena *pArena) : m_pArena(pArena) {
+
+            }
+
+            template <typename U>
+            SlabAllocator(const SlabAllocator<U> &other) : m_pArena(other.Arena()) {
+
+            }
+
+            T* allocate(std::size_t n) {
+                return static_cast<T*>(m_pArena->Alloc(n * sizeof(T)));
+            }
+
+            AX_VOID deallocate(T *p, std::size_t n) {
+                m_pArena->Free(p, n * sizeof(T));
+            }
+
+            inline SlabArena* Arena() const {
+                return m_pArena;
+            }
+
+        private:
+            SlabArena *m_pArena;
+        };
+
+        template <typename T, typename U>
+        inline bool operator == (const SlabAllocator<T> &a, const SlabAllocator<U> &b) {
+            return a.Arena() == b.Arena();
+        }
+
+        template <typename T, typename U>
+        inline bool operator != (const SlabAllocator<T> &a, const SlabAllocator<U> &b) {
+            return a.Arena() != b.Arena();
+        }
+    }
+}
+
+#endif //SKEL_SLAB_POOL_H
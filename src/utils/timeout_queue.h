@@ -11,7 +11,9 @@
 #ifndef SKEL_TIMEOUT_QUEUE_H
 #define SKEL_TIMEOUT_QUEUE_H
 
-#include <queue>
+#include <deque>
+#include <vector>
+#include <algorithm>
 #include <mutex>
 #include <chrono>
 #include <condition_variable>
@@ -58,9 +60,16 @@ namespace skel {
                 return m_queue.size();
             }
 
+            inline bool IsClosed() {
+                std::lock_guard<std::mutex> lock(m_lock);
+                return m_closed;
+            }
+
             inline void Close() {
                 std::lock_guard<std::mutex> lock(m_lock);
+                m_closed = true;
                 m_new_item.notify_all();
+                m_has_room.notify_all();
             }
 
             AX_S32 Push(T& item, int timeout = -1) {
@@ -72,7 +81,7 @@ namespace skel {
                         auto end = start;
                         int elapsed = 0;
 
-                        while (IsFull()) {
+                        while (IsFull() && !IsClosed()) {
                             // 100us
                             std::this_thread::sleep_for(std::chrono::microseconds(100));
 
@@ -84,13 +93,90 @@ namespace skel {
                             }
                         }
                     } else {    // block
-                        while (IsFull())
+                        while (IsFull() && !IsClosed())
                             std::this_thread::sleep_for(std::chrono::microseconds(100));
                     }
                 }
 
                 std::unique_lock<std::mutex> lock(m_lock);
-                m_queue.push(item);
+                // nobody pops a closed queue any more
+                if (m_closed) {
+                    return AX_ERR_SKEL_UNEXIST;
+                }
+                m_queue.push_back(item);
+                lock.unlock();
+                m_new_item.notify_one();
+
+                return AX_SKEL_SUCC;
+            }
+
+            // pushes num items in order under one lock as long as they fit, then waits up to timeout
+            // for room for the rest. pushed is how many went in, all of them unless an error is returned
+            AX_S32 PushBatch(const T* items, size_t num, size_t& pushed, int timeout = -1) {
+                auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout > 0 ? timeout : 0);
+                std::unique_lock<std::mutex> lock(m_lock);
+                auto room = [this] {
+                    return m_max_len <= 0 || m_queue.size() < (size_t)m_max_len || m_closed;
+                };
+
+                pushed = 0;
+                while (true) {
+                    // nobody pops a closed queue any more
+                    if (m_closed) {
+                        return AX_ERR_SKEL_UNEXIST;
+                    }
+
+                    size_t last = pushed;
+                    while (pushed < num && (m_max_len <= 0 || m_queue.size() < (size_t)m_max_len)) {
+                        m_queue.push_back(items[pushed++]);
+                    }
+                    if (pushed > last) {
+                        m_new_item.notify_all();
+                    }
+
+                    if (pushed == num) {
+                        return AX_SKEL_SUCC;
+                    }
+
+                    if (timeout == 0) {
+                        return AX_ERR_SKEL_QUEUE_FULL;
+                    }
+
+                    if (timeout > 0) {
+                        if (!m_has_room.wait_until(lock, deadline, room)) {
+                            return AX_ERR_SKEL_TIMEOUT;
+                        }
+                    } else {
+                        m_has_room.wait(lock, room);
+                    }
+                }
+            }
+
+            // pushes without waiting. a full queue makes room by taking out its oldest item evictable tells
+            // may go, evicted says if one went. when none may go an evictable item is refused, any other
+            // is pushed over the capacity
+            template <typename Pred>
+            AX_S32 PushEvict(T& item, Pred evictable, T& dropped, bool& evicted) {
+                std::unique_lock<std::mutex> lock(m_lock);
+                evicted = false;
+                if (m_closed) {
+                    return AX_ERR_SKEL_UNEXIST;
+                }
+
+                if (m_max_len > 0 && m_queue.size() >= (size_t)m_max_len) {
+                    // the oldest evictable one is taken out in place, the others stay where they are
+                    auto it = std::find_if(m_queue.begin(), m_queue.end(), evictable);
+                    if (it != m_queue.end()) {
+                        dropped = *it;
+                        m_queue.erase(it);
+                        evicted = true;
+                    }
+                    else if (evictable(item)) {
+                        return AX_ERR_SKEL_QUEUE_FULL;
+                    }
+                }
+
+                m_queue.push_back(item);
                 lock.unlock();
                 m_new_item.notify_one();
 
@@ -106,7 +192,7 @@ namespace skel {
                         auto end = start;
                         int elapsed = 0;
 
-                        while (IsEmpty()) {
+                        while (IsEmpty() && !IsClosed()) {
                             // 100us
                             std::this_thread::sleep_for(std::chrono::microseconds(100));
 
@@ -118,10 +204,10 @@ namespace skel {
                             }
                         }
                     } else {
-                        if (IsEmpty()) {
-                            std::unique_lock<std::mutex> lock(m_lock);
-                            m_new_item.wait(lock);
-                        }
+                        std::unique_lock<std::mutex> lock(m_lock);
+                        m_new_item.wait(lock, [this] {
+                            return !m_queue.empty() || m_closed;
+                        });
 
                     }
                 }
@@ -132,15 +218,73 @@ namespace skel {
                 }
 
                 item = m_queue.front();
-                m_queue.pop();
+                m_queue.pop_front();
+                m_has_room.notify_all();
+                return AX_SKEL_SUCC;
+            }
+
+            // waits like Pop for the first item, then takes up to max_num items under one lock
+            AX_S32 PopBatch(std::vector<T>& items, size_t max_num, int timeout = -1) {
+                std::unique_lock<std::mutex> lock(m_lock);
+                auto ready = [this] {
+                    return !m_queue.empty() || m_closed;
+                };
+
+                if (timeout > 0) {
+                    if (!m_new_item.wait_for(lock, std::chrono::milliseconds(timeout), ready)) {
+                        return AX_ERR_SKEL_TIMEOUT;
+                    }
+                } else if (timeout < 0) {
+                    m_new_item.wait(lock, ready);
+                }
+
+                if (m_queue.empty()) {
+                    return AX_ERR_SKEL_QUEUE_EMPTY;
+                }
+
+                for (size_t i = 0; i < max_num && !m_queue.empty(); i++) {
+                    items.push_back(m_queue.front());
+                    m_queue.pop_front();
+                }
+                m_has_room.notify_all();
+
                 return AX_SKEL_SUCC;
             }
 
+            // take out every queued item matching pred, the order of the others is kept
+            template <typename Pred>
+            size_t Remove(Pred pred, std::vector<T>& removed) {
+                std::lock_guard<std::mutex> lock(m_lock);
+                size_t count = 0;
+
+                auto kept = m_queue.begin();
+                for (auto it = m_queue.begin(); it != m_queue.end(); ++it) {
+                    if (pred(*it)) {
+                        removed.push_back(*it);
+                        count++;
+                    }
+                    else {
+                        if (kept != it) {
+                            *kept = *it;
+                        }
+                        ++kept;
+                    }
+                }
+
+                m_queue.erase(kept, m_queue.end());
+                if (count > 0) {
+                    m_has_room.notify_all();
+                }
+                return count;
+            }
+
         protected:
             int m_max_len;
-            std::queue<T> m_queue;
+            std::deque<T> m_queue;
             std::mutex m_lock;
             std::condition_variable m_new_item;
+            std::condition_variable m_has_room;     // for PushBatch, Push still polls
+            bool m_closed{false};
         };
     }
 }
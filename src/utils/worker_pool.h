@@ -0,0 +1,212 @@
+/**************************************************************************************************
+ *
+ * Copyright (c) 2019-2023 Axera Semiconductor (Ningbo) Co., Ltd. All Rights Reserved.
+ *
+ * This source file is the property of Axera Semiconductor (Ningbo) Co., Ltd. and
+ * may not be copied or distributed in any isomorphic form without the prior
+ * written consent of Axera Semiconductor (Ningbo) Co., Ltd.
+ *
+ **************************************************************************************************/
+
+#ifndef SKEL_WORKER_POOL_H
+#define SKEL_WORKER_POOL_H
+
+#include <deque>
+#include <mutex>
+#include <chrono>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <thread>
+#include <functional>
+#include <condition_variable>
+
+#include "api/ax_skel_def.h"
+#include "utils/logger.h"
+
+namespace skel {
+    namespace utils {
+        // Fixed set of worker threads, each one owns a bounded task queue.
+        // Tasks submitted with the same key always land on the same worker,
+        // so they run in submission order; different keys run concurrently.
+        class WorkerPool {
+        public:
+            typedef std::function<AX_VOID(AX_VOID)> TaskType;
+
+            explicit WorkerPool(AX_U32 nQueueDepth = SKEL_DEFAULT_QUEUE_LEN):
+                    m_nQueueDepth(nQueueDepth),
+                    m_bRunning(false),
+                    m_nSubmitting(0) {
+
+            }
+
+            ~WorkerPool() {
+                Stop();
+            }
+
+            // un-copyable or moveable
+            WorkerPool(const WorkerPool&) = delete;
+            WorkerPool& operator = (const WorkerPool&) = delete;
+
+            inline AX_U32 Size() {
+                std::lock_guard<std::mutex> lck(m_mtxWorkers);
+                return (AX_U32)m_vecWorkers.size();
+            }
+
+            inline AX_VOID SetCapacity(AX_U32 nQueueDepth) {
+                m_nQueueDepth = nQueueDepth;
+            }
+
+            AX_S32 Start(AX_U32 nWorkerNum) {
+                std::lock_guard<std::mutex> lck(m_mtxWorkers);
+                if (m_bRunning) {
+                    ALOGE("worker pool is still running!\n");
+                    return AX_ERR_SKEL_INITED;
+                }
+
+                if (nWorkerNum == 0) {
+                    nWorkerNum = 1;
+                }
+
+                m_bRunning = true;
+
+                for (AX_U32 i = 0; i < nWorkerNum; i++) {
+                    m_vecWorkers.emplace_back(new Worker());
+                }
+
+                for (auto &worker : m_vecWorkers) {
+                    Worker *pWorker = worker.get();
+                    pWorker->thread = std::thread([this, pWorker] {
+                        Loop(pWorker);
+                    });
+                }
+
+                return AX_SKEL_SUCC;
+            }
+
+            // pending tasks are still executed before the workers exit, submits in progress return first
+            AX_VOID Stop(AX_VOID) {
+                std::unique_lock<std::mutex> lckWorkers(m_mtxWorkers);
+                if (!m_bRunning) {
+                    return;
+                }
+
+                m_bRunning = false;
+
+                for (auto &worker : m_vecWorkers) {
+                    std::lock_guard<std::mutex> lck(worker->mtx);
+                    worker->cvPop.notify_all();
+                    worker->cvPush.notify_all();
+                }
+
+                // a submit past its check still uses its worker
+                m_cvSubmitting.wait(lckWorkers, [this] {
+                    return m_nSubmitting == 0;
+                });
+
+                // joined unlocked, a task still running may submit, it is refused
+                std::vector<std::unique_ptr<Worker>> vecWorkers;
+                vecWorkers.swap(m_vecWorkers);
+                lckWorkers.unlock();
+
+                for (auto &worker : vecWorkers) {
+                    if (worker->thread.joinable()) {
+                        worker->thread.join();
+                    }
+                }
+            }
+
+            AX_S32 Submit(AX_U32 nKey, const TaskType &task, AX_S32 nTimeout = -1) {
+                Worker *pWorker = nullptr;
+                {
+                    std::lock_guard<std::mutex> lckWorkers(m_mtxWorkers);
+                    if (!m_bRunning || m_vecWorkers.empty()) {
+                        return AX_ERR_SKEL_NOT_INIT;
+                    }
+
+                    pWorker = m_vecWorkers[nKey % m_vecWorkers.size()].get();
+                    m_nSubmitting ++;
+                }
+                SubmitGuard guard(this);
+
+                std::unique_lock<std::mutex> lck(pWorker->mtx);
+                auto not_full = [this, pWorker] {
+                    return !m_bRunning || pWorker->tasks.size() < m_nQueueDepth;
+                };
+
+                if (nTimeout < 0) {
+                    pWorker->cvPush.wait(lck, not_full);
+                }
+                else if (!pWorker->cvPush.wait_for(lck, std::chrono::milliseconds(nTimeout), not_full)) {
+                    return (nTimeout == 0) ? AX_ERR_SKEL_QUEUE_FULL : AX_ERR_SKEL_TIMEOUT;
+                }
+
+                if (!m_bRunning) {
+                    return AX_ERR_SKEL_UNEXIST;
+                }
+
+                pWorker->tasks.push_back(task);
+                lck.unlock();
+                pWorker->cvPop.notify_one();
+
+                return AX_SKEL_SUCC;
+            }
+
+        private:
+            struct Worker {
+                std::mutex mtx;
+                std::condition_variable cvPop;
+                std::condition_variable cvPush;
+                std::deque<TaskType> tasks;
+                std::thread thread;
+            };
+
+            // Stop waits for the submits holding a worker
+            class SubmitGuard {
+            public:
+                explicit SubmitGuard(WorkerPool *pPool) : m_pPool(pPool) {}
+                ~SubmitGuard() {
+                    std::lock_guard<std::mutex> lck(m_pPool->m_mtxWorkers);
+                    if (-- m_pPool->m_nSubmitting == 0) {
+                        m_pPool->m_cvSubmitting.notify_all();
+                    }
+                }
+
+            private:
+                WorkerPool *m_pPool;
+            };
+
+            AX_VOID Loop(Worker *pWorker) {
+                while (1) {
+                    TaskType task;
+                    {
+                        std::unique_lock<std::mutex> lck(pWorker->mtx);
+                        pWorker->cvPop.wait(lck, [this, pWorker] {
+                            return !m_bRunning || !pWorker->tasks.empty();
+                        });
+
+                        if (pWorker->tasks.empty()) {
+                            break;
+                        }
+
+                        task = std::move(pWorker->tasks.front());
+                        pWorker->tasks.pop_front();
+                    }
+                    pWorker->cvPush.notify_one();
+
+                    task();
+                }
+            }
+
+        private:
+            AX_U32 m_nQueueDepth;
+            std::atomic<bool> m_bRunning;
+            std::mutex m_mtxWorkers;                // guards m_vecWorkers and m_nSubmitting
+            std::condition_variable m_cvSubmitting;
+            AX_U32 m_nSubmitting;
+            std::vector<std::unique_ptr<Worker>> m_vecWorkers;
+        };
+    }
+}
+
+#endif //SKEL_WORKER_POOL_H